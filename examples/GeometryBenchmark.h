@@ -0,0 +1,97 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_XAMPL_GEOMETRYBENCHMARK_H
+#define THREEPP_XAMPL_GEOMETRYBENCHMARK_H
+
+#include <chrono>
+#include <QObject>
+#include <QDebug>
+#include <threepp/geometry/Sphere.h>
+#include <threepp/util/Parallel.h>
+
+namespace three {
+namespace quick {
+
+/**
+ * measures the BufferGeometry attribute computations on a sphere with 1, 2, 4 .. threads, up to the
+ * hardware threads. With the default of 1000 segments, the sphere has 1M vertices and 2M triangles
+ */
+class GeometryBenchmark : public QObject
+{
+Q_OBJECT
+  Q_PROPERTY(int segments READ segments WRITE setSegments NOTIFY segmentsChanged)
+
+  int _segments = 1000;
+
+  int segments() const {return _segments;}
+
+  void setSegments(int segments)
+  {
+    if(_segments != segments) {
+      _segments = segments;
+      emit segmentsChanged();
+    }
+  }
+
+  template <typename Func>
+  static double measure(int iterations, Func func)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; i++) func();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+  }
+
+public:
+  GeometryBenchmark(QObject *parent=nullptr) : QObject(parent) {}
+
+  /**
+   * run each computation the given number of times at each thread count
+   *
+   * @return the average time of computeVertexNormals with all hardware threads in milliseconds
+   */
+  Q_INVOKABLE float run(int iterations=10)
+  {
+    if(_segments < 3 || iterations <= 0) return 0;
+
+    geometry::buffer::Sphere::Ptr sphere = geometry::buffer::Sphere::make(1, (unsigned)_segments, (unsigned)_segments);
+    BufferGeometry &geometry = *sphere;
+
+    //the bounds are computed through the public Geometry interface
+    Geometry &base = geometry;
+
+    qDebug() << "geometry benchmark:" << geometry.position()->itemCount() << "vertices,"
+             << geometry.index()->size() / 3 << "triangles";
+
+    unsigned previous = parallel::concurrency(), hardware = parallel::hardwareConcurrency();
+    double normals = 0;
+
+    for(unsigned threads = 1; ; threads = std::min(threads * 2, hardware)) {
+      parallel::setConcurrency(threads);
+
+      normals = measure(iterations, [&]() {geometry.computeVertexNormals();});
+      double box = measure(iterations, [&]() {base.computeBoundingBox();});
+      double bounds = measure(iterations, [&]() {base.computeBoundingSphere();});
+      double tangents = measure(iterations, [&]() {geometry.computeTangents();});
+
+      qDebug() << threads << "threads: normals" << normals << "ms, bounding box" << box
+               << "ms, bounding sphere" << bounds << "ms, tangents" << tangents << "ms";
+
+      if(threads == hardware) break;
+    }
+    parallel::setConcurrency(previous);
+
+    return (float)normals;
+  }
+
+signals:
+  void segmentsChanged();
+};
+
+}
+}
+
+#endif //THREEPP_XAMPL_GEOMETRYBENCHMARK_H
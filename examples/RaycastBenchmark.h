@@ -0,0 +1,108 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_XAMPL_RAYCASTBENCHMARK_H
+#define THREEPP_XAMPL_RAYCASTBENCHMARK_H
+
+#include <chrono>
+#include <QObject>
+#include <QDebug>
+#include <threepp/quick/scene/Scene.h>
+#include <threepp/core/BatchRaycaster.h>
+
+namespace three {
+namespace quick {
+
+/**
+ * measures batched raycasting throughput against the current scene. Rays are cast through a regular
+ * grid covering the scene camera's view
+ */
+class RaycastBenchmark : public QObject
+{
+Q_OBJECT
+  Q_PROPERTY(Scene *scene READ scene WRITE setScene NOTIFY sceneChanged)
+  Q_PROPERTY(int resolution READ resolution WRITE setResolution NOTIFY resolutionChanged)
+
+  Scene *_scene = nullptr;
+  int _resolution = 256;
+
+  three::BatchRaycaster _raycaster;
+
+  Scene *scene() const {return _scene;}
+  int resolution() const {return _resolution;}
+
+  void setScene(Scene *scene)
+  {
+    if(_scene != scene) {
+      _scene = scene;
+      emit sceneChanged();
+    }
+  }
+
+  void setResolution(int resolution)
+  {
+    if(_resolution != resolution) {
+      _resolution = resolution;
+      emit resolutionChanged();
+    }
+  }
+
+public:
+  RaycastBenchmark(QObject *parent=nullptr) : QObject(parent) {}
+
+  /**
+   * cast resolution x resolution rays the given number of times
+   *
+   * @return the number of rays per second
+   */
+  Q_INVOKABLE float run(int iterations=10)
+  {
+    if(!_scene || !_scene->camera() || _resolution <= 0) return 0;
+
+    three::Camera::Ptr camera = _scene->camera();
+    _scene->scene()->updateMatrixWorld(false);
+
+    std::vector<math::Ray> rays;
+    rays.reserve(_resolution * _resolution);
+    for(int y = 0; y < _resolution; y++) {
+      for(int x = 0; x < _resolution; x++) {
+        float nx = (x + 0.5f) / _resolution * 2 - 1;
+        float ny = (y + 0.5f) / _resolution * 2 - 1;
+        rays.push_back(camera->ray(nx, ny));
+      }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    _raycaster.update(_scene->scene()->children());
+    auto prepared = std::chrono::steady_clock::now();
+
+    std::vector<Intersection> hits;
+    for(int i = 0; i < iterations; i++) _raycaster.intersect(rays, hits);
+
+    auto end = std::chrono::steady_clock::now();
+
+    size_t hitCount = 0;
+    for(const auto &hit : hits) if(hit.object) hitCount++;
+
+    double seconds = std::chrono::duration<double>(end - prepared).count();
+    float raysPerSecond = seconds > 0 ? (float)(rays.size() * iterations / seconds) : 0;
+
+    qDebug() << "raycast benchmark:" << rays.size() << "rays," << hitCount << "hits,"
+             << _raycaster.index().size() << "objects, update"
+             << std::chrono::duration<double, std::milli>(prepared - start).count() << "ms,"
+             << raysPerSecond << "rays/s";
+
+    return raysPerSecond;
+  }
+
+signals:
+  void sceneChanged();
+  void resolutionChanged();
+};
+
+}
+}
+
+#endif //THREEPP_XAMPL_RAYCASTBENCHMARK_H
@@ -7,6 +7,8 @@
 
 #include "ShadowMapViewer.h"
 #include "HingeEditorModelRef.h"
+#include "RaycastBenchmark.h"
+#include "GeometryBenchmark.h"
 
 int main(int argc, char *argv[])
 {
@@ -22,6 +24,8 @@ int main(int argc, char *argv[])
   three::quick::init();
   qmlRegisterType<three::quick::ShadowMapViewer>("three.quick", 1, 0, "ShadowMapViewer");
   qmlRegisterType<three::quick::HingeEditorModelRef>("three.quick", 1, 0, "HingeEditorModelRef");
+  qmlRegisterType<three::quick::RaycastBenchmark>("three.quick", 1, 0, "RaycastBenchmark");
+  qmlRegisterType<three::quick::GeometryBenchmark>("three.quick", 1, 0, "GeometryBenchmark");
 
   QQmlComponent maincomponent(&qmlEngine);
   //maincomponent.loadUrl(QUrl("qrc:///geometries.qml"));
@@ -168,6 +168,13 @@ Window {
                 threeDModel.options.preferPhong = value
             }
         }
+        MenuChoice {
+            name: "raycast benchmark"
+            isAction: true
+            onSelected: {
+                console.log("rays/s:", raycastBenchmark.run(10))
+            }
+        }
     }
 
     FileDialog {
@@ -202,6 +209,12 @@ Window {
         }
     }
 
+    RaycastBenchmark {
+        id: raycastBenchmark
+        scene: scene
+        resolution: 256
+    }
+
     ThreeD {
         id: threeD
         anchors.fill: parent
@@ -74,7 +74,11 @@ enum class TextureFormat : GLenum
   RGB_S3TC_DXT1 = GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
   RGBA_S3TC_DXT1 = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,
   RGBA_S3TC_DXT3 = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT,
-  RGBA_S3TC_DXT5 = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+  RGBA_S3TC_DXT5 = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+  RGB_ETC1 = 0x8D64, //GL_ETC1_RGB8_OES
+  RGB_ETC2 = 0x9274, //GL_COMPRESSED_RGB8_ETC2
+  RGBA_ETC2_EAC = 0x9278, //GL_COMPRESSED_RGBA8_ETC2_EAC
+  RGBA32F = 0x8814 //GL_RGBA32F
 };
 
 enum class TextureType : GLenum
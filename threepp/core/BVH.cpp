@@ -0,0 +1,364 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "BVH.h"
+#include <algorithm>
+#include <threepp/util/Parallel.h>
+
+namespace three {
+
+using namespace std;
+
+namespace {
+
+const unsigned binCount = 12;
+const uint32_t maxLeafSize = 4;
+const unsigned maxDepth = 60;
+
+//subtrees with at least this many triangles are built concurrently
+const size_t parallelSize = 1 << 16;
+
+//triangles per work item when computing triangle bounds
+const size_t triangleGrain = 1 << 14;
+
+struct Bounds
+{
+  float min[3] = {numeric_limits<float>::max(), numeric_limits<float>::max(), numeric_limits<float>::max()};
+  float max[3] = {numeric_limits<float>::lowest(), numeric_limits<float>::lowest(), numeric_limits<float>::lowest()};
+
+  void expand(const float *p)
+  {
+    for(unsigned i=0; i<3; i++) {
+      min[i] = std::min(min[i], p[i]);
+      max[i] = std::max(max[i], p[i]);
+    }
+  }
+
+  void expand(const float *bmin, const float *bmax)
+  {
+    for(unsigned i=0; i<3; i++) {
+      min[i] = std::min(min[i], bmin[i]);
+      max[i] = std::max(max[i], bmax[i]);
+    }
+  }
+
+  float area() const
+  {
+    float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+    return dx < 0 ? 0 : dx * dy + dy * dz + dz * dx;
+  }
+};
+
+struct Bin
+{
+  Bounds bounds;
+  uint32_t count = 0;
+};
+
+//triangle reference used during the build
+struct Ref
+{
+  Bounds box;
+  float centroid[3];
+  uint32_t triangle;
+};
+
+}
+
+struct BVH::Builder
+{
+  //partitioned in place, so that each subtree works on a contiguous range
+  std::vector<Ref> refs;
+
+  uint32_t split(size_t begin, size_t end, const Bounds &centroidBounds, float nodeArea)
+  {
+    size_t count = end - begin;
+    float bestCost = numeric_limits<float>::max();
+    unsigned bestAxis = 3, bestBin = 0;
+
+    Bin bins[3][binCount];
+    float scale[3];
+    for(unsigned axis=0; axis<3; axis++) {
+      float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+      scale[axis] = extent > 0 ? binCount / extent : 0;
+    }
+
+    //bin all axes in one pass over the range
+    for(size_t i=begin; i<end; i++) {
+      const Ref &ref = refs[i];
+      for(unsigned axis=0; axis<3; axis++) {
+        unsigned b = std::min(binCount - 1, (unsigned)((ref.centroid[axis] - centroidBounds.min[axis]) * scale[axis]));
+        bins[axis][b].count ++;
+        bins[axis][b].bounds.expand(ref.box.min, ref.box.max);
+      }
+    }
+
+    for(unsigned axis=0; axis<3; axis++) {
+      if(scale[axis] == 0) continue;
+
+      //sweep from the right, then evaluate the cost of splitting after each bin from the left
+      float rightArea[binCount];
+      uint32_t rightCount[binCount];
+      Bounds acc;
+      uint32_t n = 0;
+      for(unsigned b = binCount - 1; b > 0; b--) {
+        acc.expand(bins[axis][b].bounds.min, bins[axis][b].bounds.max);
+        n += bins[axis][b].count;
+        rightArea[b] = acc.area();
+        rightCount[b] = n;
+      }
+
+      acc = Bounds();
+      n = 0;
+      for(unsigned b = 0; b < binCount - 1; b++) {
+        acc.expand(bins[axis][b].bounds.min, bins[axis][b].bounds.max);
+        n += bins[axis][b].count;
+        if(n == 0 || rightCount[b + 1] == 0) continue;
+
+        float cost = acc.area() * n + rightArea[b + 1] * rightCount[b + 1];
+        if(cost < bestCost) {
+          bestCost = cost;
+          bestAxis = axis;
+          bestBin = b + 1;
+        }
+      }
+    }
+
+    //all centroids coincide, split in the middle of the range
+    if(bestAxis == 3) return (uint32_t)(begin + count / 2);
+
+    //splitting a small node doesn't pay off
+    if(count <= maxLeafSize * 4 && bestCost >= nodeArea * count) return 0;
+
+    float cmin = centroidBounds.min[bestAxis];
+    float axisScale = scale[bestAxis];
+
+    auto mid = std::partition(refs.begin() + begin, refs.begin() + end, [&](const Ref &ref) {
+      return std::min(binCount - 1, (unsigned)((ref.centroid[bestAxis] - cmin) * axisScale)) < bestBin;
+    });
+
+    return (uint32_t)(mid - refs.begin());
+  }
+
+  void subtree(size_t begin, size_t end, unsigned depth, std::vector<Node> &nodes)
+  {
+    size_t index = nodes.size();
+    nodes.emplace_back();
+
+    Bounds bounds, centroidBounds;
+    for(size_t i=begin; i<end; i++) {
+      bounds.expand(refs[i].box.min, refs[i].box.max);
+      centroidBounds.expand(refs[i].centroid);
+    }
+    std::copy(bounds.min, bounds.min + 3, nodes[index].min);
+    std::copy(bounds.max, bounds.max + 3, nodes[index].max);
+
+    size_t count = end - begin;
+    uint32_t mid = count <= maxLeafSize || depth >= maxDepth ? 0 : split(begin, end, centroidBounds, bounds.area());
+
+    if(mid == 0) {
+      nodes[index].offset = (uint32_t)begin;
+      nodes[index].count = (uint32_t)count;
+      return;
+    }
+    nodes[index].count = 0;
+
+    if(count >= parallelSize && (1u << depth) < parallel::concurrency()) {
+      //build both children concurrently, then append them to this tree
+      std::vector<Node> children[2];
+      parallel::for_each(0, 2, [&](size_t b, size_t e) {
+        for(size_t c = b; c < e; c++) {
+          subtree(c == 0 ? begin : mid, c == 0 ? mid : end, depth + 1, children[c]);
+        }
+      });
+
+      for(auto &child : children) {
+        uint32_t base = (uint32_t)nodes.size();
+        for(Node &node : child) {
+          if(!node.isLeaf()) node.offset += base;
+        }
+        if(&child == &children[1]) nodes[index].offset = base;
+        nodes.insert(nodes.end(), child.begin(), child.end());
+      }
+    }
+    else {
+      subtree(begin, mid, depth + 1, nodes);
+      nodes[index].offset = (uint32_t)nodes.size();
+      subtree(mid, end, depth + 1, nodes);
+    }
+  }
+};
+
+void BVH::build()
+{
+  _nodes.clear();
+  _triangles.clear();
+
+  _positionVersion = _position ? _position->version() : 0;
+  _indexVersion = _index ? _index->version() : 0;
+  _triangleCount = _index ? _index->size() / 3 : (_position ? _position->itemCount() / 3 : 0);
+
+  if(_triangleCount == 0) return;
+
+  Builder builder;
+  builder.refs.resize(_triangleCount);
+
+  const float *position = _position->data_t();
+  const uint32_t *index = _index ? _index->data_t() : nullptr;
+
+  parallel::for_each(0, _triangleCount, [&](size_t begin, size_t end) {
+
+    for(size_t t = begin; t < end; t++) {
+      Ref &ref = builder.refs[t];
+      ref.box = Bounds();
+      for(unsigned k=0; k<3; k++) {
+        size_t vertex = index ? index[t * 3 + k] : t * 3 + k;
+        ref.box.expand(position + vertex * 3);
+      }
+      for(unsigned i=0; i<3; i++) {
+        ref.centroid[i] = (ref.box.min[i] + ref.box.max[i]) * 0.5f;
+      }
+      ref.triangle = (uint32_t)t;
+    }
+  }, triangleGrain);
+
+  _nodes.reserve(_triangleCount * 2 / maxLeafSize + 1);
+  builder.subtree(0, _triangleCount, 0, _nodes);
+
+  _triangles.resize(_triangleCount);
+  for(size_t i=0; i<_triangleCount; i++) _triangles[i] = builder.refs[i].triangle;
+}
+
+constexpr unsigned BVH::packetSize;
+
+BVH::RayPacket::RayPacket(const math::Ray *rays, unsigned count) : count(count)
+{
+  if(count == 0 || count > packetSize)
+    throw invalid_argument("RayPacket: invalid ray count");
+
+  //unused lanes replicate the first ray and are masked out
+  for(unsigned i=0; i<packetSize; i++) {
+    const math::Ray &ray = rays[i < count ? i : 0];
+    ox[i] = ray.origin().x(); oy[i] = ray.origin().y(); oz[i] = ray.origin().z();
+    dx[i] = ray.direction().x(); dy[i] = ray.direction().y(); dz[i] = ray.direction().z();
+    ix[i] = 1.0f / dx[i]; iy[i] = 1.0f / dy[i]; iz[i] = 1.0f / dz[i];
+    limit[i] = numeric_limits<float>::infinity();
+  }
+}
+
+unsigned BVH::RayPacket::intersectBox(const Node &node, unsigned mask, float &tnear) const
+{
+  float near[packetSize];
+  int hit[packetSize];
+
+  for(unsigned i=0; i<packetSize; i++) {
+    float tx0 = (node.min[0] - ox[i]) * ix[i], tx1 = (node.max[0] - ox[i]) * ix[i];
+    float ty0 = (node.min[1] - oy[i]) * iy[i], ty1 = (node.max[1] - oy[i]) * iy[i];
+    float tz0 = (node.min[2] - oz[i]) * iz[i], tz1 = (node.max[2] - oz[i]) * iz[i];
+
+    float tmin = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::max(std::min(tz0, tz1), 0.0f));
+    float tmax = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::max(tz0, tz1));
+
+    near[i] = tmin;
+    hit[i] = tmin <= tmax && tmin <= limit[i];
+  }
+
+  unsigned result = 0;
+  tnear = numeric_limits<float>::infinity();
+  for(unsigned i=0; i<packetSize; i++) {
+    if(hit[i] && (mask & (1u << i))) {
+      result |= 1u << i;
+      tnear = std::min(tnear, near[i]);
+    }
+  }
+  return result;
+}
+
+unsigned BVH::RayPacket::intersectTriangle(const math::Vector3 &a, const math::Vector3 &b, const math::Vector3 &c,
+                                           unsigned mask) const
+{
+  const float e1x = b.x() - a.x(), e1y = b.y() - a.y(), e1z = b.z() - a.z();
+  const float e2x = c.x() - a.x(), e2y = c.y() - a.y(), e2z = c.z() - a.z();
+
+  const float nx = e1y * e2z - e1z * e2y;
+  const float ny = e1z * e2x - e1x * e2z;
+  const float nz = e1x * e2y - e1y * e2x;
+
+  int hit[packetSize];
+
+  for(unsigned i=0; i<packetSize; i++) {
+    float DdN = dx[i] * nx + dy[i] * ny + dz[i] * nz;
+    float sign = DdN > 0 ? 1.0f : -1.0f;
+    float absDdN = DdN * sign;
+
+    float qx = ox[i] - a.x(), qy = oy[i] - a.y(), qz = oz[i] - a.z();
+
+    //Dot(D, Cross(Q, E2)) and Dot(D, Cross(E1, Q))
+    float b1 = sign * (dx[i] * (qy * e2z - qz * e2y) + dy[i] * (qz * e2x - qx * e2z) + dz[i] * (qx * e2y - qy * e2x));
+    float b2 = sign * (dx[i] * (e1y * qz - e1z * qy) + dy[i] * (e1z * qx - e1x * qz) + dz[i] * (e1x * qy - e1y * qx));
+    float t = -sign * (qx * nx + qy * ny + qz * nz);
+
+    float tolerance = absDdN * 1e-5f;
+    hit[i] = absDdN > 0 && b1 >= -tolerance && b2 >= -tolerance && b1 + b2 <= absDdN + tolerance && t >= -tolerance;
+  }
+
+  unsigned result = 0;
+  for(unsigned i=0; i<packetSize; i++) {
+    if(hit[i]) result |= 1u << i;
+  }
+  return result & mask;
+}
+
+void BVH::refit()
+{
+  _positionVersion = _position->version();
+
+  const float *position = _position->data_t();
+  const uint32_t *index = _index ? _index->data_t() : nullptr;
+
+  //leaves are independent of each other
+  parallel::for_each(0, _nodes.size(), [&](size_t begin, size_t end) {
+
+    for(size_t n = begin; n < end; n++) {
+      Node &node = _nodes[n];
+      if(!node.isLeaf()) continue;
+
+      Bounds bounds;
+      for(uint32_t i = node.offset, e = node.offset + node.count; i < e; i++) {
+        size_t t = _triangles[i];
+        for(unsigned k=0; k<3; k++) {
+          size_t vertex = index ? index[t * 3 + k] : t * 3 + k;
+          bounds.expand(position + vertex * 3);
+        }
+      }
+      std::copy(bounds.min, bounds.min + 3, node.min);
+      std::copy(bounds.max, bounds.max + 3, node.max);
+    }
+  }, triangleGrain);
+
+  //children are stored after their parents
+  for(size_t n = _nodes.size(); n-- > 0; ) {
+    Node &node = _nodes[n];
+    if(node.isLeaf()) continue;
+
+    const Node &left = _nodes[n + 1];
+    const Node &right = _nodes[node.offset];
+    for(unsigned i=0; i<3; i++) {
+      node.min[i] = std::min(left.min[i], right.min[i]);
+      node.max[i] = std::max(left.max[i], right.max[i]);
+    }
+  }
+}
+
+void BVH::update()
+{
+  size_t triangleCount = _index ? _index->size() / 3 : (_position ? _position->itemCount() / 3 : 0);
+
+  if(triangleCount != _triangleCount || (_index && _index->version() != _indexVersion))
+    build();
+  else if(_position && _position->version() != _positionVersion)
+    refit();
+}
+
+}
@@ -0,0 +1,261 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_BVH_H
+#define THREEPP_BVH_H
+
+#include <vector>
+#include <memory>
+#include <limits>
+#include <threepp/math/Ray.h>
+#include <threepp/util/osdecl.h>
+#include "BufferAttribute.h"
+
+namespace three {
+
+/**
+ * bounding volume hierarchy over the triangles of a buffer geometry. The tree is built using binned
+ * SAH (surface area heuristic) splits, with subtrees of large meshes built concurrently. If only the
+ * vertex positions change, the node bounds are refitted without rebuilding the tree
+ */
+class DLX BVH
+{
+public:
+  /**
+   * tree node. Inner nodes have count == 0, their left child immediately follows the node and
+   * offset holds the index of the right child. For leaves, offset is the first entry in the
+   * triangle list
+   */
+  struct Node
+  {
+    float min[3];
+    float max[3];
+    uint32_t offset;
+    uint32_t count;
+
+    bool isLeaf() const {return count > 0;}
+  };
+
+  //maximum number of rays traced together
+  static constexpr unsigned packetSize = 8;
+
+  /**
+   * a bundle of up to packetSize coherent rays in structure-of-arrays layout. The per-lane loops
+   * are written branch-free so that the compiler can vectorize them. Bit i in a lane mask refers
+   * to ray i
+   */
+  struct RayPacket
+  {
+    float ox[packetSize], oy[packetSize], oz[packetSize];
+    float dx[packetSize], dy[packetSize], dz[packetSize];
+    float ix[packetSize], iy[packetSize], iz[packetSize];
+    unsigned count;
+
+    //per lane maximum ray parameter. Nodes beyond are skipped
+    float limit[packetSize];
+
+    RayPacket(const math::Ray *rays, unsigned count);
+
+    unsigned mask() const {return (1u << count) - 1;}
+
+    /**
+     * @return the lanes in mask whose rays hit the box, and the nearest entry distance among them
+     */
+    unsigned intersectBox(const Node &node, unsigned mask, float &tnear) const;
+
+    /**
+     * conservative triangle test, using the same formulation as math::Ray::intersectTriangle without
+     * backface culling, with a small tolerance. Lanes that pass must be confirmed by the exact test
+     *
+     * @return the lanes in mask whose rays may hit the triangle
+     */
+    unsigned intersectTriangle(const math::Vector3 &a, const math::Vector3 &b, const math::Vector3 &c,
+                               unsigned mask) const;
+  };
+
+private:
+  BufferAttributeT<float>::Ptr _position;
+  BufferAttributeT<uint32_t>::Ptr _index;
+
+  unsigned _positionVersion = 0;
+  unsigned _indexVersion = 0;
+  size_t _triangleCount = 0;
+
+  std::vector<Node> _nodes;
+
+  //triangle numbers, ordered by leaf
+  std::vector<uint32_t> _triangles;
+
+  struct Builder;
+
+  BVH(const BufferAttributeT<float>::Ptr &position, const BufferAttributeT<uint32_t>::Ptr &index)
+     : _position(position), _index(index) {}
+
+  void build();
+  void refit();
+
+  //entry/exit distances of the ray for the node bounds, or false if missed
+  static bool slabs(const Node &node, const float *origin, const float *invDir, float &tnear)
+  {
+    float tmin = 0, tmax = std::numeric_limits<float>::infinity();
+
+    for(unsigned i=0; i<3; i++) {
+      float t0 = (node.min[i] - origin[i]) * invDir[i];
+      float t1 = (node.max[i] - origin[i]) * invDir[i];
+      if(t0 > t1) std::swap(t0, t1);
+
+      //NaN (0 * inf) leaves the interval unchanged
+      tmin = t0 > tmin ? t0 : tmin;
+      tmax = t1 < tmax ? t1 : tmax;
+    }
+    tnear = tmin;
+    return tmin <= tmax;
+  }
+
+public:
+  using Ptr = std::shared_ptr<BVH>;
+
+  /**
+   * build a hierarchy for the given attributes
+   *
+   * @param position vertex positions, item size 3
+   * @param index triangle indices, may be null for non-indexed geometry
+   */
+  static Ptr make(const BufferAttributeT<float>::Ptr &position, const BufferAttributeT<uint32_t>::Ptr &index)
+  {
+    Ptr bvh(new BVH(position, index));
+    bvh->build();
+    return bvh;
+  }
+
+  /**
+   * @return true if this tree was built for the given attributes
+   */
+  bool builtFor(const BufferAttributeT<float>::Ptr &position, const BufferAttributeT<uint32_t>::Ptr &index) const
+  {
+    return _position == position && _index == index;
+  }
+
+  /**
+   * bring the tree up to date with the attributes. Position changes cause a refit, index changes
+   * or a changed triangle count cause a rebuild
+   */
+  void update();
+
+  const std::vector<Node> &nodes() const {return _nodes;}
+
+  size_t triangleCount() const {return _triangleCount;}
+
+  /**
+   * invoke func(uint32_t triangle) for each triangle whose leaf bounds are hit by the ray. Nearer
+   * children are visited first
+   *
+   * @param tmax the maximum ray parameter. May be reduced by func as hits are found, in which case
+   * nodes beyond it are skipped
+   */
+  template <typename Func>
+  void intersect(const math::Ray &ray, Func func, const float &tmax=std::numeric_limits<float>::infinity()) const
+  {
+    if(_nodes.empty()) return;
+
+    const float origin[3] = {ray.origin().x(), ray.origin().y(), ray.origin().z()};
+    const float invDir[3] = {1.0f / ray.direction().x(), 1.0f / ray.direction().y(), 1.0f / ray.direction().z()};
+
+    float tnear;
+    if(!slabs(_nodes[0], origin, invDir, tnear) || tnear > tmax) return;
+
+    struct Item {uint32_t node; float tnear;};
+    Item stack[64];
+    unsigned top = 0;
+    uint32_t current = 0;
+
+    while(true) {
+      const Node &node = _nodes[current];
+
+      if(node.isLeaf()) {
+        for(uint32_t i = node.offset, end = node.offset + node.count; i < end; i++)
+          func(_triangles[i]);
+      }
+      else {
+        uint32_t left = current + 1, right = node.offset;
+        float tleft, tright;
+        bool hitLeft = slabs(_nodes[left], origin, invDir, tleft) && tleft <= tmax;
+        bool hitRight = slabs(_nodes[right], origin, invDir, tright) && tright <= tmax;
+
+        if(hitLeft && hitRight) {
+          if(tright < tleft) {
+            std::swap(left, right);
+            std::swap(tleft, tright);
+          }
+          stack[top++] = Item {right, tright};
+          current = left;
+          continue;
+        }
+        if(hitLeft) {current = left; continue;}
+        if(hitRight) {current = right; continue;}
+      }
+
+      //skip deferred nodes which are now beyond the limit
+      while(top > 0 && stack[top - 1].tnear > tmax) top--;
+      if(top == 0) break;
+      current = stack[--top].node;
+    }
+  }
+
+  /**
+   * traverse the tree with a ray packet. Nodes are entered if any of the packet's active rays hits
+   * them, so that traversal cost is shared by the bundle. Invokes func(uint32_t triangle, unsigned mask)
+   * for each triangle in the leaves reached, with the lanes that reached the leaf
+   */
+  template <typename Func>
+  void intersect(const RayPacket &packet, Func func) const
+  {
+    if(_nodes.empty()) return;
+
+    float tnear;
+    unsigned mask = packet.intersectBox(_nodes[0], packet.mask(), tnear);
+    if(!mask) return;
+
+    struct Item {uint32_t node; unsigned mask;};
+    Item stack[64];
+    unsigned top = 0;
+    uint32_t current = 0;
+
+    while(true) {
+      const Node &node = _nodes[current];
+
+      if(node.isLeaf()) {
+        for(uint32_t i = node.offset, end = node.offset + node.count; i < end; i++)
+          func(_triangles[i], mask);
+      }
+      else {
+        uint32_t left = current + 1, right = node.offset;
+        float tleft, tright;
+        unsigned maskLeft = packet.intersectBox(_nodes[left], mask, tleft);
+        unsigned maskRight = packet.intersectBox(_nodes[right], mask, tright);
+
+        if(maskLeft && maskRight) {
+          if(tright < tleft) {
+            std::swap(left, right);
+            std::swap(maskLeft, maskRight);
+          }
+          stack[top++] = Item {right, maskRight};
+          current = left;
+          mask = maskLeft;
+          continue;
+        }
+        if(maskLeft) {current = left; mask = maskLeft; continue;}
+        if(maskRight) {current = right; mask = maskRight; continue;}
+      }
+      if(top == 0) break;
+      top--;
+      current = stack[top].node;
+      mask = stack[top].mask;
+    }
+  }
+};
+
+}
+
+#endif //THREEPP_BVH_H
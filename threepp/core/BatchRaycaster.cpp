@@ -0,0 +1,67 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "BatchRaycaster.h"
+#include "BufferGeometry.h"
+#include <threepp/util/Parallel.h>
+
+namespace three {
+
+using namespace std;
+using namespace math;
+
+void BatchRaycaster::prepare(Object3D &object)
+{
+  if(!object.visible()) return;
+
+  const Geometry::Ptr geometry = object.geometry();
+  if(geometry) {
+    if(geometry->boundingSphere().isEmpty()) geometry->computeBoundingSphere();
+
+    BufferGeometry *bufferGeometry = geometry->typer;
+    if(bufferGeometry) bufferGeometry->bvh();
+  }
+
+  for(const auto &child : object.children()) prepare(*child);
+}
+
+void BatchRaycaster::update(const std::vector<Object3D::Ptr> &objects)
+{
+  for(const auto &object : objects) prepare(*object);
+
+  _index.update(objects);
+}
+
+void BatchRaycaster::intersect(const std::vector<math::Ray> &rays, std::vector<Intersection> &hits) const
+{
+  hits.resize(rays.size());
+
+  parallel::for_each(0, rays.size(), [&](size_t begin, size_t end) {
+
+    //one caster and result list per thread, reused for all its rays
+    Raycaster raycaster;
+    raycaster.setRange(_near, _far).setMode(RaycastMode::Closest);
+    IntersectList intersects;
+
+    for(size_t i = begin; i < end; i++) {
+      raycaster.set(rays[i]);
+      intersects.clear();
+      intersects.setMode(RaycastMode::Closest, 1);
+
+      _index.intersect(raycaster, intersects);
+
+      Intersection &hit = hits[i];
+      if(intersects.empty()) {
+        hit = Intersection();
+        hit.distance = numeric_limits<float>::infinity();
+      }
+      else {
+        intersects.prepare();
+        hit = intersects.get(0, 0);
+      }
+    }
+  }, _grain);
+}
+
+}
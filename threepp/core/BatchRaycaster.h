@@ -0,0 +1,74 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_BATCHRAYCASTER_H
+#define THREEPP_BATCHRAYCASTER_H
+
+#include <vector>
+#include <limits>
+#include "Raycaster.h"
+#include "SceneIndex.h"
+
+namespace three {
+
+/**
+ * casts large numbers of independent rays against a set of objects, distributing the rays over
+ * worker threads. Each ray yields its closest intersection. Candidate objects are found through a
+ * SceneIndex, triangle meshes are intersected using their BVH. All lazily computed state (bounding
+ * spheres, BVHs) is brought up to date in update(), so that the concurrent queries only read
+ */
+class DLX BatchRaycaster
+{
+  SceneIndex _index;
+
+  float _near = 0, _far = std::numeric_limits<float>::infinity();
+
+  //minimum number of rays per worker thread
+  size_t _grain = 256;
+
+  void prepare(Object3D &object);
+
+public:
+  BatchRaycaster() = default;
+
+  /**
+   * set the distance range, measured from each ray's origin, within which intersections are reported
+   */
+  BatchRaycaster &setRange(float near, float far)
+  {
+    _near = near;
+    _far = far;
+    return *this;
+  }
+
+  /**
+   * set the minimum number of rays handled by a single thread
+   */
+  BatchRaycaster &setGrain(size_t grain)
+  {
+    _grain = grain;
+    return *this;
+  }
+
+  /**
+   * synchronize with the given objects and their visible descendants. Must be called after the objects
+   * or their geometries have changed, and before intersect(). The world matrices must be up-to-date
+   */
+  void update(const std::vector<Object3D::Ptr> &objects);
+
+  /**
+   * find the closest intersection for each ray. Rays are processed concurrently
+   *
+   * @param rays the rays to cast
+   * @param hits (out) one entry per ray, in the same order. Rays that hit nothing yield an entry with
+   * a null object and infinite distance
+   */
+  void intersect(const std::vector<math::Ray> &rays, std::vector<Intersection> &hits) const;
+
+  const SceneIndex &index() const {return _index;}
+};
+
+}
+
+#endif //THREEPP_BATCHRAYCASTER_H
@@ -11,7 +11,8 @@
 
 #include <threepp/Constants.h>
 #include <threepp/core/Color.h>
-#include <threepp/util/sole.h>
+#include <threepp/util/ResourceId.h>
+#include <threepp/util/Arena.h>
 #include <threepp/util/simplesignal.h>
 #include <threepp/math/Vector2.h>
 #include <threepp/math/Vector3.h>
@@ -54,6 +55,18 @@ struct Cpp2GL<uint8_t> {
   static const GLenum glEnum = GL_UNSIGNED_BYTE;
 };
 
+/**
+ * IEEE 754 half precision float, stored as its bit pattern. See VertexPacking for conversion
+ */
+struct half
+{
+  uint16_t bits;
+};
+template<>
+struct Cpp2GL<half> {
+  static const GLenum glEnum = GL_HALF_FLOAT;
+};
+
 struct Index
 {
   union
@@ -83,12 +96,11 @@ protected:
   UpdateRange _updateRange;
 
   explicit BufferAttribute(unsigned itemSize, bool normalized)
-     : uuid(sole::uuid4()), _itemSize(itemSize), _normalized(normalized)
+     : _itemSize(itemSize), _normalized(normalized)
   {}
 
   BufferAttribute(const BufferAttribute &att)
-     : uuid(sole::uuid4()),
-       _version(att._version),
+     : _version(att._version),
        _itemSize(att._itemSize),
        _normalized(att._normalized),
        _updateRange(att._updateRange) {}
@@ -102,7 +114,7 @@ public:
 
   Signal<void(const BufferAttribute &)> onUpload;
 
-  const sole::uuid uuid;
+  const ResourceId resourceId;
 
   void needsUpdate() {_version++;}
 
@@ -148,9 +160,9 @@ protected:
 public:
   using Ptr = std::shared_ptr<BufferAttributeT<Type>>;
 
-  const Type &data_t(uint32_t offset) {return _data[offset];}
+  const Type &data_t(uint32_t offset) const {return _data[offset];}
 
-  const Type *data_t() {return _data;}
+  const Type *data_t() const {return _data;}
 
   void clear() {memset(_data, 0, byteCount());}
 
@@ -349,37 +361,42 @@ class PreallocBufferAttribute : public BufferAttributeT<ComponentType>
   using Base = BufferAttribute;
 
   ItemType *it;
+  size_t _itemCount;
   size_t _offset = 0;
 
+  //the items live in the attribute arena
+  void allocate()
+  {
+    it = static_cast<ItemType *>(Arena::allocate(_itemCount * sizeof(ItemType)));
+    for(size_t i=0; i<_itemCount; i++) new (it + i) ItemType();
+    Super::_data = reinterpret_cast<ComponentType *>(it);
+  }
+
 protected:
   PreallocBufferAttribute(size_t itemCount, bool normalized)
-     : Super(itemCount * itemSize, itemSize, normalized)
+     : Super(itemCount * itemSize, itemSize, normalized), _itemCount(itemCount)
   {
-    it = new ItemType[itemCount];
-    Super::_data = reinterpret_cast<ComponentType *>(it);
+    allocate();
   }
 
   PreallocBufferAttribute(const std::vector<ItemType> &items, bool normalized)
-     : Super(items.size() * itemSize, itemSize, normalized)
+     : Super(items.size() * itemSize, itemSize, normalized), _itemCount(items.size())
   {
-    it = new ItemType[items.size()];
+    allocate();
     memcpy(it, items.data(), Super::byteCount());
-    Super::_data = reinterpret_cast<ComponentType *>(it);
   }
 
   PreallocBufferAttribute(const std::initializer_list<ItemType> &items, bool normalized)
-     : Super(items.size() * itemSize, itemSize, normalized)
+     : Super(items.size() * itemSize, itemSize, normalized), _itemCount(items.size())
   {
-    it = new ItemType[items.size()];
+    allocate();
     for(auto i=items.begin(); i != items.end(); i++) next() = *i;
-    Super::_data = reinterpret_cast<ComponentType *>(it);
   }
 
   PreallocBufferAttribute(const PreallocBufferAttribute &attr)
-     : Super(attr)
+     : Super(attr), _itemCount(attr._itemCount)
   {
-    it = new ItemType[attr.itemCount()];
-    Super::_data = reinterpret_cast<ComponentType *>(it);
+    allocate();
     memcpy(Super::_data, attr._data, attr.byteCount());
   }
 
@@ -399,7 +416,8 @@ public:
   using Ptr = std::shared_ptr<PreallocBufferAttribute>;
 
   ~PreallocBufferAttribute() {
-    delete[] it;
+    for(size_t i=0; i<_itemCount; i++) it[i].~ItemType();
+    Arena::deallocate(it, _itemCount * sizeof(ItemType));
   }
 
   PreallocBufferAttribute *clone() const override {
@@ -422,7 +440,7 @@ class GrowingBufferAttribute : public BufferAttributeT<ComponentType>
   using Super = BufferAttributeT<ComponentType>;
   using Base = BufferAttribute;
 
-  std::vector<ItemType> _array;
+  std::vector<ItemType, ArenaAllocator<ItemType>> _array;
 
 protected:
   explicit GrowingBufferAttribute(bool normalized)
@@ -3,12 +3,16 @@
 //
 
 #include <vector>
+#include <limits>
+#include <mutex>
+#include <algorithm>
 #include <threepp/objects/Points.h>
 #include <threepp/objects/Line.h>
 #include <threepp/objects/Mesh.h>
+#include <threepp/util/Parallel.h>
 
 #include "BufferGeometry.h"
-#include "DirectGeometry.h"
+#include "LinearGeometry.h"
 #include "impl/raycast.h"
 
 namespace three {
@@ -16,7 +20,7 @@ namespace three {
 using namespace math;
 using namespace impl;
 
-size_t Geometry::id_count = 0;
+std::atomic<size_t> Geometry::id_count(0);
 
 BufferGeometry::BufferGeometry(const BufferAttributeT<float>::Ptr &position, const BufferAttributeT<float>::Ptr &color)
    : Geometry(geometry::Typer(this))
@@ -51,6 +55,10 @@ BufferGeometry::BufferGeometry(const BufferGeometry &geom) : Geometry(geom, geom
     //_indexedAttributes.insert(iatt.first, BufferAttributeT<float>::Ptr(iatt.second->clone()));
   }
 
+  //the render copies are made from the cloned attributes
+  if(geom._packed && geom._packed->repack) _packed = geom._packed->repack(*this);
+  if(geom._interleaved) interleave();
+
   UpdateRange _drawRange;
 }
 
@@ -63,26 +71,401 @@ math::Vector3 BufferGeometry::centroid(const Face3 &face) const
   return (vA + vB + vC) / 3.0f;
 }
 
+namespace {
+
+//vertices per thread for bounds, normals and tangents
+const size_t vertexGrain = 16384;
+
+//triangles per thread
+const size_t triangleGrain = 4096;
+
+math::Box3 positionBox(const BufferAttributeT<float> &position)
+{
+  const float *data = position.data_t();
+  unsigned stride = position.itemSize();
+
+  std::mutex mutex;
+  math::Box3 box;
+
+  parallel::for_each(0, position.itemCount(), [&](size_t begin, size_t end) {
+
+    float min[3] = {std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(),
+                    std::numeric_limits<float>::infinity()};
+    float max[3] = {-min[0], -min[1], -min[2]};
+
+    for(size_t i = begin; i < end; i++) {
+      const float *v = data + i * stride;
+      for(unsigned k = 0; k < 3; k++) {
+        min[k] = std::min(min[k], v[k]);
+        max[k] = std::max(max[k], v[k]);
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    box.expandByPoint(Vector3(min[0], min[1], min[2]));
+    box.expandByPoint(Vector3(max[0], max[1], max[2]));
+  }, vertexGrain);
+
+  return box;
+}
+
+/**
+ * the triangles of a set of groups, numbered consecutively
+ */
+struct TriangleRanges
+{
+  //first index position of each group, and first triangle number of each group plus the total
+  std::vector<size_t> starts;
+  std::vector<size_t> offsets {0};
+
+  TriangleRanges(const std::vector<Group> &groups, size_t indexCount)
+  {
+    for(const Group &group : groups) {
+      size_t end = std::min(group.start + group.count, indexCount);
+      starts.push_back(group.start);
+      offsets.push_back(offsets.back() + (end > group.start ? (end - group.start) / 3 : 0));
+    }
+  }
+
+  size_t count() const {return offsets.back();}
+
+  //call func with the number and the first index position of the triangles numbered begin to end
+  template <typename Func>
+  void forEach(size_t begin, size_t end, Func func) const
+  {
+    size_t r = std::upper_bound(offsets.begin(), offsets.end(), begin) - offsets.begin() - 1;
+
+    for(size_t t = begin; t < end; r++) {
+      size_t e = std::min(end, offsets[r + 1]);
+      for(; t < e; t++) func(t, starts[r] + (t - offsets[r]) * 3);
+    }
+  }
+};
+
+/**
+ * sum per-triangle contributions into vertices, each vertex adding up its triangles in triangle order,
+ * so the result does not depend on the number of threads. Single threaded, the triangles are scattered
+ * into their vertices. Otherwise, the contributions are computed in parallel over fixed triangle chunks,
+ * which also sort their triangles into per vertex range lists. Each vertex range then scatters the
+ * triangles listed for it, chunk by chunk, into the vertices it owns
+ *
+ * @param func computes the contribution of the triangle at an index position. false if there is none
+ */
+template <typename Item, typename Func>
+void accumulate(Item *target, const uint32_t *index, size_t vertexCount, const TriangleRanges &ranges, Func func)
+{
+  size_t count = ranges.count();
+
+  //power of 2 vertex ranges, so a shift finds the range of a vertex
+  unsigned shift = 0;
+  size_t threads = parallel::concurrency();
+  while(((size_t)1 << shift) * threads < vertexCount || ((size_t)1 << shift) < vertexGrain) shift++;
+  size_t vertexRanges = (vertexCount + ((size_t)1 << shift) - 1) >> shift;
+
+  if(vertexRanges < 2 || count < 2 * triangleGrain) {
+    std::fill(target, target + vertexCount, Item());
+
+    ranges.forEach(0, count, [&](size_t t, size_t i) {
+      Item item;
+      if(!func(i, item)) return;
+
+      target[index[i]] += item;
+      target[index[i + 1]] += item;
+      target[index[i + 2]] += item;
+    });
+    return;
+  }
+
+  //triangle number and first index position
+  struct Triangle {uint32_t t, i;};
+
+  size_t chunkSize = std::max(triangleGrain, (count + threads - 1) / threads);
+  size_t chunks = (count + chunkSize - 1) / chunkSize;
+
+  std::vector<Item> items(count);
+  std::vector<std::vector<Triangle>> lists(chunks * vertexRanges);
+
+  parallel::for_each(0, chunks, [&](size_t begin, size_t end) {
+    for(size_t c = begin; c < end; c++) {
+      std::vector<Triangle> *list = &lists[c * vertexRanges];
+
+      ranges.forEach(c * chunkSize, std::min(count, (c + 1) * chunkSize), [&](size_t t, size_t i) {
+        if(!func(i, items[t])) return;
+
+        size_t a = index[i] >> shift, b = index[i + 1] >> shift, r = index[i + 2] >> shift;
+        Triangle triangle {(uint32_t)t, (uint32_t)i};
+
+        list[a].push_back(triangle);
+        if(b != a) list[b].push_back(triangle);
+        if(r != a && r != b) list[r].push_back(triangle);
+      });
+    }
+  });
+
+  parallel::for_each(0, vertexRanges, [&](size_t begin, size_t end) {
+    for(size_t r = begin; r < end; r++) {
+      size_t first = r << shift, size = std::min((size_t)1 << shift, vertexCount - first);
+      std::fill(target + first, target + first + size, Item());
+
+      for(size_t c = 0; c < chunks; c++) {
+        for(const Triangle &triangle : lists[c * vertexRanges + r]) {
+          const Item &item = items[triangle.t];
+
+          //unsigned wrap around makes vertices below first fail too
+          for(unsigned k = 0; k < 3; k++) {
+            uint32_t v = index[triangle.i + k];
+            if(v - first < size) target[v] += item;
+          }
+        }
+      }
+    }
+  });
+}
+
+//plain vector for the accumulation loops, the math::Vector3 constructors are not inlined
+struct Sum3
+{
+  float x = 0, y = 0, z = 0;
+
+  Sum3() {}
+  Sum3(float x, float y, float z) : x(x), y(y), z(z) {}
+
+  Sum3 &operator +=(const Sum3 &other)
+  {
+    x += other.x;
+    y += other.y;
+    z += other.z;
+    return *this;
+  }
+
+  float dot(const Sum3 &other) const {return x * other.x + y * other.y + z * other.z;}
+
+  Sum3 cross(const Sum3 &other) const
+  {
+    return Sum3(y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x);
+  }
+
+  Sum3 &normalize()
+  {
+    float length = std::sqrt(dot(*this));
+    if(length > 0) {
+      x /= length;
+      y /= length;
+      z /= length;
+    }
+    return *this;
+  }
+};
+
+//summed texture space directions of u and v
+struct TangentSum
+{
+  Sum3 s, t;
+
+  TangentSum &operator +=(const TangentSum &other)
+  {
+    s += other.s;
+    t += other.t;
+    return *this;
+  }
+};
+
+}
+
+BufferGeometry &BufferGeometry::computeBoundingBox()
+{
+  if (_position) {
+    _boundingBox = positionBox(*_position);
+  }
+  else {
+    _boundingBox.makeEmpty();
+  }
+  return *this;
+}
+
 BufferGeometry &BufferGeometry::computeBoundingSphere()
 {
   if (_position) {
-    math::Box3 box = _position->box3();
-    math::Vector3 center = box.getCenter();
+    math::Vector3 center = positionBox(*_position).getCenter();
 
     // hoping to find a boundingSphere with a radius smaller than the
     // boundingSphere of the boundingBox: sqrt(3) smaller in the best case
+    const float *data = _position->data_t();
+    unsigned stride = _position->itemSize();
+    float cx = center.x(), cy = center.y(), cz = center.z();
+
+    std::mutex mutex;
     float maxRadiusSq = 0;
 
-    for (size_t i = 0, il = _position->itemCount(); i < il; i++) {
-      math::Vector3 v(_position->get_x(i), _position->get_y(i), _position->get_z(i));
-      maxRadiusSq = std::max(maxRadiusSq, center.distanceToSquared(v));
-    }
+    parallel::for_each(0, _position->itemCount(), [&](size_t begin, size_t end) {
+
+      float chunkMax = 0;
+      for(size_t i = begin; i < end; i++) {
+        const float *v = data + i * stride;
+        float dx = v[0] - cx, dy = v[1] - cy, dz = v[2] - cz;
+        chunkMax = std::max(chunkMax, dx * dx + dy * dy + dz * dz);
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      maxRadiusSq = std::max(maxRadiusSq, chunkMax);
+    }, vertexGrain);
 
     _boundingSphere = math::Sphere(center, std::sqrt(maxRadiusSq));
   }
   return *this;
 }
 
+const BVH *BufferGeometry::bvh()
+{
+  if(!_useBVH || !_position || _position->itemSize() != 3) return nullptr;
+
+  size_t triangles = _index ? _index->size() / 3 : _position->itemCount() / 3;
+  if(triangles < bvhMinTriangles) return nullptr;
+
+  if(!_bvh || !_bvh->builtFor(_position, _index))
+    _bvh = BVH::make(_position, _index);
+  else
+    _bvh->update();
+
+  return _bvh.get();
+}
+
+namespace {
+
+/*
+ * test a triangle, adding the hit to the list. In modes other than RaycastMode::All, hits beyond the
+ * ray's current limit are rejected early and uv/face normal computation is deferred
+ */
+inline void intersectTriangle(const Mesh &mesh,
+                              const Material &material,
+                              const Raycaster &raycaster,
+                              const math::Ray &ray, unsigned rayIndex,
+                              const BufferAttributeT<float>::Ptr &position,
+                              const BufferAttributeT<float>::Ptr &uv,
+                              unsigned a, unsigned b, unsigned c, unsigned faceIndex,
+                              Intersection &intersection,
+                              IntersectList &intersects)
+{
+  bool hit = intersects.mode() == RaycastMode::All ?
+             checkBufferGeometryIntersection(mesh, material, raycaster, ray, position, uv, a, b, c, intersection) :
+             checkBufferGeometryHit(mesh, material, raycaster, ray, position, a, b, c, intersects.limit(rayIndex), intersection);
+
+  if(hit) {
+    intersection.faceIndex = faceIndex;
+    intersection.object = &const_cast<Mesh &>(mesh);
+    intersects.add(rayIndex, intersection);
+  }
+}
+
+/*
+ * converts a ray's intersection limit, which is a world space distance from the raycaster origin, into a
+ * bound for the parameter t of the local space ray. A world point at parameter t is at least
+ * t * scale - offset away from the origin
+ */
+class LocalLimit
+{
+  float _scale, _offset;
+
+public:
+  LocalLimit(const Mesh &mesh, const Raycaster &raycaster, const math::Ray &ray)
+  {
+    Vector3 p0 = ray.origin(), p1 = ray.at(1);
+    p0.apply(mesh.matrixWorld());
+    p1.apply(mesh.matrixWorld());
+
+    _scale = p0.distanceTo(p1);
+    _offset = p0.distanceTo(raycaster.origin());
+  }
+
+  float operator()(float limit) const
+  {
+    if(limit < 0) return -1;
+    return (limit + _offset) / _scale;
+  }
+};
+
+}
+
+bool BufferGeometry::raycastBVH(const Mesh &mesh,
+                                const Material &material,
+                                size_t start,
+                                size_t end,
+                                const Raycaster &raycaster,
+                                const std::vector<math::Ray> &rays,
+                                IntersectList &intersects)
+{
+  //the tree is organized by triangle, ranges must be triangle aligned
+  if(start % 3 != 0) return false;
+
+  const BVH *bvh = this->bvh();
+  if(!bvh) return false;
+
+  Intersection intersection;
+  bool shrink = intersects.mode() != RaycastMode::All;
+
+  if(rays.size() > 1) {
+    //ray bundles are traced in packets, sharing traversal and triangle pre-tests
+    for(size_t first = 0; first < rays.size(); first += BVH::packetSize) {
+      unsigned count = (unsigned)std::min<size_t>(BVH::packetSize, rays.size() - first);
+      BVH::RayPacket packet(&rays[first], count);
+
+      std::vector<LocalLimit> limits;
+      if(shrink) {
+        for(unsigned lane = 0; lane < count; lane++) {
+          limits.emplace_back(mesh, raycaster, rays[first + lane]);
+          packet.limit[lane] = limits[lane](intersects.limit((unsigned)first + lane));
+        }
+      }
+
+      bvh->intersect(packet, [&](uint32_t triangle, unsigned mask) {
+        size_t i = (size_t)triangle * 3;
+        if(i < start || i >= end) return;
+
+        uint32_t a = _index ? _index->at(i) : i;
+        uint32_t b = _index ? _index->at(i + 1) : i + 1;
+        uint32_t c = _index ? _index->at(i + 2) : i + 2;
+
+        mask = packet.intersectTriangle(_position->item_at<math::Vector3>(a),
+                                        _position->item_at<math::Vector3>(b),
+                                        _position->item_at<math::Vector3>(c), mask);
+
+        for(unsigned lane = 0; mask; lane++, mask >>= 1) {
+          if(!(mask & 1)) continue;
+
+          unsigned rayIndex = (unsigned)first + lane;
+          intersectTriangle(mesh, material, raycaster, rays[rayIndex], rayIndex, _position, _uv, a, b, c, triangle,
+                            intersection, intersects);
+
+          if(shrink) packet.limit[lane] = limits[lane](intersects.limit(rayIndex));
+        }
+      });
+    }
+    return true;
+  }
+
+  unsigned rayIndex = 0;
+  for(const auto &ray : rays) {
+    LocalLimit limit(mesh, raycaster, ray);
+    float tmax = shrink ? limit(intersects.limit(rayIndex)) : std::numeric_limits<float>::infinity();
+
+    bvh->intersect(ray, [&](uint32_t triangle) {
+      size_t i = (size_t)triangle * 3;
+      if(i < start || i >= end) return;
+
+      uint32_t a = _index ? _index->at(i) : i;
+      uint32_t b = _index ? _index->at(i + 1) : i + 1;
+      uint32_t c = _index ? _index->at(i + 2) : i + 2;
+
+      intersectTriangle(mesh, material, raycaster, ray, rayIndex, _position, _uv, a, b, c, triangle,
+                        intersection, intersects);
+
+      if(shrink) tmax = limit(intersects.limit(rayIndex));
+    }, tmax);
+    rayIndex++;
+  }
+  return true;
+}
+
 void BufferGeometry::raycastIndex(const Mesh &mesh,
                              const Material &material,
                              size_t start,
@@ -91,20 +474,20 @@ void BufferGeometry::raycastIndex(const Mesh &mesh,
                              const std::vector<math::Ray> &rays,
                              IntersectList &intersects)
 {
+  if(raycastBVH(mesh, material, start, end, raycaster, rays, intersects)) return;
+
+  Intersection intersection;
   for (size_t i = start; i < end; i += 3) {
 
     uint32_t a = _index->get_x(i);
     uint32_t b = _index->get_x(i + 1);
     uint32_t c = _index->get_x(i + 2);
 
-    Intersection intersection;
     unsigned rayIndex = 0;
     for(const auto &ray : rays) {
-      if(checkBufferGeometryIntersection(mesh, material, raycaster, ray, _position, _uv, a, b, c, intersection)) {
-        intersection.faceIndex = (unsigned)std::floor(i / 3); // triangle number in indices buffer semantics
-        intersection.object = &const_cast<Mesh &>(mesh);
-        intersects.add(rayIndex, intersection);
-      }
+      // triangle number in indices buffer semantics
+      intersectTriangle(mesh, material, raycaster, ray, rayIndex, _position, _uv, a, b, c, (unsigned)(i / 3),
+                        intersection, intersects);
       rayIndex++;
     }
   }
@@ -117,20 +500,20 @@ void BufferGeometry::raycastPosition(const Mesh &mesh,
                      const std::vector<math::Ray> &rays,
                      IntersectList &intersects)
 {
+  if(raycastBVH(mesh, material, start, end, raycaster, rays, intersects)) return;
+
+  Intersection intersection;
   for (unsigned i = start; i < end; i += 3) {
 
     unsigned a = i;
     unsigned b = i + 1;
     unsigned c = i + 2;
 
-    Intersection intersection;
     unsigned rayIndex = 0;
     for(const auto &ray : rays) {
-      if (checkBufferGeometryIntersection(mesh, material, raycaster, ray, _position, _uv, a, b, c, intersection)) {
-        intersection.faceIndex = (unsigned)std::floor(i / 3); // triangle number in positions buffer semantics
-        intersection.object = &const_cast<Mesh &>(mesh);
-        intersects.add(rayIndex, intersection);
-      }
+      // triangle number in positions buffer semantics
+      intersectTriangle(mesh, material, raycaster, ray, rayIndex, _position, _uv, a, b, c, i / 3,
+                        intersection, intersects);
       rayIndex++;
     }
   }
@@ -220,15 +603,16 @@ void BufferGeometry::raycast(const Line &line,
 
         if ( distance < raycaster.near() || distance > raycaster.far() ) continue;
 
-        Intersection &intersection = intersects.add(rayIndex);
-        rayIndex++;
-
+        Intersection intersection;
         intersection.distance = distance;
         intersection.direction = ray.direction();
         // What do we want? intersection point on the ray or on the segment??
         // point: raycaster.ray.at( distance ),
         intersection.point = interSegment.apply(line.matrixWorld());
         intersection.faceIndex = i;
+
+        intersects.add(rayIndex, intersection);
+        rayIndex++;
       }
     }
   } else {
@@ -250,14 +634,15 @@ void BufferGeometry::raycast(const Line &line,
 
         if (distance < raycaster.near() || distance > raycaster.far()) continue;
 
-        Intersection &intersection = intersects.add(rayIndex);
-
+        Intersection intersection;
         intersection.distance = distance;
         intersection.direction = ray.direction();
         // What do we want? intersection point on the ray or on the segment??
         // point: raycaster.ray.at( distance ),
         intersection.point = interSegment.apply(line.matrixWorld());
         intersection.faceIndex = i;
+
+        intersects.add(rayIndex, intersection);
       }
     }
   }
@@ -275,10 +660,14 @@ BufferGeometry::BufferGeometry(Object3D::Ptr object, LinearGeometry &geometry)
   else if(Mesh *mesh = object->typer) {
     setFromMeshGeometry(geometry);
   }
+  if(geometry._dropAfterConversion) geometry.drop();
 }
 
 void BufferGeometry::setFromLinearGeometry(const LinearGeometry &geometry)
 {
+  _packed.reset();
+  _interleaved.reset();
+
   _position = attribute::copied<float, Vertex>(geometry._vertices);
   _color = attribute::copied<float, Color>(geometry._colors);
 
@@ -291,136 +680,245 @@ void BufferGeometry::setFromLinearGeometry(const LinearGeometry &geometry)
   }
 }
 
-void BufferGeometry::setFromMeshGeometry(LinearGeometry &geometry)
+namespace {
+
+/**
+ * write 3 items per face into target, which is reallocated unless it already has the right size
+ */
+template <typename Item, typename Func>
+void fillFaceVertices(BufferAttributeT<float>::Ptr &target, size_t faceCount, Func func)
 {
-  geometry._directGeometry = DirectGeometry::make(geometry);
+  if(!target || target->itemSize() != sizeof(Item) / sizeof(float) || target->itemCount() != faceCount * 3)
+    target = attribute::prealloc<float, Item>(faceCount * 3);
 
-  setFromDirectGeometry( geometry._directGeometry );
+  Item *items = target->data<Item>();
+
+  parallel::for_each(0, faceCount, [&](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; i++) func(i, items + i * 3);
+  }, BufferGeometry::conversionGrain);
+
+  target->needsUpdate();
 }
 
-void BufferGeometry::setFromDirectGeometry(DirectGeometry::Ptr geometry)
+void computeFaceGroups(const std::vector<Face3> &faces, std::vector<Group> &groups)
 {
-  _position = attribute::copied<float, Vertex>( geometry->vertices);
+  unsigned materialIndex = std::numeric_limits<unsigned>::max();
 
-  if (!geometry->normals.empty())
-    _normal = attribute::copied<float, Vertex>(geometry->normals);
+  groups.clear();
 
-  if (!geometry->colors.empty())
-    _color = attribute::copied<float, Color>(geometry->colors);
+  for (unsigned i = 0; i < faces.size(); i ++ ) {
 
-  if (!geometry->uvs.empty())
-    _uv = attribute::copied<float, UV>(geometry->uvs);
+    const auto &face = faces[ i ];
 
-  if (!geometry->uv2s.empty())
-    _uv2 = attribute::copied<float, UV>(geometry->uv2s);
+    if ( face.materialIndex != materialIndex ) {
 
-  if (!geometry->indices.empty())
-    _index = attribute::copied<uint32_t, Index>(geometry->indices);
+      materialIndex = face.materialIndex;
 
-  // groups
-  _groups = geometry->groups;
+      if (!groups.empty()) {
+        Group &group = groups.back();
+        group.count = ( i * 3 ) - group.start;
+      }
 
-  // morphs
-  for(const auto &morphTargets : geometry->morphTargetsPosition)
-    _morphAttributes_position.push_back(attribute::copied<float, Vertex>(morphTargets));
+      groups.emplace_back(i * 3, 0, materialIndex);
+    }
+  }
 
-  for(const auto &morphTargets : geometry->morphTargetsNormal)
-    _morphAttributes_normal.push_back(attribute::copied<float, Vertex>(morphTargets));
+  if (!groups.empty()) {
+    Group &group = groups.back();
+    group.count = ((unsigned)faces.size() * 3) - group.start;
+  }
+}
 
-  // skinning
-  if (!geometry->skinIndices.empty())
-    _skinIndices = attribute::copied<float, math::Vector4>(geometry->skinIndices);
+}
+
+void BufferGeometry::setFromMeshGeometry(const LinearGeometry &geometry, unsigned parts)
+{
+  const auto &faces = geometry._faces;
+  const auto &vertices = geometry._vertices;
+  const auto &faceVertexUvs = geometry._faceVertexUvs;
+  size_t faceCount = faces.size();
+
+  if(parts & Positions) {
+
+    fillFaceVertices<Vertex>(_position, faceCount, [&](size_t i, Vertex *out) {
+      const Face3 &face = faces[i];
+      out[0] = vertices[face.a];
+      out[1] = vertices[face.b];
+      out[2] = vertices[face.c];
+    });
+
+    //empty bounds are computed on demand
+    if(parts == AllParts) {
+      _boundingBox = geometry._boundingBox;
+      _boundingSphere = geometry._boundingSphere;
+    }
+    else {
+      _boundingBox.makeEmpty();
+      _boundingSphere = math::Sphere();
+    }
+  }
 
-  if (!geometry->skinWeights.empty())
-    _skinWeight = attribute::copied<float, math::Vector4>(geometry->skinWeights);
+  if(parts & Normals) {
 
-  _boundingSphere = geometry->boundingSphere();
+    fillFaceVertices<Vertex>(_normal, faceCount, [&](size_t i, Vertex *out) {
+      const Face3 &face = faces[i];
+      if(face.vertexNormals.size() == 3) {
+        out[0] = face.vertexNormals[0];
+        out[1] = face.vertexNormals[1];
+        out[2] = face.vertexNormals[2];
+      }
+      else {
+        out[0] = out[1] = out[2] = face.normal;
+      }
+    });
+  }
 
-  _boundingBox = geometry->boundingBox();
-}
+  if(parts & Colors) {
 
-BufferGeometry &BufferGeometry::update(Object3D::Ptr object, LinearGeometry *geometry)
-{
-  Mesh *mesh = object->typer;
-  if ( mesh ) {
+    fillFaceVertices<Color>(_color, faceCount, [&](size_t i, Color *out) {
+      const Face3 &face = faces[i];
+      if(face.vertexColors.size() == 3) {
+        out[0] = face.vertexColors[0];
+        out[1] = face.vertexColors[1];
+        out[2] = face.vertexColors[2];
+      }
+      else {
+        out[0] = out[1] = out[2] = face.color;
+      }
+    });
+  }
 
-    DirectGeometry::Ptr direct = geometry->_directGeometry;
+  if(parts & UVs) {
 
-    if(geometry->_elementsNeedUpdate) {
+    BufferAttributeT<float>::Ptr *targets[] = {&_uv, &_uv2};
 
-      direct = nullptr;
-      geometry->_elementsNeedUpdate = false;
-    }
+    for(unsigned layer = 0; layer < 2; layer++) {
 
-    if (!direct) {
+      const std::vector<UV_Array> &uvs = faceVertexUvs[layer];
+      BufferAttributeT<float>::Ptr &target = *targets[layer];
 
-      setFromMeshGeometry(*geometry);
-      return *this;
+      if(uvs.empty()) {
+        target.reset();
+        continue;
+      }
+      //faces without uvs get zeroes
+      fillFaceVertices<UV>(target, faceCount, [&](size_t i, UV *out) {
+        if(i < uvs.size()) {
+          out[0] = uvs[i][0];
+          out[1] = uvs[i][1];
+          out[2] = uvs[i][2];
+        }
+        else {
+          out[0] = out[1] = out[2] = UV();
+        }
+      });
     }
+  }
 
-    direct->verticesNeedUpdate = geometry->_verticesNeedUpdate;
-    direct->normalsNeedUpdate = geometry->_normalsNeedUpdate;
-    direct->colorsNeedUpdate = geometry->_colorsNeedUpdate;
-    direct->uvsNeedUpdate = geometry->_uvsNeedUpdate;
-    direct->groupsNeedUpdate = geometry->_groupsNeedUpdate;
+  if(parts & Groups) {
 
-    geometry->_verticesNeedUpdate = false;
-    geometry->_normalsNeedUpdate = false;
-    geometry->_colorsNeedUpdate = false;
-    geometry->_uvsNeedUpdate = false;
-    geometry->_groupsNeedUpdate = false;
+    computeFaceGroups(faces, _groups);
+  }
 
-    if ( direct->verticesNeedUpdate ) {
+  if(parts & Morphs) {
 
-      if ( _position ) {
+    const auto &morphTargets = geometry._morphTargets;
+    _morphAttributes_position.resize(morphTargets.size());
 
-        _position = attribute::copied<float, Vertex>(direct->vertices);
-        _position->needsUpdate();
-      }
+    for(size_t j = 0; j < morphTargets.size(); j++) {
+
+      const auto &morphVertices = morphTargets[j].vertices;
 
-      direct->verticesNeedUpdate = false;
+      fillFaceVertices<Vertex>(_morphAttributes_position[j], faceCount, [&](size_t i, Vertex *out) {
+        const Face3 &face = faces[i];
+        out[0] = morphVertices[face.a];
+        out[1] = morphVertices[face.b];
+        out[2] = morphVertices[face.c];
+      });
     }
 
-    if (direct->normalsNeedUpdate) {
+    const auto &morphNormals = geometry._morphNormals;
+    _morphAttributes_normal.resize(morphNormals.size());
 
-      if (_normal) {
+    for(size_t j = 0; j < morphNormals.size(); j++) {
 
-        _normal = attribute::copied<float, Vertex>(direct->normals);
-        _normal->needsUpdate();
-      }
+      const auto &vertexNormals = morphNormals[j].vertexNormals;
 
-      direct->normalsNeedUpdate = false;
+      fillFaceVertices<Vertex>(_morphAttributes_normal[j], faceCount, [&](size_t i, Vertex *out) {
+        out[0] = vertexNormals[i][0];
+        out[1] = vertexNormals[i][1];
+        out[2] = vertexNormals[i][2];
+      });
     }
+  }
 
-    if (direct->colorsNeedUpdate ) {
-
-      if (_color) {
+  if(parts & Skins) {
 
-        _color = attribute::copied<float, Color>(direct->colors);
-        _color->needsUpdate();
-      }
+    const auto &skinIndices = geometry._skinIndices;
+    const auto &skinWeights = geometry._skinWeights;
 
-      direct->colorsNeedUpdate = false;
+    if(skinIndices.size() == vertices.size()) {
+      fillFaceVertices<math::Vector4>(_skinIndices, faceCount, [&](size_t i, math::Vector4 *out) {
+        const Face3 &face = faces[i];
+        out[0] = skinIndices[face.a];
+        out[1] = skinIndices[face.b];
+        out[2] = skinIndices[face.c];
+      });
+    }
+    else _skinIndices.reset();
+
+    if(skinWeights.size() == vertices.size()) {
+      fillFaceVertices<math::Vector4>(_skinWeight, faceCount, [&](size_t i, math::Vector4 *out) {
+        const Face3 &face = faces[i];
+        out[0] = skinWeights[face.a];
+        out[1] = skinWeights[face.b];
+        out[2] = skinWeights[face.c];
+      });
     }
-    if (direct->uvsNeedUpdate) {
+    else _skinWeight.reset();
+  }
 
-      if (_uv) {
+  if(parts & (Positions | Normals | Colors | UVs)) {
+    _packed.reset();
+    _interleaved.reset();
+  }
+}
 
-        _uv = attribute::copied<float, UV>(direct->uvs);
-        _uv->needsUpdate();
-      }
+BufferGeometry &BufferGeometry::update(Object3D::Ptr object, LinearGeometry *geometry)
+{
+  //nothing left to convert
+  if(geometry->_dropped) return *this;
 
-      direct->uvsNeedUpdate = false;
-    }
-    if ( direct->groupsNeedUpdate && direct) {
+  Mesh *mesh = object->typer;
+  if ( mesh ) {
 
-      direct->computeGroups( *geometry );
-      _groups = direct->groups;
+    unsigned parts = 0;
 
-      direct->groupsNeedUpdate = false;
+    if(geometry->_elementsNeedUpdate) parts = AllParts;
+    else {
+      if(geometry->_verticesNeedUpdate && _position) parts |= Positions;
+      if(geometry->_normalsNeedUpdate && _normal) parts |= Normals;
+      if(geometry->_colorsNeedUpdate && _color) parts |= Colors;
+      if(geometry->_uvsNeedUpdate && (_uv || _uv2)) parts |= UVs;
+      if(geometry->_groupsNeedUpdate) parts |= Groups;
     }
+
+    geometry->_elementsNeedUpdate = false;
+    geometry->_verticesNeedUpdate = false;
+    geometry->_normalsNeedUpdate = false;
+    geometry->_colorsNeedUpdate = false;
+    geometry->_uvsNeedUpdate = false;
+    geometry->_groupsNeedUpdate = false;
+
+    if(parts) setFromMeshGeometry(*geometry, parts);
   }
   else {
+    //the replaced attributes invalidate the render copies
+    if(geometry->_verticesNeedUpdate || geometry->_normalsNeedUpdate || geometry->_colorsNeedUpdate) {
+      _packed.reset();
+      _interleaved.reset();
+    }
+
     if ( geometry->_verticesNeedUpdate ) {
 
       if ( _position ) {
@@ -476,79 +974,212 @@ void BufferGeometry::normalizeNormals()
 
 void BufferGeometry::computeVertexNormals()
 {
-  if(_position) {
+  _packed.reset();
+  _interleaved.reset();
 
-    if (_normal)
-      // reset existing normals to zero
-      _normal->clear();
-    else
-      _normal = attribute::prealloc<float, Vector3>(_position->itemCount());
+  if(!_position) return;
 
+  size_t vertexCount = _position->itemCount();
+  if(!_normal || _normal->itemSize() != 3 || _normal->itemCount() != vertexCount)
+    _normal = attribute::prealloc<float, Vector3>(vertexCount);
 
-    // indexed elements
-    if ( _index ) {
-      //var indices = index.array;
+  const float *position = _position->data_t();
+  unsigned stride = _position->itemSize();
+  Sum3 *normal = _normal->data<Sum3>();
 
-      if (_groups.empty()) {
+  //not normalized, so larger faces weigh more
+  auto faceNormal = [&](size_t a, size_t b, size_t c) {
+    const float *pA = position + a * stride, *pB = position + b * stride, *pC = position + c * stride;
 
-        addGroup( 0, _index->size());
-      }
+    Sum3 cb(pC[0] - pB[0], pC[1] - pB[1], pC[2] - pB[2]);
+    Sum3 ab(pA[0] - pB[0], pA[1] - pB[1], pA[2] - pB[2]);
+    return cb.cross( ab );
+  };
 
-      for (unsigned j = 0, jl = _groups.size(); j < jl; ++ j ) {
+  // indexed elements
+  if ( _index ) {
 
-        Group &group = _groups[ j ];
+    if (_groups.empty()) {
 
-        for (unsigned i = group.start, il = group.start + group.count; i < il; i += 3 ) {
+      addGroup( 0, _index->size());
+    }
 
-          unsigned vA = _index->at(i) * 3;
-          unsigned vB = _index->at(i+1) * 3;
-          unsigned vC = _index->at(i+2) * 3;
+    const uint32_t *index = _index->data_t();
 
-          const Vector3 &pA = _position->item_at<Vector3>(vA);
-          const Vector3 &pB = _position->item_at<Vector3>(vB);
-          const Vector3 &pC = _position->item_at<Vector3>(vC);
+    accumulate(normal, index, vertexCount, TriangleRanges(_groups, _index->size()), [&](size_t i, Sum3 &face) {
+      face = faceNormal(index[i], index[i + 1], index[i + 2]);
+      return true;
+    });
 
-          Vector3 cb = pC - pB;
-          Vector3 ab = pA - pB;
-          cb.cross( ab );
+    parallel::for_each(0, vertexCount, [&](size_t begin, size_t end) {
+      for(size_t v = begin; v < end; v++) normal[v].normalize();
+    }, vertexGrain);
 
-          _normal->at(vA) += cb.x();
-          _normal->at(vA + 1) += cb.y();
-          _normal->at(vA + 2) += cb.z();
+  } else {
+    // non-indexed elements (unconnected triangle soup)
+    size_t triangleCount = vertexCount / 3;
 
-          _normal->at(vB) += cb.x();
-          _normal->at(vB + 1) += cb.y();
-          _normal->at(vB + 2) += cb.z();
+    parallel::for_each(0, triangleCount, [&](size_t begin, size_t end) {
 
-          _normal->at(vC) += cb.x();
-          _normal->at(vC + 1) += cb.y();
-          _normal->at(vC + 2) += cb.z();
-        }
+      for(size_t i = begin * 3; i < end * 3; i += 3) {
+        normal[i] = normal[i + 1] = normal[i + 2] = faceNormal(i, i + 1, i + 2).normalize();
       }
+    }, triangleGrain);
+
+    for(size_t v = triangleCount * 3; v < vertexCount; v++) normal[v] = Sum3();
+  }
+
+  _normal->needsUpdate();
+}
+
+bool BufferGeometry::computeTangents()
+{
+  if(!_position || !_normal || !_uv) return false;
 
-    } else {
-      // non-indexed elements (unconnected triangle soup)
-      for (unsigned i = 0, il = _position->itemCount(); i < il; i += 3 ) {
+  size_t vertexCount = _position->itemCount();
+  if(_normal->itemCount() != vertexCount || _uv->itemCount() != vertexCount) return false;
 
-        const Vector3 &pA = _position->item_at<Vector3>(i);
-        const Vector3 &pB = _position->item_at<Vector3>(i+1);
-        const Vector3 &pC = _position->item_at<Vector3>(i+2);
+  if(!_tangents || _tangents->itemSize() != 4 || _tangents->itemCount() != vertexCount)
+    _tangents = attribute::prealloc<float, Vector4>(vertexCount);
 
-        Vector3 cb = pC - pB;
-        Vector3 ab = pA - pB;
-        cb.cross( ab );
+  const float *position = _position->data_t();
+  const float *normal = _normal->data_t();
+  const float *uv = _uv->data_t();
+  unsigned stride = _position->itemSize(), normalStride = _normal->itemSize(), uvStride = _uv->itemSize();
+  float *tangent = _tangents->data<float>();
 
-        for(unsigned ix=0; ix < 3; ix++) {
-          _normal->set_x(ix, cb.x());
-          _normal->set_y(ix, cb.y());
-          _normal->set_z(ix, cb.z());
-        }
+  //texture space directions of u and v. Not normalized, so larger faces weigh more
+  auto faceDirections = [&](size_t a, size_t b, size_t c, TangentSum &sum) {
+    const float *pA = position + a * stride, *pB = position + b * stride, *pC = position + c * stride;
+    const float *wA = uv + a * uvStride, *wB = uv + b * uvStride, *wC = uv + c * uvStride;
+
+    float s1 = wB[0] - wA[0], s2 = wC[0] - wA[0];
+    float t1 = wB[1] - wA[1], t2 = wC[1] - wA[1];
+
+    float det = s1 * t2 - s2 * t1;
+    if(det == 0) return false;
+
+    float r = 1.0f / det;
+    for(unsigned k = 0; k < 3; k++) {
+      float e1 = pB[k] - pA[k], e2 = pC[k] - pA[k];
+      (&sum.s.x)[k] = (e1 * t2 - e2 * t1) * r;
+      (&sum.t.x)[k] = (e2 * s1 - e1 * s2) * r;
+    }
+    return true;
+  };
+
+  //orthogonalize against the normal. w is the handedness of the bitangent
+  auto vertexTangent = [&](size_t v, const TangentSum &sum) {
+    const float *nv = normal + v * normalStride;
+    Sum3 n(nv[0], nv[1], nv[2]);
+
+    float d = n.dot(sum.s);
+    Sum3 t(sum.s.x - n.x * d, sum.s.y - n.y * d, sum.s.z - n.z * d);
+    t.normalize();
+
+    float *out = tangent + v * 4;
+    out[0] = t.x;
+    out[1] = t.y;
+    out[2] = t.z;
+    out[3] = n.cross(sum.s).dot(sum.t) < 0 ? -1.0f : 1.0f;
+  };
+
+  if ( _index ) {
+
+    std::vector<Group> groups = _groups;
+    if(groups.empty()) groups.emplace_back(0, _index->size(), 0);
+
+    const uint32_t *index = _index->data_t();
+    std::vector<TangentSum> sums(vertexCount);
+
+    accumulate(sums.data(), index, vertexCount, TriangleRanges(groups, _index->size()), [&](size_t i, TangentSum &face) {
+      return faceDirections(index[i], index[i + 1], index[i + 2], face);
+    });
+
+    parallel::for_each(0, vertexCount, [&](size_t begin, size_t end) {
+      for(size_t v = begin; v < end; v++) vertexTangent(v, sums[v]);
+    }, vertexGrain);
+  }
+  else {
+    size_t triangleCount = vertexCount / 3;
+
+    parallel::for_each(0, triangleCount, [&](size_t begin, size_t end) {
+
+      for(size_t i = begin * 3; i < end * 3; i += 3) {
+        TangentSum sum;
+        faceDirections(i, i + 1, i + 2, sum);
+
+        for(size_t v = i; v < i + 3; v++) vertexTangent(v, sum);
       }
+    }, triangleGrain);
+
+    for(size_t v = triangleCount * 3; v < vertexCount; v++) vertexTangent(v, TangentSum());
+  }
+
+  _tangents->needsUpdate();
+  return true;
+}
+
+bool BufferGeometry::interleave()
+{
+  _interleaved.reset();
+  if(!_position) return false;
+
+  size_t count = _position->itemCount();
+
+  //dynamic attributes stay separate, the copy would not follow their updates
+  BufferAttributeT<float>::Ptr sources[] = {_position, _normal, _uv, _color};
+  unsigned offsets[4] = {0, 0, 0, 0};
+  unsigned stride = 0, interleaved = 0;
+  for(unsigned i = 0; i < 4; i++) {
+    if(sources[i] && !sources[i]->dynamic && sources[i]->itemCount() == count) {
+      offsets[i] = stride;
+      stride += sources[i]->itemSize();
+      interleaved++;
+    }
+    else sources[i].reset();
+  }
+  if(interleaved < 2) return false;
+
+  std::vector<float> array(count * stride);
+  for(unsigned i = 0; i < 4; i++) {
+    if(!sources[i]) continue;
+
+    const float *data = sources[i]->data_t();
+    unsigned itemSize = sources[i]->itemSize();
+    for(size_t v = 0; v < count; v++) {
+      memcpy(&array[v * stride + offsets[i]], data + v * itemSize, itemSize * sizeof(float));
+    }
+  }
+
+  _interleaved = std::make_shared<InterleavedAttributes>();
+  _interleaved->buffer = InterleavedBuffer::make(array, stride);
+
+  InterleavedBufferAttribute::Ptr *targets[] = {&_interleaved->position, &_interleaved->normal,
+                                                &_interleaved->uv, &_interleaved->color};
+  for(unsigned i = 0; i < 4; i++) {
+    if(sources[i]) {
+      _interleaved->versions.add(sources[i]);
+      *targets[i] = InterleavedBufferAttribute::make(_interleaved->buffer, sources[i]->itemSize(), offsets[i],
+                                                     sources[i]->normalized());
     }
+  }
+  return true;
+}
 
-    normalizeNormals();
-    _normal->needsUpdate();
+bool BufferGeometry::updateCopies()
+{
+  bool updated = false;
+
+  if(_packed && !_packed->versions.current()) {
+    _packed = _packed->repack ? _packed->repack(*this) : nullptr;
+    updated = true;
+  }
+  if(_interleaved && !_interleaved->versions.current()) {
+    interleave();
+    updated = true;
   }
+  return updated;
 }
 
 }
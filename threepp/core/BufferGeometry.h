@@ -11,6 +11,8 @@
 #include <threepp/util/osdecl.h>
 #include "Geometry.h"
 #include "BufferAttribute.h"
+#include "InterleavedBufferAttribute.h"
+#include "BVH.h"
 
 namespace three {
 enum class IndexedAttributeName : size_t
@@ -39,11 +41,79 @@ namespace three {
 
 class Object3D;
 class LinearGeometry;
-class DirectGeometry;
+class BufferGeometry;
 
 enum class AttributeName
 {
-  index, color, position, normal, uv, uv2, lineDistances, unknown
+  index, color, position, normal, uv, uv2, lineDistances, skinIndex, skinWeight, unknown
+};
+
+/**
+ * the float attributes a render copy was made from, with their versions at that time
+ */
+struct AttributeVersions
+{
+  std::vector<std::pair<BufferAttribute::Ptr, unsigned>> sources;
+
+  void add(const BufferAttribute::Ptr &attribute)
+  {
+    if(attribute) sources.emplace_back(attribute, attribute->version());
+  }
+
+  /**
+   * @return false if any source was modified since
+   */
+  bool current() const
+  {
+    for(const auto &source : sources) {
+      if(source.first->version() != source.second) return false;
+    }
+    return true;
+  }
+};
+
+/**
+ * compact copies of vertex attributes, uploaded and rendered in place of the float attributes. The
+ * float attributes remain the reference for everything computed on the CPU. See VertexPacking
+ */
+struct PackedAttributes
+{
+  //normalized unsigned 16 bit, 4 components. Decoded by positionOffset + position * positionScale
+  BufferAttribute::Ptr position;
+  math::Vector3 positionOffset;
+  math::Vector3 positionScale {1, 1, 1};
+
+  //octahedral encoding, normalized signed 8 or 16 bit, 2 components
+  BufferAttribute::Ptr normal;
+
+  //half float
+  BufferAttribute::Ptr uv;
+
+  //normalized unsigned 8 bit
+  BufferAttribute::Ptr color;
+
+  AttributeVersions versions;
+
+  using Ptr = std::shared_ptr<PackedAttributes>;
+
+  //packs the geometry again with the same options, once the float attributes were modified
+  std::function<Ptr(const BufferGeometry &)> repack;
+};
+
+/**
+ * position, normal, uv and color copied into one strided buffer, so the GPU fetches a vertex from one
+ * place and only one buffer is bound per draw. Like PackedAttributes, a render copy of the float
+ * attributes. See BufferGeometry::interleave
+ */
+struct InterleavedAttributes
+{
+  InterleavedBuffer::Ptr buffer;
+
+  InterleavedBufferAttribute::Ptr position, normal, uv, color;
+
+  AttributeVersions versions;
+
+  using Ptr = std::shared_ptr<InterleavedAttributes>;
 };
 
 class DLX BufferGeometry : public Geometry
@@ -70,22 +140,30 @@ class DLX BufferGeometry : public Geometry
 
   UpdateRange _drawRange;
 
+  PackedAttributes::Ptr _packed;
+  InterleavedAttributes::Ptr _interleaved;
+
+  //raycasting acceleration structure, built on demand
+  BVH::Ptr _bvh;
+  bool _useBVH = true;
+
+  //parts of a mesh LinearGeometry written by setFromMeshGeometry
+  enum MeshParts : unsigned
+  {
+    Positions = 1, Normals = 2, Colors = 4, UVs = 8, Groups = 16, Morphs = 32, Skins = 64, AllParts = 127
+  };
+
   void setFromLinearGeometry(const LinearGeometry &geometry);
-  void setFromMeshGeometry(LinearGeometry &geometry);
-  void setFromDirectGeometry(std::shared_ptr<DirectGeometry> geometry);
+
+  /**
+   * expand the faces into non-indexed attributes in one pass, writing directly into the attribute
+   * storage. Attributes of matching size are overwritten in place. Face ranges are converted in parallel
+   */
+  void setFromMeshGeometry(const LinearGeometry &geometry, unsigned parts=AllParts);
 
 protected:
 
-  BufferGeometry &computeBoundingBox() override
-  {
-    if (_position) {
-      _boundingBox = _position->box3();
-    }
-    else {
-      _boundingBox.makeEmpty();
-    }
-    return *this;
-  }
+  BufferGeometry &computeBoundingBox() override;
 
   BufferGeometry &computeBoundingSphere() override;
 
@@ -116,9 +194,22 @@ protected:
                        const std::vector<math::Ray> &rays,
                        IntersectList &intersects);
 
+  bool raycastBVH(const Mesh &mesh,
+                  const three::Material &material,
+                  size_t start, size_t end,
+                  const Raycaster &raycaster,
+                  const std::vector<math::Ray> &rays,
+                  IntersectList &intersects);
+
 public:
   using Ptr = std::shared_ptr<BufferGeometry>;
 
+  //geometries with fewer triangles are raycast without BVH
+  static const size_t bvhMinTriangles = 64;
+
+  //faces per thread when converting a LinearGeometry
+  static const size_t conversionGrain = 4096;
+
   static Ptr make(const BufferAttributeT<float>::Ptr &position=nullptr, const BufferAttributeT<float>::Ptr &color=nullptr) {
     return Ptr(new BufferGeometry(position, color));
   }
@@ -145,13 +236,28 @@ public:
     _indexedAttributes = geom._indexedAttributes;
 
     _drawRange = geom._drawRange;
+    _packed = geom._packed;
+    _interleaved = geom._interleaved;
     return *this;
   }
 
   BufferGeometry &update(std::shared_ptr<Object3D> object, LinearGeometry *geometry);
 
+  /**
+   * compute area weighted vertex normals. The face normals are computed in parallel, then each vertex
+   * range sums the normals of its vertices' faces in triangle order. The result thus does not depend
+   * on the number of threads
+   */
   void computeVertexNormals();
 
+  /**
+   * compute per-vertex tangents from position, normal and uv, orthogonalized against the normal. The
+   * tangent attribute has 4 components, w holding the handedness: bitangent = cross(normal, tangent) * w
+   *
+   * @return false if one of the required attributes is missing or has the wrong size
+   */
+  bool computeTangents();
+
   void normalizeNormals();
 
   bool useMorphing() const override
@@ -161,6 +267,27 @@ public:
 
   const UpdateRange &drawRange() const {return _drawRange;}
 
+  /**
+   * enable or disable the bounding volume hierarchy used for raycasting triangle meshes. It is enabled by
+   * default and built on first use
+   */
+  BufferGeometry &setUseBVH(bool use)
+  {
+    _useBVH = use;
+    if(!use) _bvh.reset();
+    return *this;
+  }
+
+  /**
+   * @return the raycasting BVH, built or updated to match the current index and position attributes, or
+   * nullptr if disabled or the geometry is too small
+   */
+  const BVH *bvh();
+
+  /**
+   * the triangle or line index. It is always 32 bit on the CPU; the renderer uploads it as 16 bit
+   * whenever all indices fit (see gl::Attributes)
+   */
   const BufferAttributeT<uint32_t>::Ptr &index() const {return _index;}
 
   BufferAttributeT<uint32_t>::Ptr &getIndex() {return _index;}
@@ -181,10 +308,30 @@ public:
 
   const BufferAttributeT<float>::Ptr bitangents() const {return _bitangents;}
 
+  const BufferAttributeT<float>::Ptr &skinIndices() const {return _skinIndices;}
+
+  const BufferAttributeT<float>::Ptr &skinWeights() const {return _skinWeight;}
+
   const std::vector<BufferAttributeT<float>::Ptr> &morphPositions() const {return _morphAttributes_position;}
 
   const std::vector<BufferAttributeT<float>::Ptr> &morphNormals() const {return _morphAttributes_normal;}
 
+  std::vector<BufferAttributeT<float>::Ptr> &getMorphPositions() {return _morphAttributes_position;}
+
+  std::vector<BufferAttributeT<float>::Ptr> &getMorphNormals() {return _morphAttributes_normal;}
+
+  BufferGeometry &addMorphPosition(const BufferAttributeT<float>::Ptr &position)
+  {
+    _morphAttributes_position.push_back(position);
+    return *this;
+  }
+
+  BufferGeometry &addMorphNormal(const BufferAttributeT<float>::Ptr &normal)
+  {
+    _morphAttributes_normal.push_back(normal);
+    return *this;
+  }
+
   void addAttribute(IndexedAttributeName attribute, size_t index, BufferAttributeT<float>::Ptr value) {
     IndexedAttributeKey key = {attribute, index};
     _indexedAttributes[key] = value;
@@ -194,6 +341,10 @@ public:
     _indexedAttributes.erase({attribute, index});
   }
 
+  const std::unordered_map<IndexedAttributeKey, BufferAttributeT<float>::Ptr> &indexedAttributes() const {
+    return _indexedAttributes;
+  }
+
   void setDrawRange(size_t start, size_t count ) {
 
     _drawRange.start = start;
@@ -208,24 +359,32 @@ public:
   BufferGeometry &setPosition(const BufferAttributeT<float>::Ptr &position)
   {
     _position = position;
+    _packed.reset();
+    _interleaved.reset();
     return *this;
   }
 
   BufferGeometry &setNormal(const BufferAttributeT<float>::Ptr &normal)
   {
     _normal = normal;
+    _packed.reset();
+    _interleaved.reset();
     return *this;
   }
 
   BufferGeometry &setColor(const BufferAttributeT<float>::Ptr &color)
   {
     _color = color;
+    _packed.reset();
+    _interleaved.reset();
     return *this;
   }
 
   BufferGeometry &setUV(const BufferAttributeT<float>::Ptr &uv)
   {
     _uv = uv;
+    _packed.reset();
+    _interleaved.reset();
     return *this;
   }
 
@@ -253,8 +412,97 @@ public:
     return *this;
   }
 
+  BufferGeometry &setSkinIndices(const BufferAttributeT<float>::Ptr &skinIndices)
+  {
+    _skinIndices = skinIndices;
+    return *this;
+  }
+
+  BufferGeometry &setSkinWeights(const BufferAttributeT<float>::Ptr &skinWeights)
+  {
+    _skinWeight = skinWeights;
+    return *this;
+  }
+
+  /**
+   * set compact GPU representations of the vertex attributes. They are dropped when any of the
+   * corresponding float attributes is replaced or transformed, and rebuilt by updateCopies() after
+   * in-place modifications
+   */
+  BufferGeometry &setPacked(const PackedAttributes::Ptr &packed)
+  {
+    _packed = packed;
+    return *this;
+  }
+
+  const PackedAttributes::Ptr &packed() const {return _packed;}
+
+  /**
+   * copy position, normal, uv and color into one interleaved buffer which is rendered in their place.
+   * Packed attributes take precedence. The copy is dropped under the same conditions as the packed
+   * attributes
+   *
+   * @return true if there were attributes to interleave
+   */
+  bool interleave();
+
+  BufferGeometry &setInterleaved(const InterleavedAttributes::Ptr &interleaved)
+  {
+    _interleaved = interleaved;
+    return *this;
+  }
+
+  const InterleavedAttributes::Ptr &interleaved() const {return _interleaved;}
+
+  /**
+   * rebuild the packed and interleaved copies if any of their float attributes was modified since,
+   * as signalled by needsUpdate(). Called by the renderer before uploading
+   *
+   * @return true if a copy was rebuilt or dropped
+   */
+  bool updateCopies();
+
+  /**
+   * @return the attribute to be rendered for the given name, packed or interleaved if available
+   */
   BufferAttribute::Ptr getAttribute(AttributeName name)
   {
+    if(_packed) {
+      switch(name) {
+        case AttributeName::position:
+          if(_packed->position) return _packed->position;
+          break;
+        case AttributeName::normal:
+          if(_packed->normal) return _packed->normal;
+          break;
+        case AttributeName::uv:
+          if(_packed->uv) return _packed->uv;
+          break;
+        case AttributeName::color:
+          if(_packed->color) return _packed->color;
+          break;
+        default:
+          break;
+      }
+    }
+    if(_interleaved) {
+      switch(name) {
+        case AttributeName::position:
+          if(_interleaved->position) return _interleaved->position;
+          break;
+        case AttributeName::normal:
+          if(_interleaved->normal) return _interleaved->normal;
+          break;
+        case AttributeName::uv:
+          if(_interleaved->uv) return _interleaved->uv;
+          break;
+        case AttributeName::color:
+          if(_interleaved->color) return _interleaved->color;
+          break;
+        default:
+          break;
+      }
+    }
     switch(name) {
       case AttributeName::normal:
         return _normal;
@@ -270,6 +518,10 @@ public:
         return _color;
       case AttributeName::position:
         return _position;
+      case AttributeName::skinIndex:
+        return _skinIndices;
+      case AttributeName::skinWeight:
+        return _skinWeight;
       default:
         return nullptr;
     }
@@ -277,6 +529,9 @@ public:
 
   BufferGeometry &apply(const math::Matrix4 &matrix) override
   {
+    _packed.reset();
+    _interleaved.reset();
+
     if (_position) {
       _position->apply(matrix);
       _position->needsUpdate();
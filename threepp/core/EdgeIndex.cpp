@@ -0,0 +1,340 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "EdgeIndex.h"
+#include "VertexWelder.h"
+#include <cmath>
+#include <algorithm>
+#include <threepp/math/Math.h>
+
+namespace three {
+
+using namespace std;
+
+namespace {
+
+const uint32_t none = 0xffffffff;
+
+inline uint64_t mix(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+inline size_t capacityFor(size_t count)
+{
+  size_t capacity = 16;
+  while(capacity < count * 2) capacity *= 2;
+  return capacity;
+}
+
+//open addressing table of edge numbers, keyed by sorted vertex pair
+class EdgeTable
+{
+  struct Entry
+  {
+    uint32_t a, b, edge;
+  };
+
+  vector<Entry> _entries;
+  size_t _mask = 0;
+  size_t _count = 0;
+
+  size_t slot(uint32_t a, uint32_t b) const
+  {
+    //triangles near each other mostly use vertices with close numbers, so consecutive vertex sums share
+    //a block of entries and probes mostly hit the cache. Blocks are placed at random, so any numbering
+    //spreads evenly. Unlike the lower vertex, the sum also separates the edges of a fan
+    uint64_t sum = (uint64_t)a + b;
+    size_t slot = (mix(sum >> 3) << 4 | (sum & 7) << 1) & _mask;
+    while(_entries[slot].edge != none && (_entries[slot].a != a || _entries[slot].b != b))
+      slot = (slot + 1) & _mask;
+    return slot;
+  }
+
+  void grow()
+  {
+    vector<Entry> entries(_entries.size() * 2, Entry {0, 0, none});
+    _entries.swap(entries);
+    _mask = _entries.size() - 1;
+
+    for(const Entry &entry : entries) {
+      if(entry.edge != none) _entries[slot(entry.a, entry.b)] = entry;
+    }
+  }
+
+public:
+  //prepare for about count edges, forgetting all entries
+  void reset(size_t count)
+  {
+    //the allocation is kept between runs
+    _entries.assign(capacityFor(count), Entry {0, 0, none});
+    _mask = _entries.size() - 1;
+    _count = 0;
+  }
+
+  /**
+   * @return the number of the edge between a and b, or edge if the pair was not found and was inserted
+   */
+  uint32_t insert(uint32_t a, uint32_t b, uint32_t edge)
+  {
+    if(a > b) swap(a, b);
+
+    size_t s = slot(a, b);
+    if(_entries[s].edge != none) return _entries[s].edge;
+
+    _entries[s] = Entry {a, b, edge};
+    if(++_count * 2 > _entries.size()) grow();
+    return edge;
+  }
+};
+
+//@return false for degenerate triangles
+bool faceNormal(const float *position, uint32_t a, uint32_t b, uint32_t c, float *normal)
+{
+  const float *pa = position + a * 3, *pb = position + b * 3, *pc = position + c * 3;
+
+  float u[3] = {pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2]};
+  float v[3] = {pc[0] - pa[0], pc[1] - pa[1], pc[2] - pa[2]};
+
+  normal[0] = u[1] * v[2] - u[2] * v[1];
+  normal[1] = u[2] * v[0] - u[0] * v[2];
+  normal[2] = u[0] * v[1] - u[1] * v[0];
+
+  float length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+  if(!(length > 0)) return false;
+
+  for(unsigned i = 0; i < 3; i++) normal[i] /= length;
+  return true;
+}
+
+}
+
+EdgeIndex::EdgeIndex(const BufferGeometry &geometry, const Options &options)
+   : _position(geometry.position()), _index(geometry.index()), _morphPositions(geometry.morphPositions()),
+     _skinIndices(geometry.skinIndices()), _skinWeights(geometry.skinWeights()), _options(options)
+{
+  if(options.splitGroups) _groups = geometry.groups();
+}
+
+bool EdgeIndex::builtFor(const BufferGeometry &geometry, const Options &options) const
+{
+  if(_position != geometry.position() || _index != geometry.index()
+     || _morphPositions != geometry.morphPositions()
+     || _skinIndices != geometry.skinIndices() || _skinWeights != geometry.skinWeights()
+     || _options.creaseAngle != options.creaseAngle || _options.positionTolerance != options.positionTolerance
+     || _options.splitGroups != options.splitGroups)
+    return false;
+
+  if(!options.splitGroups) return true;
+
+  const vector<Group> &groups = geometry.groups();
+  if(groups.size() != _groups.size()) return false;
+
+  for(size_t i = 0; i < groups.size(); i++) {
+    if(groups[i].start != _groups[i].start || groups[i].count != _groups[i].count) return false;
+  }
+  return true;
+}
+
+std::vector<unsigned> EdgeIndex::topologyVersions() const
+{
+  vector<unsigned> versions;
+  for(const auto &morph : _morphPositions) versions.push_back(morph ? morph->version() : 0);
+  versions.push_back(_skinIndices ? _skinIndices->version() : 0);
+  versions.push_back(_skinWeights ? _skinWeights->version() : 0);
+  return versions;
+}
+
+bool EdgeIndex::update()
+{
+  //morphs and skinning decide which vertices are identified
+  if((_index && _index->version() != _indexVersion) || topologyVersions() != _topologyVersions) {
+    build();
+    return true;
+  }
+
+  unsigned positionVersion = _position ? _position->version() : 0;
+  if(positionVersion == _positionVersion) return false;
+  _positionVersion = positionVersion;
+
+  //the angles between triangles changed
+  if(_options.creaseAngle > 0 && classify(_topology, _offsets.size() - 1)) {
+    emit(_topology, _offsets.size() - 1);
+    return true;
+  }
+  return false;
+}
+
+void EdgeIndex::build()
+{
+  _topologyVersions = topologyVersions();
+  _indexVersion = _index ? _index->version() : 0;
+  _positionVersion = _position ? _position->version() : 0;
+
+  size_t vertexCount = _position && _position->itemSize() == 3 ? _position->itemCount() : 0;
+  size_t triangleCount = _index ? _index->size() / 3 : vertexCount / 3;
+  if(vertexCount == 0) triangleCount = 0;
+
+  const float *position = vertexCount ? _position->data_t() : nullptr;
+  const uint32_t *index = _index ? _index->data_t() : nullptr;
+
+  //each vertex is replaced by the first one at its position which morphs and skinning move alike
+  vector<uint32_t> canonical(vertexCount);
+  if(vertexCount) {
+    BufferGeometry::Ptr positions = BufferGeometry::make(_position);
+    positions->setIndex(_index);
+    for(const auto &morph : _morphPositions) positions->addMorphPosition(morph);
+    positions->setSkinIndices(_skinIndices);
+    positions->setSkinWeights(_skinWeights);
+
+    VertexWelder::Options welding;
+    welding.positionTolerance = _options.positionTolerance;
+    welding.positionsOnly = true;
+
+    size_t uniqueCount;
+    vector<uint32_t> remap = VertexWelder::remap(*positions, welding, uniqueCount);
+    vector<uint32_t> first(uniqueCount, none);
+
+    for(uint32_t v = 0; v < vertexCount; v++) {
+      if(remap[v] == VertexWelder::unused) continue;
+      if(first[remap[v]] == none) first[remap[v]] = v;
+      canonical[v] = first[remap[v]];
+    }
+  }
+
+  auto vertex = [&](size_t i) -> uint32_t {
+    uint32_t v = index ? index[i] : (uint32_t)i;
+    return v < vertexCount ? canonical[v] : none;
+  };
+
+  //triangles are deduplicated in runs between group boundaries
+  vector<size_t> bounds {0, triangleCount};
+  for(const Group &group : _groups) {
+    bounds.push_back(std::min(group.start / 3, triangleCount));
+    bounds.push_back(std::min((group.start + group.count) / 3, triangleCount));
+  }
+  sort(bounds.begin(), bounds.end());
+  bounds.erase(unique(bounds.begin(), bounds.end()), bounds.end());
+
+  bool features = _options.creaseAngle > 0;
+
+  vector<Edge> edges;
+  edges.reserve(triangleCount * 3 / 2 + 16);
+
+  EdgeTable table;
+
+  for(size_t run = 0; run + 1 < bounds.size(); run++) {
+
+    //closed meshes have 1.5 edges per triangle
+    table.reset((bounds[run + 1] - bounds[run]) * 3 / 2);
+
+    for(size_t t = bounds[run]; t < bounds[run + 1]; t++) {
+
+      uint32_t v[3] = {vertex(t * 3), vertex(t * 3 + 1), vertex(t * 3 + 2)};
+      if(v[0] == none || v[1] == none || v[2] == none) continue;
+
+      float normal[3];
+      if(features && !faceNormal(position, v[0], v[1], v[2], normal)) continue;
+
+      for(unsigned i = 0; i < 3; i++) {
+        uint32_t a = v[i], b = v[(i + 1) % 3];
+        if(a == b) continue;
+
+        uint32_t number = table.insert(a, b, (uint32_t)edges.size());
+        if(number == edges.size()) {
+          edges.push_back(Edge {a, b, (uint32_t)t, none, 1, true});
+          continue;
+        }
+
+        Edge &edge = edges[number];
+        if(edge.uses == 1) edge.second = (uint32_t)t;
+        if(edge.uses < 3) edge.uses++;
+      }
+    }
+  }
+
+  if(features) {
+    classify(edges, triangleCount);
+    _topology.swap(edges);
+    emit(_topology, triangleCount);
+  }
+  else {
+    _topology.clear();
+    emit(edges, triangleCount);
+  }
+}
+
+bool EdgeIndex::classify(std::vector<Edge> &edges, size_t triangleCount)
+{
+  const float *position = _position ? _position->data_t() : nullptr;
+  const uint32_t *index = _index ? _index->data_t() : nullptr;
+
+  //triangles keep the vertices they were built with. Identified vertices lie within the tolerance
+  vector<float> normals(triangleCount * 3);
+  vector<bool> valid(triangleCount, false);
+  for(const Edge &edge : edges) {
+    for(uint32_t t : {edge.triangle, edge.second}) {
+      if(t == none || valid[t]) continue;
+
+      size_t i = t * 3;
+      uint32_t a = index ? index[i] : (uint32_t)i, b = index ? index[i + 1] : (uint32_t)i + 1;
+      uint32_t c = index ? index[i + 2] : (uint32_t)i + 2;
+      valid[t] = faceNormal(position, a, b, c, &normals[t * 3]);
+    }
+  }
+
+  float minCos = (float)cos(_options.creaseAngle * math::DEG2RAD);
+  bool changed = false;
+
+  for(Edge &edge : edges) {
+    //border and non-manifold edges are always kept
+    bool kept = true;
+    if(edge.uses == 2 && valid[edge.triangle] && valid[edge.second]) {
+      const float *n = &normals[edge.triangle * 3], *o = &normals[edge.second * 3];
+      kept = n[0] * o[0] + n[1] * o[1] + n[2] * o[2] <= minCos;
+    }
+    changed |= kept != edge.kept;
+    edge.kept = kept;
+  }
+  return changed;
+}
+
+void EdgeIndex::emit(const std::vector<Edge> &edges, size_t triangleCount)
+{
+  size_t keptCount = count_if(edges.begin(), edges.end(), [](const Edge &edge) {return edge.kept;});
+
+  auto lines = attribute::prealloc<uint32_t>(keptCount * 2);
+  _offsets.assign(triangleCount + 1, 0);
+
+  //edges are in order of their first triangle
+  size_t t = 0;
+  for(const Edge &edge : edges) {
+    if(!edge.kept) continue;
+
+    for(; t <= edge.triangle; t++) _offsets[t] = (uint32_t)lines->offset();
+    lines->next() = edge.a;
+    lines->next() = edge.b;
+  }
+  for(; t <= triangleCount; t++) _offsets[t] = (uint32_t)lines->offset();
+
+  _edges = lines;
+}
+
+void EdgeIndex::range(size_t start, size_t count, size_t &edgeStart, size_t &edgeCount) const
+{
+  size_t triangles = _offsets.size() - 1;
+
+  size_t first = std::min(start / 3, triangles);
+  size_t last = std::min((start + std::min(count, triangles * 3)) / 3, triangles);
+
+  edgeStart = _offsets[first];
+  edgeCount = last > first ? _offsets[last] - _offsets[first] : 0;
+}
+
+}
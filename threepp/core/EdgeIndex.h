@@ -0,0 +1,139 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_EDGEINDEX_H
+#define THREEPP_EDGEINDEX_H
+
+#include <vector>
+#include "BufferGeometry.h"
+
+namespace three {
+
+/**
+ * line index over the edges of a triangle geometry, each edge drawn once. Vertices at the same position
+ * are identified first (see VertexWelder), so edges split by attribute seams or by non-indexed geometry
+ * are merged too. Vertices which morph targets or skinning move apart are not identified. Edges are found through a flat open addressing table keyed by the sorted vertex pair.
+ * With a crease angle, only feature edges are kept: border and non-manifold edges, and edges whose
+ * triangles meet at more than the angle.
+ *
+ * Edges are ordered by the first triangle using them. Like BVH, the index is built for one set of position,
+ * morph, skin and index attributes. update() rebuilds the welded topology when the index, morph or skin
+ * attributes are modified. Modified positions only reclassify the feature edges
+ */
+class DLX EdgeIndex
+{
+public:
+  struct Options
+  {
+    //in degrees. If greater than 0, only feature edges are kept
+    float creaseAngle = 0;
+
+    //maximum distance between identified vertices
+    float positionTolerance = 1e-5f;
+
+    //deduplicate within each group separately, so every group draws its complete outline
+    bool splitGroups = false;
+  };
+
+private:
+  struct Edge
+  {
+    uint32_t a, b;
+
+    //first and second triangle using the edge
+    uint32_t triangle, second;
+
+    //number of triangles using the edge, saturated at 3
+    uint16_t uses;
+
+    bool kept;
+  };
+
+  BufferAttributeT<float>::Ptr _position;
+  BufferAttributeT<uint32_t>::Ptr _index;
+
+  //attributes deciding which vertices may be identified besides the position
+  std::vector<BufferAttributeT<float>::Ptr> _morphPositions;
+  BufferAttributeT<float>::Ptr _skinIndices;
+  BufferAttributeT<float>::Ptr _skinWeights;
+
+  //of the morph and skin attributes and of the index at the last build
+  std::vector<unsigned> _topologyVersions;
+  unsigned _indexVersion = 0;
+
+  //of the position at the last feature classification
+  unsigned _positionVersion = 0;
+
+  Options _options;
+  std::vector<Group> _groups;
+
+  BufferAttributeT<uint32_t>::Ptr _edges;
+
+  //all edges of the welded topology, kept for reclassification if there is a crease angle
+  std::vector<Edge> _topology;
+
+  //first edge index entry of each triangle's new edges, one extra entry at the end
+  std::vector<uint32_t> _offsets;
+
+  EdgeIndex(const BufferGeometry &geometry, const Options &options);
+
+  std::vector<unsigned> topologyVersions() const;
+
+  //weld the vertices and collect the edges
+  void build();
+
+  //decide which edges are feature edges at the current positions. @return true if any decision changed
+  bool classify(std::vector<Edge> &edges, size_t triangleCount);
+
+  //write the kept edges to a new edges() attribute
+  void emit(const std::vector<Edge> &edges, size_t triangleCount);
+
+public:
+  using Ptr = std::shared_ptr<EdgeIndex>;
+
+  /**
+   * build the edges of an indexed or non-indexed triangle geometry
+   */
+  static Ptr make(const BufferGeometry &geometry, const Options &options)
+  {
+    Ptr edges(new EdgeIndex(geometry, options));
+    edges->build();
+    return edges;
+  }
+
+  static Ptr make(const BufferGeometry &geometry)
+  {
+    return make(geometry, Options());
+  }
+
+  /**
+   * @return true if this index was built for the geometry's attributes and groups with the given options
+   */
+  bool builtFor(const BufferGeometry &geometry, const Options &options) const;
+
+  /**
+   * rebuild if the index, morph or skin attributes were modified since the last build. The vertex weld is
+   * kept when only the positions were modified, so vertices identified before stay identified. With a
+   * crease angle, the feature edges are then reclassified, since they depend on the angles between
+   * triangles
+   *
+   * @return true if the edges changed. The edges() attribute is replaced in that case
+   */
+  bool update();
+
+  /**
+   * vertex index pairs, to be drawn as lines with the geometry's vertex attributes
+   */
+  const BufferAttributeT<uint32_t>::Ptr &edges() const {return _edges;}
+
+  /**
+   * map a range of the triangle index (or of the vertices, if non-indexed) to the range of edges
+   * introduced by its triangles. Exact for ranges starting at the beginning of a group
+   */
+  void range(size_t start, size_t count, size_t &edgeStart, size_t &edgeCount) const;
+};
+
+}
+
+#endif //THREEPP_EDGEINDEX_H
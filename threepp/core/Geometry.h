@@ -5,6 +5,7 @@
 #ifndef THREEPP_GEOMETRY_H
 #define THREEPP_GEOMETRY_H
 
+#include <atomic>
 #include <threepp/math/Vector3.h>
 #include <threepp/math/Matrix4.h>
 #include <threepp/math/Sphere.h>
@@ -38,7 +39,7 @@ class Geometry
 {
   friend class BufferGeometry;
 
-  static size_t id_count;
+  static std::atomic<size_t> id_count;
 
 protected:
   math::Box3 _boundingBox;
@@ -0,0 +1,373 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "IndexOptimizer.h"
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdio>
+
+namespace three {
+
+using namespace std;
+
+namespace {
+
+static const uint32_t none = numeric_limits<uint32_t>::max();
+
+//vertex -> triangles
+struct Adjacency
+{
+  vector<uint32_t> offsets;
+  vector<uint32_t> triangles;
+
+  Adjacency(const uint32_t *index, size_t indexCount, size_t vertexCount)
+     : offsets(vertexCount + 1, 0), triangles(indexCount)
+  {
+    for(size_t i = 0; i < indexCount; i++) offsets[index[i] + 1]++;
+    for(size_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+
+    vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for(size_t i = 0; i < indexCount; i++) triangles[fill[index[i]]++] = (uint32_t)(i / 3);
+  }
+
+  uint32_t count(uint32_t v) const {return offsets[v + 1] - offsets[v];}
+};
+
+struct Cluster
+{
+  uint32_t start, count;
+  float sortKey;
+};
+
+}
+
+IndexOptimizer::Statistics IndexOptimizer::analyze(const uint32_t *index, size_t indexCount, size_t vertexCount,
+                                                   unsigned cacheSize)
+{
+  Statistics stats;
+  if(indexCount < 3) return stats;
+
+  //a vertex is cached if fewer than cacheSize misses occurred since it was loaded
+  vector<size_t> loaded(vertexCount, 0);
+  vector<bool> used(vertexCount, false);
+  size_t time = cacheSize + 1, usedCount = 0;
+
+  for(size_t i = 0; i < indexCount; i++) {
+    uint32_t v = index[i];
+    if(time - loaded[v] > cacheSize) {
+      loaded[v] = time++;
+      stats.transformed++;
+    }
+    if(!used[v]) {
+      used[v] = true;
+      usedCount++;
+    }
+  }
+
+  stats.acmr = (float)stats.transformed / (indexCount / 3);
+  stats.atvr = (float)stats.transformed / usedCount;
+  return stats;
+}
+
+IndexOptimizer::Statistics IndexOptimizer::analyze(const BufferGeometry &geometry, unsigned cacheSize)
+{
+  if(!geometry.index() || !geometry.position()) return Statistics();
+
+  const BufferAttributeT<uint32_t>::Ptr &index = geometry.index();
+  return analyze(index->data_t(), index->size(), geometry.position()->itemCount(), cacheSize);
+}
+
+void IndexOptimizer::optimizeVertexCache(uint32_t *index, size_t indexCount, size_t vertexCount,
+                                         unsigned cacheSize, std::vector<uint32_t> *clusters)
+{
+  size_t triangleCount = indexCount / 3;
+  if(triangleCount == 0) return;
+
+  Adjacency adjacency(index, triangleCount * 3, vertexCount);
+
+  //triangles not yet emitted per vertex
+  vector<uint32_t> live(vertexCount);
+  for(uint32_t v = 0; v < vertexCount; v++) live[v] = adjacency.count(v);
+
+  vector<size_t> cacheTime(vertexCount, 0);
+  vector<bool> emitted(triangleCount, false);
+  vector<uint32_t> deadEnd;
+  deadEnd.reserve(indexCount);
+
+  vector<uint32_t> result;
+  result.reserve(triangleCount * 3);
+
+  size_t time = cacheSize + 1;
+  uint32_t cursor = 0;
+
+  //start at the first used vertex
+  uint32_t fanning = none;
+  while(cursor < vertexCount && live[cursor] == 0) cursor++;
+  if(cursor < vertexCount) fanning = cursor;
+
+  if(clusters) {
+    clusters->clear();
+    clusters->push_back(0);
+  }
+
+  vector<uint32_t> candidates;
+
+  while(fanning != none) {
+    candidates.clear();
+
+    //emit all remaining triangles around the fanning vertex
+    for(uint32_t o = adjacency.offsets[fanning]; o < adjacency.offsets[fanning + 1]; o++) {
+      uint32_t t = adjacency.triangles[o];
+      if(emitted[t]) continue;
+      emitted[t] = true;
+
+      for(unsigned k = 0; k < 3; k++) {
+        uint32_t v = index[t * 3 + k];
+        result.push_back(v);
+
+        deadEnd.push_back(v);
+        candidates.push_back(v);
+        live[v]--;
+
+        if(time - cacheTime[v] > cacheSize) cacheTime[v] = time++;
+      }
+    }
+
+    //prefer candidates which stay in the cache until their fan is complete, and among those the oldest
+    uint32_t best = none;
+    long bestPriority = -1;
+    for(uint32_t v : candidates) {
+      if(live[v] == 0) continue;
+
+      long priority = 0;
+      if(time - cacheTime[v] + 2 * live[v] <= cacheSize) priority = (long)(time - cacheTime[v]);
+
+      if(priority > bestPriority) {
+        bestPriority = priority;
+        best = v;
+      }
+    }
+
+    if(best == none) {
+      //recently used vertices
+      while(!deadEnd.empty() && best == none) {
+        uint32_t v = deadEnd.back();
+        deadEnd.pop_back();
+        if(live[v] > 0) best = v;
+      }
+
+      //the next unprocessed vertex in input order. This starts a cache-incoherent run
+      if(best == none) {
+        while(cursor < vertexCount && live[cursor] == 0) cursor++;
+        if(cursor < vertexCount) {
+          best = cursor;
+          if(clusters && result.size() < triangleCount * 3) clusters->push_back((uint32_t)(result.size() / 3));
+        }
+      }
+    }
+    fanning = best;
+  }
+
+  copy(result.begin(), result.end(), index);
+}
+
+void IndexOptimizer::optimizeOverdraw(uint32_t *index, size_t indexCount, const float *position, size_t vertexCount,
+                                      const std::vector<uint32_t> &clusters, unsigned cacheSize, float threshold)
+{
+  size_t triangleCount = indexCount / 3;
+  if(triangleCount == 0 || clusters.empty()) return;
+
+  //split hard clusters where the running cache efficiency is good enough
+  float meshAcmr = analyze(index, triangleCount * 3, vertexCount, cacheSize).acmr;
+
+  vector<Cluster> split;
+  vector<size_t> cacheTime(vertexCount, 0);
+  size_t time = cacheSize + 1;
+
+  for(size_t c = 0; c < clusters.size(); c++) {
+    uint32_t start = clusters[c];
+    uint32_t end = c + 1 < clusters.size() ? clusters[c + 1] : (uint32_t)triangleCount;
+
+    //each cluster starts with a cold cache
+    time += cacheSize + 1;
+
+    uint32_t clusterStart = start;
+    size_t misses = 0;
+
+    for(uint32_t t = start; t < end; t++) {
+      for(unsigned k = 0; k < 3; k++) {
+        uint32_t v = index[t * 3 + k];
+        if(time - cacheTime[v] > cacheSize) {
+          cacheTime[v] = time++;
+          misses++;
+        }
+      }
+
+      uint32_t count = t + 1 - clusterStart;
+      if(t + 1 < end && misses <= meshAcmr * threshold * count) {
+        split.push_back(Cluster {clusterStart, count, 0});
+        clusterStart = t + 1;
+        misses = 0;
+        time += cacheSize + 1;
+      }
+    }
+    if(clusterStart < end) split.push_back(Cluster {clusterStart, end - clusterStart, 0});
+  }
+
+  //area weighted mesh centroid
+  double meshCenter[3] = {0, 0, 0}, meshArea = 0;
+
+  vector<float> centers(split.size() * 3), normals(split.size() * 3);
+
+  for(size_t c = 0; c < split.size(); c++) {
+    double center[3] = {0, 0, 0}, normal[3] = {0, 0, 0}, area = 0;
+
+    for(uint32_t t = split[c].start; t < split[c].start + split[c].count; t++) {
+      const float *p0 = position + index[t * 3] * 3;
+      const float *p1 = position + index[t * 3 + 1] * 3;
+      const float *p2 = position + index[t * 3 + 2] * 3;
+
+      double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+      double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+      double n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+      double a = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+      for(unsigned k = 0; k < 3; k++) {
+        center[k] += (p0[k] + p1[k] + p2[k]) / 3.0 * a;
+        normal[k] += n[k];
+      }
+      area += a;
+    }
+
+    for(unsigned k = 0; k < 3; k++) {
+      meshCenter[k] += center[k];
+      centers[c * 3 + k] = (float)(area > 0 ? center[k] / area : 0);
+    }
+    meshArea += area;
+
+    double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    for(unsigned k = 0; k < 3; k++) normals[c * 3 + k] = (float)(length > 0 ? normal[k] / length : 0);
+  }
+  if(meshArea > 0) for(unsigned k = 0; k < 3; k++) meshCenter[k] /= meshArea;
+
+  //clusters pointing away from the center are likely in front of the others
+  for(size_t c = 0; c < split.size(); c++) {
+    float key = 0;
+    for(unsigned k = 0; k < 3; k++) key += (centers[c * 3 + k] - (float)meshCenter[k]) * normals[c * 3 + k];
+    split[c].sortKey = key;
+  }
+
+  stable_sort(split.begin(), split.end(), [](const Cluster &c1, const Cluster &c2) {
+    return c1.sortKey > c2.sortKey;
+  });
+
+  vector<uint32_t> result;
+  result.reserve(triangleCount * 3);
+  for(const Cluster &cluster : split) {
+    result.insert(result.end(), index + cluster.start * 3, index + (cluster.start + cluster.count) * 3);
+  }
+  copy(result.begin(), result.end(), index);
+}
+
+std::vector<uint32_t> IndexOptimizer::optimizeVertexFetch(uint32_t *index, size_t indexCount, size_t vertexCount)
+{
+  vector<uint32_t> remap(vertexCount, none);
+  uint32_t next = 0;
+
+  for(size_t i = 0; i < indexCount; i++) {
+    uint32_t &v = index[i];
+    if(remap[v] == none) remap[v] = next++;
+    v = remap[v];
+  }
+  for(uint32_t &r : remap) {
+    if(r == none) r = next++;
+  }
+  return remap;
+}
+
+namespace {
+
+void reorder(const BufferAttributeT<float>::Ptr &attribute, const vector<uint32_t> &remap)
+{
+  if(!attribute || attribute->itemCount() != remap.size()) return;
+
+  unsigned itemSize = attribute->itemSize();
+  float *data = attribute->data<float>();
+  vector<float> source(data, data + attribute->size());
+
+  for(size_t v = 0; v < remap.size(); v++) {
+    copy(&source[v * itemSize], &source[v * itemSize] + itemSize, data + remap[v] * itemSize);
+  }
+  attribute->needsUpdate();
+}
+
+}
+
+IndexOptimizer::Result IndexOptimizer::optimize(BufferGeometry &geometry, bool reorderVertices,
+                                                unsigned cacheSize, float threshold)
+{
+  Result result;
+
+  const BufferAttributeT<float>::Ptr position = geometry.position();
+  if(!geometry.index() || !position || position->itemSize() != 3) return result;
+
+  const BufferAttributeT<uint32_t>::Ptr &indexAttribute = geometry.index();
+  const uint32_t *source = indexAttribute->data_t();
+  vector<uint32_t> index(source, source + indexAttribute->size());
+  size_t vertexCount = position->itemCount();
+
+  result.before = analyze(index.data(), index.size(), vertexCount, cacheSize);
+
+  //groups index separate draw calls and are kept in place
+  vector<Group> ranges = geometry.groups();
+  if(ranges.empty()) ranges.emplace_back(0, index.size(), 0);
+
+  vector<uint32_t> clusters;
+  for(const Group &range : ranges) {
+    size_t start = min(range.start, index.size());
+    size_t count = min(range.count, index.size() - start) / 3 * 3;
+
+    optimizeVertexCache(index.data() + start, count, vertexCount, cacheSize, &clusters);
+    optimizeOverdraw(index.data() + start, count, position->data_t(), vertexCount, clusters, cacheSize, threshold);
+  }
+
+  if(reorderVertices) {
+    vector<uint32_t> remap = optimizeVertexFetch(index.data(), index.size(), vertexCount);
+
+    vector<BufferAttributeT<float>::Ptr> attributes {
+       position, geometry.normal(), geometry.color(), geometry.uv(), geometry.uv2(), geometry.tangents(),
+       geometry.bitangents(), geometry.skinIndices(), geometry.skinWeights(),
+       dynamic_pointer_cast<BufferAttributeT<float>>(geometry.getAttribute(AttributeName::lineDistances))};
+    attributes.insert(attributes.end(), geometry.morphPositions().begin(), geometry.morphPositions().end());
+    attributes.insert(attributes.end(), geometry.morphNormals().begin(), geometry.morphNormals().end());
+    for(const auto &indexed : geometry.indexedAttributes()) attributes.push_back(indexed.second);
+
+    //an attribute may be referenced more than once, but must be reordered only once
+    sort(attributes.begin(), attributes.end());
+    attributes.erase(unique(attributes.begin(), attributes.end()), attributes.end());
+
+    for(const auto &attribute : attributes) reorder(attribute, remap);
+
+    //the compact copies still have the old vertex order
+    geometry.setPacked(nullptr);
+    geometry.setInterleaved(nullptr);
+  }
+
+  //a new attribute, so derived structures (BVH) are rebuilt
+  geometry.setIndex(attribute::copied<uint32_t>(index));
+
+  result.after = analyze(index.data(), index.size(), vertexCount, cacheSize);
+  return result;
+}
+
+std::string IndexOptimizer::Result::report() const
+{
+  char text[128];
+  snprintf(text, sizeof(text), "ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, %zu -> %zu vertices transformed",
+           before.acmr, after.acmr, before.atvr, after.atvr, before.transformed, after.transformed);
+  return text;
+}
+
+}
@@ -0,0 +1,91 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_INDEXOPTIMIZER_H
+#define THREEPP_INDEXOPTIMIZER_H
+
+#include <vector>
+#include <string>
+#include "BufferGeometry.h"
+
+namespace three {
+
+/**
+ * reorders triangle index buffers for the GPU. Triangles are first ordered for post-transform vertex
+ * cache reuse (Tipsify), then cache-coherent clusters are sorted so outward facing parts of the mesh
+ * are drawn first and occlude the rest, and finally vertices are renumbered in order of first use so
+ * vertex fetches become sequential. The rendered result does not change
+ */
+class DLX IndexOptimizer
+{
+public:
+  static const unsigned defaultCacheSize = 16;
+
+  struct Statistics
+  {
+    //average cache miss ratio: transformed vertices per triangle. 0.5 is the optimum for large grids,
+    //3 the worst case
+    float acmr = 0;
+
+    //average transformed to vertex ratio: transformed vertices per used vertex. 1 is optimal
+    float atvr = 0;
+
+    size_t transformed = 0;
+  };
+
+  struct Result
+  {
+    Statistics before, after;
+
+    /**
+     * @return a one line comparison of ACMR and ATVR before and after optimization
+     */
+    std::string report() const;
+  };
+
+  /**
+   * simulate a FIFO post-transform cache
+   */
+  static Statistics analyze(const uint32_t *index, size_t indexCount, size_t vertexCount,
+                            unsigned cacheSize=defaultCacheSize);
+
+  static Statistics analyze(const BufferGeometry &geometry, unsigned cacheSize=defaultCacheSize);
+
+  /**
+   * reorder triangles for vertex cache reuse
+   *
+   * @param clusters if not null, receives the first triangle of each cache-coherent run
+   */
+  static void optimizeVertexCache(uint32_t *index, size_t indexCount, size_t vertexCount,
+                                  unsigned cacheSize=defaultCacheSize, std::vector<uint32_t> *clusters=nullptr);
+
+  /**
+   * reorder the clusters produced by optimizeVertexCache so that clusters facing away from the mesh
+   * center come first. Clusters are split further as long as their cache efficiency stays within
+   * threshold times the efficiency of the whole range
+   */
+  static void optimizeOverdraw(uint32_t *index, size_t indexCount, const float *position, size_t vertexCount,
+                               const std::vector<uint32_t> &clusters, unsigned cacheSize=defaultCacheSize,
+                               float threshold=1.05f);
+
+  /**
+   * renumber vertices in order of first use. Unreferenced vertices are moved to the end
+   *
+   * @return the new position of each vertex
+   */
+  static std::vector<uint32_t> optimizeVertexFetch(uint32_t *index, size_t indexCount, size_t vertexCount);
+
+  /**
+   * run all passes on an indexed triangle geometry. Groups are optimized separately. Vertex attributes,
+   * including morph targets and indexed attributes, are reordered in place unless reorderVertices is
+   * false, which must be used if the attributes are shared with other geometries. Reordering drops the
+   * packed and interleaved copies, so packing and interleaving must be done afterwards
+   */
+  static Result optimize(BufferGeometry &geometry, bool reorderVertices=true,
+                         unsigned cacheSize=defaultCacheSize, float threshold=1.05f);
+};
+
+}
+
+#endif //THREEPP_INDEXOPTIMIZER_H
@@ -6,55 +6,60 @@
 #define THREEPP_INTERLEAVEDBUFFER_H
 
 #include <vector>
-#include <threepp/util/simplesignal.h>
+#include "BufferAttribute.h"
 
 namespace three {
 
-class InterleavedBuffer
+/**
+ * float vertex data of several attributes stored item by item, which is uploaded as a single buffer.
+ * The buffer is the attribute that gets uploaded, the InterleavedBufferAttributes referring to it
+ * only describe the layout
+ */
+class InterleavedBuffer : public BufferAttribute
 {
   friend class InterleavedBufferAttribute;
 
   std::vector<float> _array;
-  size_t _stride, _count;
-  bool _dynamic = false;
-  unsigned _version = 0;
+  size_t _count;
 
-  UpdateRange _updateRange;
+  InterleavedBuffer(const InterleavedBuffer &buffer)
+     : BufferAttribute(buffer), _array(buffer._array), _count(buffer._count) {}
 
 public:
   InterleavedBuffer(const std::vector<float> &array, size_t stride)
-     : _array(array), _stride(stride), _count(array.size() / stride) {}
+     : BufferAttribute((unsigned)stride, false), _array(array), _count(array.size() / stride) {}
 
-  Signal<void()> onUpload;
-
-  void needsUpdate() {_version++;}
+  using Ptr = std::shared_ptr<InterleavedBuffer>;
+  static Ptr make(const std::vector<float> &array, size_t stride) {
+    return Ptr(new InterleavedBuffer(array, stride));
+  }
 
-  size_t stride() const {return _stride;}
+  size_t stride() const {return _itemSize;}
   size_t count() const {return _count;}
   const std::vector<float> &array() const {return _array;}
 
   InterleavedBuffer &setArray(const std::vector<float> &array)
   {
-    _count = (unsigned)(array.size() / _stride);
+    _count = (unsigned)(array.size() / _itemSize);
     _array = array;
     return *this;
   }
 
   InterleavedBuffer &setDynamic(bool value)
   {
-    _dynamic = value;
+    dynamic = value;
     return *this;
   }
 
   InterleavedBuffer &copyAt(unsigned index1, const InterleavedBuffer &attribute, unsigned index2)
   {
-    index1 *= _stride;
-    index2 *= attribute._stride;
+    index1 *= _itemSize;
+    index2 *= attribute._itemSize;
 
-    if(_array.size() < index1 + _stride) {
-      _array.resize(index1 + _stride);
+    if(_array.size() < index1 + _itemSize) {
+      _array.resize(index1 + _itemSize);
     }
-    for (unsigned i = 0; i < _stride; i ++ ) {
+    for (unsigned i = 0; i < _itemSize; i ++ ) {
 
       _array[ index1 + i ] = attribute._array[ index2 + i ];
     }
@@ -67,6 +72,31 @@ public:
 
     return *this;
   }
+
+  const void *data(size_t offset) const override
+  {
+    return _array.data() + offset;
+  }
+
+  GLenum glType() const override
+  {
+    return Cpp2GL<float>::glEnum;
+  }
+
+  size_t byteCount() const override
+  {
+    return _array.size() * sizeof(float);
+  }
+
+  unsigned bytesPerElement() const override
+  {
+    return sizeof(float);
+  }
+
+  InterleavedBuffer *clone() const override
+  {
+    return new InterleavedBuffer(*this);
+  }
 };
 
 }
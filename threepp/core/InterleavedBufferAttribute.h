@@ -12,106 +12,115 @@ namespace three {
 
 class InterleavedBufferAttribute : public BufferAttribute
 {
-  InterleavedBuffer &_buffer;
+  InterleavedBuffer::Ptr _buffer;
   size_t _offset;
 
+  InterleavedBufferAttribute(const InterleavedBufferAttribute &attribute)
+     : BufferAttribute(attribute), _buffer(attribute._buffer), _offset(attribute._offset)
+  {}
+
 public:
-  InterleavedBufferAttribute(InterleavedBuffer &buffer, unsigned itemSize, unsigned offset, bool normalized=true)
-     : BufferAttribute(itemSize, normalized), _buffer(buffer)
+  InterleavedBufferAttribute(const InterleavedBuffer::Ptr &buffer, unsigned itemSize, unsigned offset, bool normalized=true)
+     : BufferAttribute(itemSize, normalized), _buffer(buffer), _offset(offset)
   {}
 
-  size_t count() const {return _buffer.count();}
+  using Ptr = std::shared_ptr<InterleavedBufferAttribute>;
+  static Ptr make(const InterleavedBuffer::Ptr &buffer, unsigned itemSize, unsigned offset, bool normalized=true) {
+    return Ptr(new InterleavedBufferAttribute(buffer, itemSize, offset, normalized));
+  }
+
+  size_t count() const {return _buffer->count();}
 
   size_t offset() const {return _offset;}
 
-  const InterleavedBuffer &buffer() const {return _buffer;}
+  const InterleavedBuffer::Ptr &buffer() const {return _buffer;}
 
-  const std::vector<float> &array() const {return _buffer.array();}
+  const std::vector<float> &array() const {return _buffer->array();}
 
   InterleavedBufferAttribute &setX(unsigned index, float x) 
   {
-    _buffer._array[ index * _buffer._stride + _offset ] = x;
+    _buffer->_array[ index * _buffer->_itemSize + _offset ] = x;
 
     return *this;
   }
 
   InterleavedBufferAttribute &setY(unsigned index, float y)
   {
-    _buffer._array[ index * _buffer._stride + _offset + 1 ] = y;
+    _buffer->_array[ index * _buffer->_itemSize + _offset + 1 ] = y;
 
     return *this;
   }
 
   InterleavedBufferAttribute &setZ(unsigned index, float z)
   {
-    _buffer._array[ index * _buffer._stride + _offset + 2 ] = z;
+    _buffer->_array[ index * _buffer->_itemSize + _offset + 2 ] = z;
 
     return *this;
   }
 
   InterleavedBufferAttribute &setW(unsigned index, float w)
   {
-    _buffer._array[ index * _buffer._stride + _offset + 3 ] = w;
+    _buffer->_array[ index * _buffer->_itemSize + _offset + 3 ] = w;
 
     return *this;
   }
 
   float getX(unsigned index)
   {
-    return _buffer._array[ index * _buffer._stride + _offset ];
+    return _buffer->_array[ index * _buffer->_itemSize + _offset ];
   }
 
   float getY(unsigned index)
   {
-    return _buffer._array[ index * _buffer._stride + _offset + 1 ];
+    return _buffer->_array[ index * _buffer->_itemSize + _offset + 1 ];
   }
 
   float getZ(unsigned index)
   {
-    return _buffer._array[ index * _buffer._stride + _offset + 2 ];
+    return _buffer->_array[ index * _buffer->_itemSize + _offset + 2 ];
   }
 
   float getW(unsigned index)
   {
-    return _buffer._array[ index * _buffer._stride + _offset + 3 ];
+    return _buffer->_array[ index * _buffer->_itemSize + _offset + 3 ];
   }
 
   InterleavedBufferAttribute &setXY(unsigned index, float x, float y)
   {
-    index = index * _buffer._stride + _offset;
+    index = index * _buffer->_itemSize + _offset;
 
-    _buffer._array[ index + 0 ] = x;
-    _buffer._array[ index + 1 ] = y;
+    _buffer->_array[ index + 0 ] = x;
+    _buffer->_array[ index + 1 ] = y;
 
     return *this;
   }
 
   InterleavedBufferAttribute &setXYZ(unsigned index, float x, float y, float z)
   {
-    index = index * _buffer._stride + _offset;
+    index = index * _buffer->_itemSize + _offset;
 
-    _buffer._array[ index + 0 ] = x;
-    _buffer._array[ index + 1 ] = y;
-    _buffer._array[ index + 2 ] = z;
+    _buffer->_array[ index + 0 ] = x;
+    _buffer->_array[ index + 1 ] = y;
+    _buffer->_array[ index + 2 ] = z;
 
     return *this;
   }
 
   InterleavedBufferAttribute &setXYZW(unsigned index, float x, float y, float z, float w)
   {
-    index = index * _buffer._stride + _offset;
+    index = index * _buffer->_itemSize + _offset;
 
-    _buffer._array[ index + 0 ] = x;
-    _buffer._array[ index + 1 ] = y;
-    _buffer._array[ index + 2 ] = z;
-    _buffer._array[ index + 3 ] = w;
+    _buffer->_array[ index + 0 ] = x;
+    _buffer->_array[ index + 1 ] = y;
+    _buffer->_array[ index + 2 ] = z;
+    _buffer->_array[ index + 3 ] = w;
 
     return *this;
   }
 
   const void *data(size_t offset) const override
   {
-    return _buffer.array().data() + offset;
+    return _buffer->data(offset);
   }
 
   GLenum glType() const override
@@ -121,13 +130,19 @@ public:
 
   size_t byteCount() const override
   {
-    return _buffer.array().size() * sizeof(float);
+    return _buffer->byteCount();
   }
 
   unsigned int bytesPerElement() const override
   {
     return sizeof(float);
   }
+
+  //the copy refers to the same buffer
+  InterleavedBufferAttribute *clone() const override
+  {
+    return new InterleavedBufferAttribute(*this);
+  }
 };
 
 }
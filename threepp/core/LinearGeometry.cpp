@@ -46,6 +46,7 @@ LinearGeometry::LinearGeometry(const LinearGeometry &geometry)
   _skinWeights = geometry._skinWeights;
   _skinIndices = geometry._skinIndices;
   _lineDistances = geometry._lineDistances;
+  _dropAfterConversion = geometry._dropAfterConversion;
 
   // update flags
   _elementsNeedUpdate = geometry._elementsNeedUpdate;
@@ -149,9 +150,7 @@ void LinearGeometry::raycast(const Line &line,
 
       if (distance < raycaster.near() || distance > raycaster.far()) continue;
 
-      Intersection &intersect = intersects.add(rayIndex);
-      rayIndex++;
-
+      Intersection intersect;
       intersect.distance = distance;
 
       // What do we want? intersection point on the ray or on the segment??
@@ -160,6 +159,9 @@ void LinearGeometry::raycast(const Line &line,
       intersect.direction = ray.direction();
       intersect.faceIndex = i;
       intersect.object = &const_cast<Line &>(line);
+
+      intersects.add(rayIndex, intersect);
+      rayIndex++;
     }
   }
 }
@@ -63,14 +63,36 @@ class DLX LinearGeometry : public Geometry
   bool _lineDistancesNeedUpdate = false;
   bool _groupsNeedUpdate = false;
 
+  //release the data once converted to a BufferGeometry
+  bool _dropAfterConversion = false;
+  bool _dropped = false;
+
   static void computeFaceNormals(std::vector<Face3> &faces, const std::vector<Vertex> &vertices);
 
   static void computeVertexNormals(std::vector<Face3> &faces, const std::vector<Vertex> &vertices,
                                               bool areaWeighted = true);
 
-protected:
-  std::shared_ptr<DirectGeometry> _directGeometry;
+  void drop()
+  {
+    //culling still needs the bounds
+    if(_boundingBox.isEmpty()) computeBoundingBox();
+    if(_boundingSphere.isEmpty()) computeBoundingSphere();
+
+    std::vector<Vertex>().swap(_vertices);
+    std::vector<Vertex>().swap(_normals);
+    std::vector<Color>().swap(_colors);
+    std::vector<Face3>().swap(_faces);
+    std::vector<UV_Array>().swap(_faceVertexUvs[0]);
+    std::vector<UV_Array>().swap(_faceVertexUvs[1]);
+    std::vector<MorphTarget>().swap(_morphTargets);
+    std::vector<MorphNormal>().swap(_morphNormals);
+    std::vector<math::Vector4>().swap(_skinWeights);
+    std::vector<math::Vector4>().swap(_skinIndices);
+    std::vector<float>().swap(_lineDistances);
+    _dropped = true;
+  }
 
+protected:
   LinearGeometry(const LinearGeometry &geom);
 
   explicit LinearGeometry() : Geometry(geometry::Typer(this)) {}
@@ -80,6 +102,19 @@ public:
 
   const std::vector<Vertex> vertices() const {return _vertices;}
 
+  /**
+   * release vertices, faces and all other data once the renderer has converted the geometry to a
+   * BufferGeometry. Saves memory for static meshes, but the geometry can no longer be updated, raycast
+   * or copied. The bounding volumes are computed and kept for culling
+   */
+  LinearGeometry &setDropAfterConversion(bool drop)
+  {
+    _dropAfterConversion = drop;
+    return *this;
+  }
+
+  bool dropped() const {return _dropped;}
+
   bool useMorphing() const override
   {
     return !_morphTargets.empty();
@@ -10,6 +10,8 @@ namespace three {
 
 using namespace three::math;
 
+std::atomic<uint64_t> Object3D::__id_count(0);
+
 void Object3D::dispose()
 {
   for(auto i=0; i<materialCount(); i++) {
@@ -10,6 +10,7 @@
 #include <functional>
 #include <tuple>
 #include <array>
+#include <atomic>
 
 #include <threepp/util/osdecl.h>
 #include <threepp/util/sole.h>
@@ -32,8 +33,6 @@ class Scene;
 using ScenePtr = std::shared_ptr<Scene>;
 using CameraPtr = std::shared_ptr<Camera>;
 
-static uint16_t __id_count = 0;
-
 namespace loader {
 class Access;
 }
@@ -47,15 +46,17 @@ class DLX Object3D
 
   template <typename G, typename... M> friend class Object3D_GM;
 
+  static std::atomic<uint64_t> __id_count;
+
 public:
   using Ptr = std::shared_ptr<Object3D>;
 
 protected:
-  //automatically assigned, unique within process
-  uint16_t _id;
+  //automatically assigned, unique within process and never reused
+  uint64_t _id;
 
   //unique among children, 1-based, 0==undefined
-  uint16_t _childId;
+  uint32_t _childId = 0;
 
   std::string _name;
 
@@ -95,7 +96,7 @@ protected:
 public:
   virtual ~Object3D() = default;
 
-  uint16_t childId() const {return _childId;}
+  uint32_t childId() const {return _childId;}
 
   bool visit(bool (*f)(Object3D *));
   bool visit(std::function<bool(Object3D *)> f);
@@ -123,7 +124,7 @@ public:
     return (bool)((Mat *)typer);
   }
 
-  uint16_t id() const {return _id;}
+  uint64_t id() const {return _id;}
   const Layers &layers() const {return _layers;}
   const math::Matrix4 &matrix() const {return _matrix;}
 
@@ -292,7 +293,7 @@ public:
     }
 
     object->_parent = this;
-    object->_childId = _children.size()+1;
+    object->_childId = (uint32_t)_children.size()+1;
 
     _children.push_back( object );
   }
@@ -2,6 +2,8 @@
 // Created by byter on 10.09.17.
 //
 #include "impl/raycast.h"
+#include "SceneIndex.h"
+#include "BufferGeometry.h"
 #include <threepp/math/Circle3.h>
 
 namespace three {
@@ -128,10 +130,14 @@ Object3D *IntersectList::calculateSurface(Vector3 &position, Vector3 &normal)
       Vector3 direction = (nis.point - ringPos.origin).normalized();
       float distance = ringPos.origin.distanceTo(nis.point);
 
+      //line-of-sight test, any hit up to the target point counts
       raycaster.set(Ray(ringPos.origin, direction));
-      nis.object->raycast(raycaster, collisions);
+      raycaster.setRange(0, distance).setMode(RaycastMode::Any);
 
-      if(!collisions.hasIntersects(distance))
+      collisions.clear();
+      raycaster.intersectObject(*nis.object, collisions, false);
+
+      if(collisions.empty())
         ringPos.setCurrent(nis);
 
       else
@@ -195,12 +201,53 @@ void intersectObject(Object3D &object,
   }
 }
 
+void IntersectList::add(unsigned rayIndex, const Intersection &intersection)
+{
+  if(rayIndex >= _intersections.size()) {
+    _intersections.resize(rayIndex+1);
+    _limits.resize(rayIndex+1, numeric_limits<float>::infinity());
+  }
+  if(_mode == RaycastMode::All) {
+    _intersections[rayIndex].push_back(intersection);
+    return;
+  }
+  if(intersection.distance > _limits[rayIndex]) return;
+
+  auto &intersects = _intersections[rayIndex];
+  intersects.push_back(intersection);
+
+  if(_mode == RaycastMode::Any) {
+    //done with this ray
+    _limits[rayIndex] = -1;
+  }
+  else if(intersects.size() >= _maxHits) {
+    //keep the closest, the farthest of them becomes the new limit
+    auto nth = intersects.begin() + (_maxHits - 1);
+    std::nth_element(intersects.begin(), nth, intersects.end(), [](const Intersection &a, const Intersection &b) {
+      return a.distance < b.distance;
+    });
+    intersects.erase(nth + 1, intersects.end());
+    _limits[rayIndex] = nth->distance;
+  }
+}
+
+void IntersectList::complete(Intersection &intersection)
+{
+  intersection.deferred = false;
+
+  if(!intersection.object || !intersection.object->geometry()) return;
+  BufferGeometry *geometry = intersection.object->geometry()->typer;
+  if(!geometry || !geometry->position()) return;
+
+  impl::completeBufferGeometryIntersection(*intersection.object, geometry->position(), geometry->uv(), intersection);
+}
+
 void IntersectList::prepare()
 {
   //throw out empty ray bins
-  for(auto iter = _intersections.begin(); iter != _intersections.end(); iter++) {
-    if(iter->empty()) _intersections.erase(iter);
-  }
+  _intersections.erase(std::remove_if(_intersections.begin(), _intersections.end(),
+                                      [](const std::vector<Intersection> &bin) {return bin.empty();}),
+                       _intersections.end());
 
   //sort each ray's bin so the closest intersection comes first
   for(auto &intersects : _intersections) {
@@ -208,23 +255,60 @@ void IntersectList::prepare()
       return a.distance < b.distance;
     });
   }
+
+  finish();
+}
+
+void IntersectList::finish()
+{
+  //in mode All, all intersections are complete and kept
+  if(_mode == RaycastMode::All) return;
+
+  for(auto &intersects : _intersections) {
+    if(intersects.size() > _maxHits) {
+      std::sort(intersects.begin(), intersects.end(), [this](const Intersection &a, const Intersection &b) {
+        return a.distance < b.distance;
+      });
+      intersects.resize(_maxHits);
+    }
+
+    for(auto &intersect : intersects) {
+      if(intersect.deferred) complete(intersect);
+    }
+  }
 }
 
 void Raycaster::intersectObject(Object3D &object, IntersectList &intersects, bool recursive ) const
 {
+  intersects.setMode(_mode, _maxHits);
   three::intersectObject( object, *this, intersects, recursive );
+
+  //the caller may intersect more objects before prepare(), but the hits must be complete anyway
+  intersects.finish();
 }
 
 void Raycaster::intersectObjects(const std::vector<Object3D::Ptr> objects,
                                  IntersectList &intersects,
                                  bool recursive ) const
 {
+  intersects.setMode(_mode, _maxHits);
   for (auto obj : objects) {
     three::intersectObject( *obj, *this, intersects, recursive );
   }
   if(!intersects.empty()) intersects.prepare();
 }
 
+void Raycaster::intersectObjects(const std::vector<Object3D::Ptr> &objects,
+                                 SceneIndex &index,
+                                 IntersectList &intersects) const
+{
+  intersects.setMode(_mode, _maxHits);
+  index.update(objects);
+  index.intersect(*this, intersects);
+
+  if(!intersects.empty()) intersects.prepare();
+}
+
 std::vector<math::Ray> Raycaster::createCircularBundle(
    const math::Ray &ray, float radius, unsigned radialSegments)
 {
@@ -6,6 +6,7 @@
 #define THREEPP_RAYCASTER_H
 
 #include <memory>
+#include <limits>
 
 #include <threepp/util/osdecl.h>
 #include <threepp/math/Ray.h>
@@ -22,6 +23,22 @@ namespace three {
 
 class Raycaster;
 class Object3D;
+class SceneIndex;
+
+/**
+ * determines which intersections a raycast reports
+ */
+enum class RaycastMode
+{
+  //all intersections along each ray
+  All,
+  //the closest intersection of each ray
+  Closest,
+  //any one intersection within the raycaster's far distance, for occlusion and line-of-sight queries
+  Any,
+  //the closest N intersections of each ray
+  First
+};
 
 /**
  * describes a hit point of a ray
@@ -37,6 +54,9 @@ struct Intersection
   Object3D *object = nullptr;
 
   unsigned faceIndex;
+
+  //uv and face normal are not yet computed. Completed in IntersectList::finish
+  bool deferred = false;
 };
 
 /**
@@ -46,6 +66,14 @@ class DLX IntersectList
 {
   std::vector<std::vector<Intersection>> _intersections;
 
+  RaycastMode _mode = RaycastMode::All;
+  unsigned _maxHits = 0;
+
+  //per ray maximum distance of intersections still of interest
+  std::vector<float> _limits;
+
+  void complete(Intersection &intersection);
+
   class DLX iterator : public std::iterator<std::output_iterator_tag, int>
   {
   public:
@@ -73,8 +101,17 @@ public:
   iterator begin();
   iterator end();
 
+  /**
+   * remove empty ray bins, sort each ray's intersections by distance and finish() them
+   */
   void prepare();
 
+  /**
+   * apply the query mode to each ray's intersections and complete the deferred ones. Unlike prepare(),
+   * ray bins are kept in place, so more objects can be intersected afterwards
+   */
+  void finish();
+
   unsigned rayCount() const {return _intersections.size();}
 
   /**
@@ -87,20 +124,33 @@ public:
    */
   Object3D *calculateSurface(math::Vector3 &position, math::Vector3 &normal);
 
-  Intersection &add(unsigned rayIndex, const Intersection &intersection)
+  /**
+   * set the query mode. Done by the Raycaster intersect methods
+   */
+  void setMode(RaycastMode mode, unsigned maxHits)
   {
-    if(rayIndex >= _intersections.size()) _intersections.resize(rayIndex+1);
-    _intersections[rayIndex].push_back(intersection);
-    return _intersections[rayIndex].back();
+    _mode = mode;
+    _maxHits = mode == RaycastMode::First ? std::max(maxHits, 1u) : 1;
   }
 
-  Intersection &add(unsigned rayIndex)
+  RaycastMode mode() const {return _mode;}
+
+  /**
+   * @return the distance beyond which intersections of the given ray are of no interest
+   * anymore. Shrinks as hits are added in the Closest, Any and First modes. Negative if
+   * the ray is done
+   */
+  float limit(unsigned rayIndex) const
   {
-    if(rayIndex >= _intersections.size()) _intersections.resize(rayIndex+1);
-    _intersections[rayIndex].emplace_back();
-    return _intersections[rayIndex].back();
+    return rayIndex < _limits.size() ? _limits[rayIndex] : std::numeric_limits<float>::infinity();
   }
 
+  /**
+   * add an intersection, observing the query mode. In modes other than All, the
+   * intersection is dropped if it lies beyond the ray's limit
+   */
+  void add(unsigned rayIndex, const Intersection &intersection);
+
   Intersection &get(unsigned rayIndex, unsigned intersectIndex)
   {
     return _intersections[rayIndex][intersectIndex];
@@ -123,6 +173,7 @@ public:
 
   void clear() {
     _intersections.clear();
+    _limits.clear();
   }
 
   bool empty() const {
@@ -141,6 +192,9 @@ class DLX Raycaster
   std::vector<math::Ray> _rays;
   float _near=0, _far=std::numeric_limits<float>::infinity();
 
+  RaycastMode _mode = RaycastMode::All;
+  unsigned _maxHits = 1;
+
   float _linePrecision = 1;
 
   math::Vector3 _origin;
@@ -206,6 +260,32 @@ public:
   float far() const {return _far;}
   const math::Vector3 &origin() const {return _origin;}
 
+  /**
+   * set the distance range, measured from the origin, within which intersections are reported
+   */
+  Raycaster &setRange(float near, float far)
+  {
+    _near = near;
+    _far = far;
+    return *this;
+  }
+
+  /**
+   * set the query mode. For modes other than All, the ray interval shrinks as intersections
+   * are found, and uv and face normal are only computed for the reported intersections
+   *
+   * @param maxHits the number of intersections per ray for RaycastMode::First
+   */
+  Raycaster &setMode(RaycastMode mode, unsigned maxHits=1)
+  {
+    _mode = mode;
+    _maxHits = maxHits;
+    return *this;
+  }
+
+  RaycastMode mode() const {return _mode;}
+  unsigned maxHits() const {return _maxHits;}
+
   void intersectObject(Object3D &object,
                        IntersectList &intersects,
                        bool recursive = true) const;
@@ -213,6 +293,16 @@ public:
   void intersectObjects(std::vector<std::shared_ptr<Object3D>> objects,
                         IntersectList &intersects,
                         bool recursive=true) const;
+
+  /**
+   * intersect the objects and their descendants through a spatial index, which is first brought
+   * up to date with the objects' world bounds
+   *
+   * @param index the index, kept by the caller across queries
+   */
+  void intersectObjects(const std::vector<std::shared_ptr<Object3D>> &objects,
+                        SceneIndex &index,
+                        IntersectList &intersects) const;
 };
 
 }
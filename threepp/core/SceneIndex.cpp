@@ -0,0 +1,372 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "SceneIndex.h"
+#include <algorithm>
+#include <functional>
+
+namespace three {
+
+using namespace std;
+using namespace math;
+
+constexpr float SceneIndex::margin;
+
+namespace {
+
+float area(const Box3 &box)
+{
+  Vector3 size = box.max() - box.min();
+  return size.x() * size.y() + size.y() * size.z() + size.z() * size.x();
+}
+
+Box3 unified(const Box3 &a, const Box3 &b)
+{
+  Box3 box(a);
+  return box.unify(b);
+}
+
+//ray data used for box tests during traversal
+struct RayData
+{
+  float origin[3];
+  float invDir[3];
+
+  //distance of the ray origin from the raycaster origin
+  float offset;
+};
+
+/*
+ * compute a lower bound for the distance, measured from the raycaster origin, at which any ray may
+ * hit something inside the box. Uses |p - origin| >= t - |rayOrigin - origin| for a point p at
+ * distance t along a ray
+ */
+bool lowerBound(const Box3 &box, const vector<RayData> &rays, float &bound)
+{
+  const float bmin[3] = {box.min().x(), box.min().y(), box.min().z()};
+  const float bmax[3] = {box.max().x(), box.max().y(), box.max().z()};
+
+  bool hit = false;
+  bound = numeric_limits<float>::infinity();
+
+  for(const RayData &ray : rays) {
+    float tmin = 0, tmax = numeric_limits<float>::infinity();
+
+    for(unsigned i=0; i<3; i++) {
+      float t0 = (bmin[i] - ray.origin[i]) * ray.invDir[i];
+      float t1 = (bmax[i] - ray.origin[i]) * ray.invDir[i];
+      if(t0 > t1) std::swap(t0, t1);
+
+      tmin = t0 > tmin ? t0 : tmin;
+      tmax = t1 < tmax ? t1 : tmax;
+    }
+    if(tmin > tmax) continue;
+
+    hit = true;
+    bound = std::min(bound, tmin - ray.offset);
+  }
+  return hit;
+}
+
+}
+
+int SceneIndex::allocate()
+{
+  if(_free < 0) {
+    _nodes.emplace_back();
+    return (int)_nodes.size() - 1;
+  }
+  int node = _free;
+  _free = _nodes[node].parent;
+  _nodes[node] = Node();
+  return node;
+}
+
+void SceneIndex::release(int node)
+{
+  _nodes[node].object.reset();
+  _nodes[node].height = -1;
+  _nodes[node].parent = _free;
+  _free = node;
+}
+
+void SceneIndex::insertLeaf(int leaf)
+{
+  if(_root < 0) {
+    _root = leaf;
+    _nodes[leaf].parent = -1;
+    return;
+  }
+
+  //find the best sibling, descending along the cheapest path in terms of surface area
+  const Box3 leafBox = _nodes[leaf].box;
+  int index = _root;
+  while(!_nodes[index].isLeaf()) {
+    const Node &node = _nodes[index];
+
+    float combinedArea = area(unified(node.box, leafBox));
+    float cost = 2 * combinedArea;
+    float inheritanceCost = 2 * (combinedArea - area(node.box));
+
+    auto descendCost = [&](int child) {
+      const Node &c = _nodes[child];
+      float a = area(unified(c.box, leafBox));
+      return (c.isLeaf() ? a : a - area(c.box)) + inheritanceCost;
+    };
+    float cost1 = descendCost(node.child1);
+    float cost2 = descendCost(node.child2);
+
+    if(cost < cost1 && cost < cost2) break;
+
+    index = cost1 < cost2 ? node.child1 : node.child2;
+  }
+
+  int sibling = index;
+  int oldParent = _nodes[sibling].parent;
+  int newParent = allocate();
+
+  Node &parent = _nodes[newParent];
+  parent.parent = oldParent;
+  parent.box = unified(leafBox, _nodes[sibling].box);
+  parent.height = _nodes[sibling].height + 1;
+  parent.child1 = sibling;
+  parent.child2 = leaf;
+
+  if(oldParent >= 0) {
+    if(_nodes[oldParent].child1 == sibling) _nodes[oldParent].child1 = newParent;
+    else _nodes[oldParent].child2 = newParent;
+  }
+  else {
+    _root = newParent;
+  }
+  _nodes[sibling].parent = newParent;
+  _nodes[leaf].parent = newParent;
+
+  //walk back up, fixing heights and boxes
+  for(index = _nodes[leaf].parent; index >= 0; index = _nodes[index].parent) {
+    index = balance(index);
+
+    Node &node = _nodes[index];
+    node.height = 1 + std::max(_nodes[node.child1].height, _nodes[node.child2].height);
+    node.box = unified(_nodes[node.child1].box, _nodes[node.child2].box);
+  }
+}
+
+void SceneIndex::removeLeaf(int leaf)
+{
+  if(leaf == _root) {
+    _root = -1;
+    return;
+  }
+
+  int parent = _nodes[leaf].parent;
+  int grandParent = _nodes[parent].parent;
+  int sibling = _nodes[parent].child1 == leaf ? _nodes[parent].child2 : _nodes[parent].child1;
+
+  release(parent);
+
+  if(grandParent < 0) {
+    _root = sibling;
+    _nodes[sibling].parent = -1;
+    return;
+  }
+
+  if(_nodes[grandParent].child1 == parent) _nodes[grandParent].child1 = sibling;
+  else _nodes[grandParent].child2 = sibling;
+  _nodes[sibling].parent = grandParent;
+
+  for(int index = grandParent; index >= 0; index = _nodes[index].parent) {
+    index = balance(index);
+
+    Node &node = _nodes[index];
+    node.height = 1 + std::max(_nodes[node.child1].height, _nodes[node.child2].height);
+    node.box = unified(_nodes[node.child1].box, _nodes[node.child2].box);
+  }
+}
+
+/*
+ * if the subtree rooted at a is imbalanced, rotate the higher child up. Returns the new subtree root
+ */
+int SceneIndex::balance(int a)
+{
+  Node &A = _nodes[a];
+  if(A.isLeaf() || A.height < 2) return a;
+
+  int b = A.child1, c = A.child2;
+  int diff = _nodes[c].height - _nodes[b].height;
+
+  if(diff > -2 && diff < 2) return a;
+
+  //the child to rotate up, and the child which stays below a
+  int up = diff > 0 ? c : b;
+  int stay = diff > 0 ? b : c;
+  Node &U = _nodes[up];
+
+  int f = U.child1, g = U.child2;
+
+  U.child1 = a;
+  U.parent = A.parent;
+  A.parent = up;
+
+  if(U.parent >= 0) {
+    if(_nodes[U.parent].child1 == a) _nodes[U.parent].child1 = up;
+    else _nodes[U.parent].child2 = up;
+  }
+  else {
+    _root = up;
+  }
+
+  //keep the higher grandchild below up, move the other one below a
+  int high = _nodes[f].height > _nodes[g].height ? f : g;
+  int low = high == f ? g : f;
+
+  U.child2 = high;
+  if(diff > 0) A.child2 = low;
+  else A.child1 = low;
+  _nodes[low].parent = a;
+
+  A.box = unified(_nodes[stay].box, _nodes[low].box);
+  A.height = 1 + std::max(_nodes[stay].height, _nodes[low].height);
+  U.box = unified(A.box, _nodes[high].box);
+  U.height = 1 + std::max(A.height, _nodes[high].height);
+
+  return up;
+}
+
+void SceneIndex::add(const Object3D::Ptr &object)
+{
+  if(!object->visible()) return;
+
+  const Geometry::Ptr geometry = object->geometry();
+  if(geometry) {
+    if(geometry->boundingSphere().isEmpty()) geometry->computeBoundingSphere();
+
+    Sphere sphere = geometry->boundingSphere();
+    sphere.apply(object->matrixWorld());
+
+    Vector3 extent(sphere.radius());
+    Box3 box(sphere.center() - extent, sphere.center() + extent);
+
+    auto found = _proxies.find(object.get());
+    if(found != _proxies.end() && found->second.object.lock() != object) {
+      //address was reused by a new object
+      removeLeaf(found->second.node);
+      release(found->second.node);
+      _proxies.erase(found);
+      found = _proxies.end();
+    }
+
+    if(found == _proxies.end()) {
+      int leaf = allocate();
+      _nodes[leaf].box = box.expandByScalar(sphere.radius() * margin);
+      _nodes[leaf].object = object;
+      insertLeaf(leaf);
+
+      _proxies[object.get()] = Proxy {object, leaf, _stamp};
+    }
+    else {
+      Proxy &proxy = found->second;
+      if(!_nodes[proxy.node].box.containsBox(box)) {
+        removeLeaf(proxy.node);
+        _nodes[proxy.node].box = box.expandByScalar(sphere.radius() * margin);
+        insertLeaf(proxy.node);
+      }
+      proxy.stamp = _stamp;
+    }
+  }
+  else {
+    _unbounded.push_back(object);
+  }
+
+  for(const auto &child : object->children()) add(child);
+}
+
+void SceneIndex::update(const std::vector<Object3D::Ptr> &objects)
+{
+  _stamp ++;
+  _unbounded.clear();
+
+  for(const auto &object : objects) add(object);
+
+  for(auto it = _proxies.begin(); it != _proxies.end(); ) {
+    if(it->second.stamp != _stamp) {
+      removeLeaf(it->second.node);
+      release(it->second.node);
+      it = _proxies.erase(it);
+    }
+    else ++it;
+  }
+}
+
+void SceneIndex::clear()
+{
+  _nodes.clear();
+  _proxies.clear();
+  _unbounded.clear();
+  _root = _free = -1;
+}
+
+void SceneIndex::intersect(const Raycaster &raycaster, IntersectList &intersects) const
+{
+  for(const auto &weak : _unbounded) {
+    if(auto object = weak.lock()) object->raycast(raycaster, intersects);
+  }
+
+  if(_root < 0) return;
+
+  const vector<Ray> &rays = raycaster.rays();
+  vector<RayData> rayData(rays.size());
+  for(size_t i=0; i<rays.size(); i++) {
+    const Ray &ray = rays[i];
+    Vector3 dir = ray.direction().normalized();
+
+    RayData &data = rayData[i];
+    data.origin[0] = ray.origin().x(); data.origin[1] = ray.origin().y(); data.origin[2] = ray.origin().z();
+    data.invDir[0] = 1.0f / dir.x(); data.invDir[1] = 1.0f / dir.y(); data.invDir[2] = 1.0f / dir.z();
+    data.offset = ray.origin().distanceTo(raycaster.origin());
+  }
+
+  //no object hit beyond the largest per-ray limit can be accepted by the list
+  float bound;
+  auto updateBound = [&]() {
+    bound = -numeric_limits<float>::infinity();
+    for(unsigned r=0; r<rays.size(); r++) bound = std::max(bound, intersects.limit(r));
+  };
+  updateBound();
+
+  //min-heap of nodes ordered by their lower bound distance
+  using Entry = pair<float, int>;
+  vector<Entry> heap;
+  auto push = [&](int node) {
+    float distance;
+    if(lowerBound(_nodes[node].box, rayData, distance) && distance <= raycaster.far()) {
+      heap.emplace_back(distance, node);
+      push_heap(heap.begin(), heap.end(), greater<Entry>());
+    }
+  };
+  push(_root);
+
+  while(!heap.empty()) {
+    pop_heap(heap.begin(), heap.end(), greater<Entry>());
+    Entry entry = heap.back();
+    heap.pop_back();
+
+    //nothing left that could be accepted
+    if(entry.first > bound) break;
+
+    const Node &node = _nodes[entry.second];
+    if(node.isLeaf()) {
+      if(auto object = node.object.lock()) {
+        object->raycast(raycaster, intersects);
+        updateBound();
+      }
+    }
+    else {
+      push(node.child1);
+      push(node.child2);
+    }
+  }
+}
+
+}
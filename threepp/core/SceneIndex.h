@@ -0,0 +1,96 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_SCENEINDEX_H
+#define THREEPP_SCENEINDEX_H
+
+#include <vector>
+#include <unordered_map>
+#include <threepp/math/Box3.h>
+#include "Object3D.h"
+
+namespace three {
+
+/**
+ * broad-phase spatial index over the world-space bounds of the objects in a hierarchy, used to
+ * accelerate raycasting. The index is a dynamic AABB tree with enlarged ("fat") leaf boxes, so
+ * that objects which move only slightly don't require tree modifications. Ray queries visit the
+ * candidate objects front-to-back and can stop early for closest-hit and any-hit queries.
+ */
+class DLX SceneIndex
+{
+  struct Node
+  {
+    math::Box3 box;
+    int parent = -1;
+    int child1 = -1;
+    int child2 = -1;
+
+    //0 for leaves, -1 for nodes on the free list
+    int height = 0;
+
+    std::weak_ptr<Object3D> object;
+
+    bool isLeaf() const {return child1 < 0;}
+  };
+
+  struct Proxy
+  {
+    std::weak_ptr<Object3D> object;
+    int node;
+    unsigned stamp;
+  };
+
+  std::vector<Node> _nodes;
+  int _root = -1;
+  int _free = -1;
+
+  std::unordered_map<Object3D *, Proxy> _proxies;
+  unsigned _stamp = 0;
+
+  //visible objects without geometry. These are always raycast
+  std::vector<std::weak_ptr<Object3D>> _unbounded;
+
+  int allocate();
+  void release(int node);
+
+  void insertLeaf(int leaf);
+  void removeLeaf(int leaf);
+  int balance(int node);
+
+  void add(const Object3D::Ptr &object);
+
+public:
+  //leaf boxes are enlarged by this fraction of the object's bounding radius
+  static constexpr float margin = 0.1f;
+
+  /**
+   * synchronize the index with the given objects and their visible descendants. Objects whose world
+   * bounds left their leaf box are re-inserted, objects which are gone or invisible are removed.
+   * The world matrices must be up-to-date
+   */
+  void update(const std::vector<Object3D::Ptr> &objects);
+
+  /**
+   * raycast the indexed objects. Objects are visited front-to-back, and traversal stops as soon as no
+   * remaining object can be hit within the limits of the list's query mode (see RaycastMode)
+   */
+  void intersect(const Raycaster &raycaster, IntersectList &intersects) const;
+
+  /**
+   * remove all objects
+   */
+  void clear();
+
+  size_t size() const {return _proxies.size();}
+
+  /**
+   * @return the height of the tree, 0 if empty
+   */
+  int height() const {return _root < 0 ? 0 : _nodes[_root].height + 1;}
+};
+
+}
+
+#endif //THREEPP_SCENEINDEX_H
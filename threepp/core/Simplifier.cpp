@@ -0,0 +1,619 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "Simplifier.h"
+#include <threepp/util/Parallel.h>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <cmath>
+#include <limits>
+
+namespace three {
+
+using namespace std;
+
+namespace {
+
+//weight of the planes which keep open borders in shape
+static const double borderWeight = 10.0;
+
+struct Vec
+{
+  double x, y, z;
+
+  Vec operator -(const Vec &v) const {return Vec {x - v.x, y - v.y, z - v.z};}
+  double dot(const Vec &v) const {return x * v.x + y * v.y + z * v.z;}
+  Vec cross(const Vec &v) const {return Vec {y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x};}
+  double length() const {return sqrt(dot(*this));}
+};
+
+//symmetric 4x4 matrix, upper triangle, and the total weight of the planes
+struct Quadric
+{
+  double a2=0, ab=0, ac=0, ad=0, b2=0, bc=0, bd=0, c2=0, cd=0, d2=0;
+  double w=0;
+
+  void addPlane(const Vec &n, double d, double weight)
+  {
+    a2 += weight * n.x * n.x; ab += weight * n.x * n.y; ac += weight * n.x * n.z; ad += weight * n.x * d;
+    b2 += weight * n.y * n.y; bc += weight * n.y * n.z; bd += weight * n.y * d;
+    c2 += weight * n.z * n.z; cd += weight * n.z * d;
+    d2 += weight * d * d;
+    w += weight;
+  }
+
+  Quadric &operator +=(const Quadric &q)
+  {
+    a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2; bc += q.bc; bd += q.bd;
+    c2 += q.c2; cd += q.cd; d2 += q.d2;
+    w += q.w;
+    return *this;
+  }
+
+  //@return the weighted mean of the squared distances from p to the planes
+  double error(const Vec &p) const
+  {
+    if(w <= 0) return 0;
+
+    double e = a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x
+               + b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y
+               + c2 * p.z * p.z + 2 * cd * p.z
+               + d2;
+    return e > 0 ? e / w : 0;
+  }
+};
+
+enum class Kind : uint8_t {Manifold, Border, Locked};
+
+struct PositionHash
+{
+  const float *position;
+
+  size_t operator()(uint32_t v) const
+  {
+    uint32_t h[3];
+    memcpy(h, position + v * 3, sizeof(h));
+    return (h[0] * 73856093u) ^ (h[1] * 19349663u) ^ (h[2] * 83492791u);
+  }
+};
+
+struct PositionEqual
+{
+  const float *position;
+
+  bool operator()(uint32_t a, uint32_t b) const
+  {
+    return memcmp(position + a * 3, position + b * 3, sizeof(float) * 3) == 0;
+  }
+};
+
+inline uint64_t edgeKey(uint32_t a, uint32_t b)
+{
+  return a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a;
+}
+
+//compressed adjacency lists
+struct Adjacency
+{
+  vector<uint32_t> offsets;
+  vector<uint32_t> data;
+
+  template <typename Func>
+  void build(size_t count, size_t entries, Func each)
+  {
+    offsets.assign(count + 1, 0);
+    each([this](uint32_t key, uint32_t) {offsets[key + 1]++;});
+    for(size_t i = 0; i < count; i++) offsets[i + 1] += offsets[i];
+
+    data.resize(entries);
+    vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    each([this, &fill](uint32_t key, uint32_t value) {data[fill[key]++] = value;});
+  }
+
+  const uint32_t *begin(uint32_t key) const {return data.data() + offsets[key];}
+  const uint32_t *end(uint32_t key) const {return data.data() + offsets[key + 1];}
+};
+
+struct Collapse
+{
+  uint32_t from, to;
+
+  //squared geometric error, and the error plus attribute deviation for ordering the collapses
+  double error, cost;
+};
+
+class Collapser
+{
+  const float *_normal;
+  const float *_uv;
+  const Simplifier::Options &_options;
+
+  size_t _vertexCount;
+
+  //normalized positions
+  vector<Vec> _position;
+
+  //vertex -> first vertex with the same position
+  vector<uint32_t> _remap;
+
+  vector<Kind> _kind;
+  vector<Quadric> _quadrics;
+
+  vector<uint32_t> &_index;
+
+  //per pass state
+  Adjacency _triangles;
+  Adjacency _wedges;
+  vector<uint32_t> _collapsed;
+  vector<bool> _touched;
+
+  //per collapse scratch
+  vector<pair<uint32_t, uint32_t>> _wedgeMap;
+  vector<uint32_t> _neighborsA, _neighborsB;
+
+  uint32_t wedge(uint32_t corner) const {return _collapsed[_index[corner]];}
+  uint32_t vertex(uint32_t corner) const {return _remap[wedge(corner)];}
+
+  void classify();
+  void computeQuadrics();
+  void buildAdjacency();
+
+  //map the wedges of from onto the wedges of to and compute the attribute cost. false if the mapping
+  //would tear a seam
+  bool mapWedges(uint32_t from, uint32_t to, double edgeLengthSq, double &cost);
+
+  bool valid(uint32_t from, uint32_t to, unsigned &removed);
+
+  //@return the collapse cost for ordering, error receives the squared geometric error
+  double cost(uint32_t from, uint32_t to, bool borderEdge, bool &possible, double &error);
+
+public:
+  Collapser(const float *position, const float *normal, const float *uv, size_t vertexCount,
+       vector<uint32_t> &index, const Simplifier::Options &options);
+
+  //@return the largest squared geometric error accepted
+  double run(size_t target);
+};
+
+Collapser::Collapser(const float *position, const float *normal, const float *uv, size_t vertexCount,
+           vector<uint32_t> &index, const Simplifier::Options &options)
+   : _normal(normal), _uv(uv), _options(options), _vertexCount(vertexCount), _index(index)
+{
+  //normalize positions so errors are relative to the extent
+  float min[3] = {numeric_limits<float>::max(), numeric_limits<float>::max(), numeric_limits<float>::max()};
+  float max[3] = {-min[0], -min[1], -min[2]};
+  for(size_t v = 0; v < vertexCount; v++) {
+    for(unsigned k = 0; k < 3; k++) {
+      min[k] = std::min(min[k], position[v * 3 + k]);
+      max[k] = std::max(max[k], position[v * 3 + k]);
+    }
+  }
+  float extent = std::max(max[0] - min[0], std::max(max[1] - min[1], max[2] - min[2]));
+  double scale = extent > 0 ? 1.0 / extent : 1.0;
+
+  _position.resize(vertexCount);
+  for(size_t v = 0; v < vertexCount; v++) {
+    _position[v] = Vec {(position[v * 3] - min[0]) * scale,
+                        (position[v * 3 + 1] - min[1]) * scale,
+                        (position[v * 3 + 2] - min[2]) * scale};
+  }
+
+  //weld by position
+  _remap.resize(vertexCount);
+  unordered_map<uint32_t, uint32_t, PositionHash, PositionEqual> unique(
+     vertexCount, PositionHash {position}, PositionEqual {position});
+  for(uint32_t v = 0; v < vertexCount; v++) {
+    _remap[v] = unique.emplace(v, v).first->second;
+  }
+
+  //drop degenerate triangles
+  size_t write = 0;
+  for(size_t i = 0; i + 2 < _index.size(); i += 3) {
+    uint32_t a = _index[i], b = _index[i + 1], c = _index[i + 2];
+    if(_remap[a] == _remap[b] || _remap[b] == _remap[c] || _remap[c] == _remap[a]) continue;
+
+    _index[write++] = a;
+    _index[write++] = b;
+    _index[write++] = c;
+  }
+  _index.resize(write);
+
+  _collapsed.resize(vertexCount);
+  for(uint32_t v = 0; v < vertexCount; v++) _collapsed[v] = v;
+
+  classify();
+  computeQuadrics();
+}
+
+void Collapser::classify()
+{
+  _kind.assign(_vertexCount, Kind::Manifold);
+
+  //border edges have one triangle, non-manifold edges more than two
+  unordered_map<uint64_t, unsigned> edges(_index.size());
+  for(size_t i = 0; i < _index.size(); i += 3) {
+    for(unsigned k = 0; k < 3; k++) {
+      edges[edgeKey(_remap[_index[i + k]], _remap[_index[i + (k + 1) % 3]])]++;
+    }
+  }
+  for(const auto &edge : edges) {
+    uint32_t a = (uint32_t)(edge.first >> 32), b = (uint32_t)edge.first;
+
+    if(edge.second > 2) {
+      _kind[a] = _kind[b] = Kind::Locked;
+    }
+    else if(edge.second == 1) {
+      Kind kind = _options.lockBorder ? Kind::Locked : Kind::Border;
+      if(_kind[a] != Kind::Locked) _kind[a] = kind;
+      if(_kind[b] != Kind::Locked) _kind[b] = kind;
+    }
+  }
+}
+
+void Collapser::computeQuadrics()
+{
+  _quadrics.assign(_vertexCount, Quadric());
+
+  unordered_map<uint64_t, unsigned> edges(_index.size());
+  for(size_t i = 0; i < _index.size(); i += 3) {
+    for(unsigned k = 0; k < 3; k++) {
+      edges[edgeKey(_remap[_index[i + k]], _remap[_index[i + (k + 1) % 3]])]++;
+    }
+  }
+
+  for(size_t i = 0; i < _index.size(); i += 3) {
+    uint32_t v[3] = {_remap[_index[i]], _remap[_index[i + 1]], _remap[_index[i + 2]]};
+    const Vec &p0 = _position[v[0]], &p1 = _position[v[1]], &p2 = _position[v[2]];
+
+    Vec normal = (p1 - p0).cross(p2 - p0);
+    double length = normal.length();
+    if(length == 0) continue;
+
+    Vec n {normal.x / length, normal.y / length, normal.z / length};
+    double area = length * 0.5;
+
+    Quadric q;
+    q.addPlane(n, -n.dot(p0), area);
+    for(unsigned k = 0; k < 3; k++) _quadrics[v[k]] += q;
+
+    //planes perpendicular to border edges keep the outline
+    for(unsigned k = 0; k < 3; k++) {
+      uint32_t a = v[k], b = v[(k + 1) % 3];
+      if(edges[edgeKey(a, b)] != 1) continue;
+
+      Vec edge = _position[b] - _position[a];
+      double edgeLength = edge.length();
+      Vec perpendicular = edge.cross(n);
+      double perpendicularLength = perpendicular.length();
+      if(perpendicularLength == 0) continue;
+
+      Vec pn {perpendicular.x / perpendicularLength, perpendicular.y / perpendicularLength,
+              perpendicular.z / perpendicularLength};
+
+      //weighted by squared length, to be comparable to the triangle areas
+      Quadric border;
+      border.addPlane(pn, -pn.dot(_position[a]), edgeLength * edgeLength * borderWeight);
+      _quadrics[a] += border;
+      _quadrics[b] += border;
+    }
+  }
+}
+
+void Collapser::buildAdjacency()
+{
+  //vertex -> triangles
+  _triangles.build(_vertexCount, _index.size(), [this](function<void(uint32_t, uint32_t)> add) {
+    for(size_t i = 0; i < _index.size(); i++) add(_remap[_index[i]], (uint32_t)(i / 3));
+  });
+
+  //vertex -> wedges. Duplicates are harmless
+  _wedges.build(_vertexCount, _index.size(), [this](function<void(uint32_t, uint32_t)> add) {
+    for(size_t i = 0; i < _index.size(); i++) add(_remap[_index[i]], _index[i]);
+  });
+}
+
+bool Collapser::mapWedges(uint32_t from, uint32_t to, double edgeLengthSq, double &cost)
+{
+  _wedgeMap.clear();
+  cost = 0;
+
+  for(const uint32_t *w = _wedges.begin(from); w != _wedges.end(from); w++) {
+    uint32_t p = *w;
+
+    bool known = false;
+    for(const auto &m : _wedgeMap) if(m.first == p) known = true;
+    if(known) continue;
+
+    //a triangle containing wedge p and vertex to tells which wedge of to replaces p
+    uint32_t q = numeric_limits<uint32_t>::max();
+    for(const uint32_t *t = _triangles.begin(from); t != _triangles.end(from) && q == numeric_limits<uint32_t>::max(); t++) {
+      uint32_t corner = *t * 3;
+
+      bool hasP = false;
+      for(unsigned k = 0; k < 3; k++) if(wedge(corner + k) == p) hasP = true;
+      if(!hasP) continue;
+
+      for(unsigned k = 0; k < 3; k++) {
+        if(vertex(corner + k) == to) q = wedge(corner + k);
+      }
+    }
+    if(q == numeric_limits<uint32_t>::max()) return false;
+
+    _wedgeMap.emplace_back(p, q);
+
+    double deviation = 0;
+    if(_normal && _options.normalWeight > 0) {
+      const float *np = _normal + p * 3, *nq = _normal + q * 3;
+      double dot = np[0] * nq[0] + np[1] * nq[1] + np[2] * nq[2];
+      deviation += _options.normalWeight * (1.0 - std::min(dot, 1.0));
+    }
+    if(_uv && _options.uvWeight > 0) {
+      double du = _uv[p * 2] - _uv[q * 2], dv = _uv[p * 2 + 1] - _uv[q * 2 + 1];
+      deviation += _options.uvWeight * (du * du + dv * dv);
+    }
+    cost = std::max(cost, deviation * edgeLengthSq);
+  }
+  return true;
+}
+
+double Collapser::cost(uint32_t from, uint32_t to, bool borderEdge, bool &possible, double &error)
+{
+  possible = false;
+  error = 0;
+
+  if(_kind[from] == Kind::Locked) return 0;
+
+  //border vertices may only slide along the border
+  if(_kind[from] == Kind::Border && (_kind[to] != Kind::Border || !borderEdge)) return 0;
+
+  const Vec &target = _position[to];
+  Quadric q = _quadrics[from];
+  q += _quadrics[to];
+
+  double attributeCost;
+  double edgeLengthSq = (target - _position[from]).dot(target - _position[from]);
+  if(!mapWedges(from, to, edgeLengthSq, attributeCost)) return 0;
+
+  possible = true;
+  error = q.error(target);
+  return error + attributeCost;
+}
+
+bool Collapser::valid(uint32_t from, uint32_t to, unsigned &removed)
+{
+  removed = 0;
+  _neighborsA.clear();
+  _neighborsB.clear();
+
+  for(const uint32_t *t = _triangles.begin(from); t != _triangles.end(from); t++) {
+    uint32_t corner = *t * 3;
+    uint32_t v[3] = {vertex(corner), vertex(corner + 1), vertex(corner + 2)};
+
+    //already degenerate by an earlier collapse
+    if(v[0] == v[1] || v[1] == v[2] || v[2] == v[0]) continue;
+
+    for(unsigned k = 0; k < 3; k++) if(v[k] != from) _neighborsA.push_back(v[k]);
+
+    if(v[0] == to || v[1] == to || v[2] == to) {
+      removed++;
+      continue;
+    }
+
+    //the triangle must not flip when from moves onto to
+    unsigned k = v[0] == from ? 0 : (v[1] == from ? 1 : 2);
+    const Vec &p1 = _position[v[(k + 1) % 3]], &p2 = _position[v[(k + 2) % 3]];
+
+    Vec before = (p1 - _position[from]).cross(p2 - _position[from]);
+    Vec after = (p1 - _position[to]).cross(p2 - _position[to]);
+
+    if(before.dot(after) <= 0.25 * before.length() * after.length()) return false;
+
+    //nor become a sliver. In a plane, the normals of near collinear triangles still agree
+    double span = (p1 - _position[to]).dot(p1 - _position[to]) + (p2 - _position[to]).dot(p2 - _position[to]);
+    if(after.length() <= 1e-6 * span) return false;
+  }
+  if(removed == 0) return false;
+
+  for(const uint32_t *t = _triangles.begin(to); t != _triangles.end(to); t++) {
+    uint32_t corner = *t * 3;
+    for(unsigned k = 0; k < 3; k++) {
+      uint32_t v = vertex(corner + k);
+      if(v != to) _neighborsB.push_back(v);
+    }
+  }
+
+  //link condition: the common neighbors are exactly the opposite vertices of the removed triangles
+  sort(_neighborsA.begin(), _neighborsA.end());
+  _neighborsA.erase(unique(_neighborsA.begin(), _neighborsA.end()), _neighborsA.end());
+  sort(_neighborsB.begin(), _neighborsB.end());
+  _neighborsB.erase(unique(_neighborsB.begin(), _neighborsB.end()), _neighborsB.end());
+
+  unsigned common = 0;
+  for(uint32_t v : _neighborsA) {
+    if(v != to && binary_search(_neighborsB.begin(), _neighborsB.end(), v)) common++;
+  }
+  return common == removed;
+}
+
+double Collapser::run(size_t target)
+{
+  double limit = (double)_options.maxError * _options.maxError;
+  double maxError = 0;
+
+  size_t triangles = _index.size() / 3;
+  vector<Collapse> candidates;
+
+  while(triangles > target) {
+
+    buildAdjacency();
+    _touched.assign(_vertexCount, false);
+
+    //border edges occur once
+    unordered_map<uint64_t, unsigned> edges(_index.size());
+    for(size_t i = 0; i < _index.size(); i += 3) {
+      for(unsigned k = 0; k < 3; k++) edges[edgeKey(_remap[_index[i + k]], _remap[_index[i + (k + 1) % 3]])]++;
+    }
+
+    candidates.clear();
+    for(const auto &edge : edges) {
+      uint32_t a = (uint32_t)(edge.first >> 32), b = (uint32_t)edge.first;
+      bool border = edge.second == 1;
+
+      bool possibleAB, possibleBA;
+      double errorAB, errorBA;
+      double costAB = cost(a, b, border, possibleAB, errorAB);
+      double costBA = cost(b, a, border, possibleBA, errorBA);
+
+      //attribute deviation only decides the order, the limit applies to the geometric error
+      if(possibleAB && errorAB > limit) possibleAB = false;
+      if(possibleBA && errorBA > limit) possibleBA = false;
+
+      if(possibleAB && (!possibleBA || costAB <= costBA)) {
+        candidates.push_back(Collapse {a, b, errorAB, costAB});
+      }
+      else if(possibleBA) {
+        candidates.push_back(Collapse {b, a, errorBA, costBA});
+      }
+    }
+    if(candidates.empty()) break;
+
+    sort(candidates.begin(), candidates.end(), [](const Collapse &c1, const Collapse &c2) {
+      return c1.cost < c2.cost;
+    });
+
+    size_t collapses = 0;
+    for(const Collapse &collapse : candidates) {
+      if(triangles <= target) break;
+      if(_touched[collapse.from] || _touched[collapse.to]) continue;
+
+      unsigned removed;
+      if(!valid(collapse.from, collapse.to, removed)) continue;
+
+      double attributeCost;
+      double edgeLengthSq = (_position[collapse.to] - _position[collapse.from]).dot(
+         _position[collapse.to] - _position[collapse.from]);
+      if(!mapWedges(collapse.from, collapse.to, edgeLengthSq, attributeCost)) continue;
+
+      for(const auto &m : _wedgeMap) _collapsed[m.first] = m.second;
+
+      _quadrics[collapse.to] += _quadrics[collapse.from];
+      _touched[collapse.from] = _touched[collapse.to] = true;
+
+      //the neighbors' triangles changed, leave them for the next pass
+      for(const uint32_t *t = _triangles.begin(collapse.from); t != _triangles.end(collapse.from); t++) {
+        for(unsigned k = 0; k < 3; k++) _touched[vertex(*t * 3 + k)] = true;
+      }
+
+      triangles -= removed;
+      maxError = std::max(maxError, collapse.error);
+      collapses++;
+    }
+    if(collapses == 0) break;
+
+    //apply the collapses and drop degenerate triangles
+    size_t write = 0;
+    for(size_t i = 0; i < _index.size(); i += 3) {
+      uint32_t a = _collapsed[_index[i]], b = _collapsed[_index[i + 1]], c = _collapsed[_index[i + 2]];
+      if(_remap[a] == _remap[b] || _remap[b] == _remap[c] || _remap[c] == _remap[a]) continue;
+
+      _index[write++] = a;
+      _index[write++] = b;
+      _index[write++] = c;
+    }
+    _index.resize(write);
+    triangles = write / 3;
+
+    for(uint32_t v = 0; v < _vertexCount; v++) _collapsed[v] = v;
+  }
+
+  return maxError;
+}
+
+}
+
+std::vector<uint32_t> Simplifier::simplify(const float *position, const float *normal, const float *uv,
+                                           size_t vertexCount, const std::vector<uint32_t> &index,
+                                           const Options &options, float *error)
+{
+  vector<uint32_t> result(index);
+  if(result.empty()) {
+    result.resize(vertexCount / 3 * 3);
+    for(uint32_t i = 0; i < result.size(); i++) result[i] = i;
+  }
+  if(error) *error = 0;
+  if(result.empty()) return result;
+
+  size_t target = options.targetTriangles ? options.targetTriangles
+                                          : (size_t)(result.size() / 3 * std::max(options.ratio, 0.0f));
+
+  Collapser collapser(position, normal, uv, vertexCount, result, options);
+  double maxError = collapser.run(target);
+
+  if(error) *error = (float)sqrt(maxError);
+  return result;
+}
+
+BufferGeometry::Ptr Simplifier::simplify(const BufferGeometry &geometry, const Options &options, float *error)
+{
+  if(!geometry.position() || !geometry.groups().empty()) return nullptr;
+
+  const BufferAttributeT<float>::Ptr &position = geometry.position();
+  const BufferAttributeT<float>::Ptr &normal = geometry.normal();
+  const BufferAttributeT<float>::Ptr &uv = geometry.uv();
+
+  //only the triangles inside the draw range are simplified, the result draws its complete index
+  const UpdateRange &range = geometry.drawRange();
+  vector<uint32_t> index;
+  if(geometry.index()) {
+    const uint32_t *data = geometry.index()->data_t();
+    size_t start = std::min(range.start, geometry.index()->size());
+    size_t end = start + std::min(range.count, geometry.index()->size() - start);
+    index.assign(data + start, data + start + (end - start) / 3 * 3);
+  }
+  else if(range.start != 0 || range.count < position->itemCount()) {
+    size_t start = std::min(range.start, position->itemCount());
+    size_t end = start + std::min(range.count, position->itemCount() - start);
+    for(size_t i = start; i + 3 <= end; i++) index.push_back((uint32_t)i);
+  }
+  if(index.empty() && (geometry.index() || range.start != 0 || range.count < position->itemCount()))
+    return nullptr;
+  size_t triangles = index.empty() ? position->itemCount() / 3 : index.size() / 3;
+
+  vector<uint32_t> simplified = simplify(position->data_t(),
+                                         normal ? normal->data_t() : nullptr,
+                                         uv && uv->itemSize() == 2 ? uv->data_t() : nullptr,
+                                         position->itemCount(), index, options, error);
+
+  if(simplified.empty() || simplified.size() / 3 >= triangles) return nullptr;
+
+  //share the vertex attributes
+  BufferGeometry::Ptr result = BufferGeometry::make();
+  *result = geometry;
+  result->setIndex(attribute::copied<uint32_t>(simplified));
+  result->setDrawRange(0, std::numeric_limits<size_t>::max());
+  if(geometry.tangents()) result->setTangents(geometry.tangents());
+  if(geometry.bitangents()) result->setBitangents(geometry.bitangents());
+  if(geometry.skinIndices()) result->setSkinIndices(geometry.skinIndices());
+  if(geometry.skinWeights()) result->setSkinWeights(geometry.skinWeights());
+
+  return result;
+}
+
+std::vector<BufferGeometry::Ptr> Simplifier::simplify(const std::vector<BufferGeometry::Ptr> &geometries,
+                                                      const Options &options)
+{
+  vector<BufferGeometry::Ptr> result(geometries.size());
+
+  parallel::for_each(0, geometries.size(), [&](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; i++) {
+      if(geometries[i]) result[i] = simplify(*geometries[i], options);
+    }
+  });
+
+  return result;
+}
+
+}
@@ -0,0 +1,79 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_SIMPLIFIER_H
+#define THREEPP_SIMPLIFIER_H
+
+#include <vector>
+#include "BufferGeometry.h"
+
+namespace three {
+
+/**
+ * mesh simplification by iterative edge collapse, ordered by quadric error. Vertices are only removed,
+ * never moved, so the simplified index refers to the original vertex attributes, which can be shared
+ * among all levels of detail. Vertices with identical positions but different attributes (seams) are
+ * collapsed together, and only along the seam. Normal and uv deviations take part in ordering the
+ * collapses, but not in the geometric error
+ */
+class DLX Simplifier
+{
+public:
+  struct Options
+  {
+    //fraction of triangles to keep, used if targetTriangles is 0
+    float ratio = 0.5f;
+
+    //the number of triangles to reduce to
+    size_t targetTriangles = 0;
+
+    //the maximum geometric error, relative to the largest extent of the mesh. The error of a vertex is
+    //the area weighted root mean square distance to the planes of the triangles merged into it
+    float maxError = 0.01f;
+
+    //weight of normal deviation in the collapse cost
+    float normalWeight = 1.0f;
+
+    //weight of uv deviation in the collapse cost
+    float uvWeight = 1.0f;
+
+    //keep the vertices on open borders in place
+    bool lockBorder = false;
+  };
+
+  /**
+   * simplify a triangle mesh
+   *
+   * @param position vertex positions, 3 floats per vertex
+   * @param normal vertex normals or nullptr
+   * @param uv texture coordinates, 2 floats per vertex, or nullptr
+   * @param index triangle indices. If empty, consecutive vertex triples form the triangles
+   * @param error if not null, receives the largest geometric error accepted, relative to the mesh extent
+   * @return the simplified triangle indices
+   */
+  static std::vector<uint32_t> simplify(const float *position, const float *normal, const float *uv,
+                                        size_t vertexCount, const std::vector<uint32_t> &index,
+                                        const Options &options, float *error=nullptr);
+
+  /**
+   * simplify a triangle geometry
+   *
+   * @return a geometry sharing all vertex attributes including the skin with the source, with a new index
+   * built from the triangles inside the draw range. nullptr if the geometry has no positions, uses groups
+   * or could not be reduced
+   */
+  static BufferGeometry::Ptr simplify(const BufferGeometry &geometry, const Options &options, float *error=nullptr);
+
+  /**
+   * simplify a set of geometries concurrently
+   *
+   * @return the simplified geometries in the same order, nullptr where simplify() returned nullptr
+   */
+  static std::vector<BufferGeometry::Ptr> simplify(const std::vector<BufferGeometry::Ptr> &geometries,
+                                                   const Options &options);
+};
+
+}
+
+#endif //THREEPP_SIMPLIFIER_H
@@ -0,0 +1,262 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "VertexPacking.h"
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace three {
+
+using namespace std;
+
+half VertexPacking::toHalf(float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+
+  uint32_t sign = (bits >> 16) & 0x8000;
+  int32_t exponent = (int32_t)((bits >> 23) & 0xff) - 127 + 15;
+  uint32_t mantissa = bits & 0x7fffff;
+
+  half result;
+
+  if(((bits >> 23) & 0xff) == 0xff) {
+    //infinity, NaN
+    result.bits = (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+  }
+  else if(exponent >= 0x1f) {
+    //overflow to infinity
+    result.bits = (uint16_t)(sign | 0x7c00);
+  }
+  else if(exponent <= 0) {
+    //subnormal or zero
+    if(exponent < -10) {
+      result.bits = (uint16_t)sign;
+    }
+    else {
+      mantissa |= 0x800000;
+      uint32_t shift = (uint32_t)(14 - exponent);
+      uint32_t rounded = (mantissa + (1u << (shift - 1))) >> shift;
+      result.bits = (uint16_t)(sign | rounded);
+    }
+  }
+  else {
+    //round to nearest, a carry into the exponent is correct
+    uint32_t rounded = ((uint32_t)exponent << 10 | mantissa >> 13) + ((mantissa >> 12) & 1);
+    result.bits = (uint16_t)(sign | std::min(rounded, 0x7c00u));
+  }
+  return result;
+}
+
+float VertexPacking::fromHalf(half value)
+{
+  uint32_t sign = (uint32_t)(value.bits & 0x8000) << 16;
+  uint32_t exponent = (value.bits >> 10) & 0x1f;
+  uint32_t mantissa = value.bits & 0x3ff;
+
+  if(exponent == 0) {
+    float result = ldexp((float)mantissa, -24);
+    return sign ? -result : result;
+  }
+
+  uint32_t bits = exponent == 0x1f ? sign | 0x7f800000 | mantissa << 13
+                                   : sign | (exponent + 127 - 15) << 23 | mantissa << 13;
+  float result;
+  memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+void VertexPacking::octEncode(float x, float y, float z, float &u, float &v)
+{
+  float l1 = fabs(x) + fabs(y) + fabs(z);
+  if(l1 == 0) {
+    u = v = 0;
+    return;
+  }
+  u = x / l1;
+  v = y / l1;
+
+  //fold the lower hemisphere over the diagonals
+  if(z < 0) {
+    float fu = (1 - fabs(v)) * (u >= 0 ? 1 : -1);
+    float fv = (1 - fabs(u)) * (v >= 0 ? 1 : -1);
+    u = fu;
+    v = fv;
+  }
+}
+
+void VertexPacking::octDecode(float u, float v, float &x, float &y, float &z)
+{
+  x = u;
+  y = v;
+  z = 1 - fabs(u) - fabs(v);
+
+  float t = std::max(-z, 0.0f);
+  x += x >= 0 ? -t : t;
+  y += y >= 0 ? -t : t;
+
+  float length = sqrt(x * x + y * y + z * z);
+  if(length > 0) {
+    x /= length;
+    y /= length;
+    z /= length;
+  }
+}
+
+int8_t VertexPacking::snorm8(float value)
+{
+  return (int8_t)lround(std::max(-1.0f, std::min(1.0f, value)) * 127.0f);
+}
+
+int16_t VertexPacking::snorm16(float value)
+{
+  return (int16_t)lround(std::max(-1.0f, std::min(1.0f, value)) * 32767.0f);
+}
+
+uint8_t VertexPacking::unorm8(float value)
+{
+  return (uint8_t)lround(std::max(0.0f, std::min(1.0f, value)) * 255.0f);
+}
+
+uint16_t VertexPacking::unorm16(float value)
+{
+  return (uint16_t)lround(std::max(0.0f, std::min(1.0f, value)) * 65535.0f);
+}
+
+namespace {
+
+template <typename T>
+BufferAttribute::Ptr packNormals(const BufferAttributeT<float>::Ptr &normal, T (*convert)(float))
+{
+  using Item = array<T, 2>;
+
+  vector<Item> items(normal->itemCount());
+  for(size_t i = 0; i < items.size(); i++) {
+    float u, v;
+    VertexPacking::octEncode(normal->get_x(i), normal->get_y(i), normal->get_z(i), u, v);
+    items[i] = Item {{convert(u), convert(v)}};
+  }
+  return attribute::copied<T, Item>(items, true);
+}
+
+}
+
+PackedAttributes::Ptr VertexPacking::pack(const BufferGeometry &geometry, const Options &options)
+{
+  PackedAttributes::Ptr packed = make_shared<PackedAttributes>();
+  bool any = false;
+
+  const BufferAttributeT<float>::Ptr &position = geometry.position();
+  if(options.position && position && position->itemSize() == 3 && position->itemCount() > 0) {
+
+    using Item = array<uint16_t, 4>;
+
+    math::Box3 box = position->box3();
+    math::Vector3 size = box.getSize();
+    math::Vector3 scale(size.x() > 0 ? size.x() : 1, size.y() > 0 ? size.y() : 1, size.z() > 0 ? size.z() : 1);
+
+    //4 components keep the vertices 4 byte aligned
+    vector<Item> items(position->itemCount());
+    for(size_t i = 0; i < items.size(); i++) {
+      items[i] = Item {{unorm16((position->get_x(i) - box.min().x()) / scale.x()),
+                        unorm16((position->get_y(i) - box.min().y()) / scale.y()),
+                        unorm16((position->get_z(i) - box.min().z()) / scale.z()), 0}};
+    }
+    packed->position = attribute::copied<uint16_t, Item>(items, true);
+    packed->versions.add(position);
+    packed->positionOffset = box.min();
+    packed->positionScale = scale;
+    any = true;
+  }
+
+  const BufferAttributeT<float>::Ptr &normal = geometry.normal();
+  if(options.normal != NormalFormat::None && normal && normal->itemSize() == 3) {
+
+    if(options.normal == NormalFormat::Oct8)
+      packed->normal = packNormals<int8_t>(normal, snorm8);
+    else
+      packed->normal = packNormals<int16_t>(normal, snorm16);
+    packed->versions.add(normal);
+    any = true;
+  }
+
+  const BufferAttributeT<float>::Ptr &uv = geometry.uv();
+  if(options.uv && uv && uv->itemSize() == 2) {
+
+    const float *data = uv->data<float>();
+    bool inRange = all_of(data, data + uv->size(), [&options](float value) {
+      return fabs(value) <= options.uvRange;
+    });
+
+    if(inRange) {
+      using Item = array<half, 2>;
+
+      vector<Item> items(uv->itemCount());
+      for(size_t i = 0; i < items.size(); i++) {
+        items[i] = Item {{toHalf(uv->get_x(i)), toHalf(uv->get_y(i))}};
+      }
+      packed->uv = attribute::copied<half, Item>(items);
+      packed->versions.add(uv);
+      any = true;
+    }
+  }
+
+  const BufferAttributeT<float>::Ptr &color = geometry.color();
+  if(options.color && color && color->itemSize() <= 4) {
+
+    using Item = array<uint8_t, 4>;
+
+    const float *data = color->data<float>();
+    unsigned itemSize = color->itemSize();
+
+    //padded to 4 bytes, the shader reads rgb
+    vector<Item> items(color->itemCount());
+    for(size_t i = 0; i < items.size(); i++) {
+      Item item {{0, 0, 0, 255}};
+      for(unsigned k = 0; k < itemSize; k++) item[k] = unorm8(data[i * itemSize + k]);
+      items[i] = item;
+    }
+    packed->color = attribute::copied<uint8_t, Item>(items, true);
+    packed->versions.add(color);
+    any = true;
+  }
+
+  if(!any) return nullptr;
+
+  packed->repack = [options](const BufferGeometry &geometry) {return pack(geometry, options);};
+  return packed;
+}
+
+PackedAttributes::Ptr VertexPacking::pack(const BufferGeometry &geometry)
+{
+  return pack(geometry, Options());
+}
+
+bool VertexPacking::apply(BufferGeometry &geometry, const Options &options)
+{
+  PackedAttributes::Ptr packed = pack(geometry, options);
+  geometry.setPacked(packed);
+  return (bool)packed;
+}
+
+bool VertexPacking::apply(BufferGeometry &geometry)
+{
+  return apply(geometry, Options());
+}
+
+size_t VertexPacking::byteCount(BufferGeometry &geometry)
+{
+  size_t count = 0;
+  for(AttributeName name : {AttributeName::position, AttributeName::normal, AttributeName::uv,
+                            AttributeName::uv2, AttributeName::color, AttributeName::skinIndex,
+                            AttributeName::skinWeight}) {
+    BufferAttribute::Ptr attribute = geometry.getAttribute(name);
+    if(attribute) count += attribute->byteCount();
+  }
+  return count;
+}
+
+}
@@ -0,0 +1,82 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_VERTEXPACKING_H
+#define THREEPP_VERTEXPACKING_H
+
+#include <cstdint>
+#include "BufferGeometry.h"
+
+namespace three {
+
+/**
+ * conversion of float vertex attributes to compact formats. Positions become normalized 16 bit integers
+ * relative to the bounding box, normals are octahedrally mapped to 2 normalized integers, uvs become
+ * half floats and colors normalized bytes. The renderer decodes positions and normals in the vertex
+ * shader; the other formats are converted by the vertex fetch. A typical mesh with positions, normals
+ * and uvs shrinks from 32 to 16 bytes per vertex
+ */
+class DLX VertexPacking
+{
+public:
+  enum class NormalFormat {None, Oct8, Oct16};
+
+  struct Options
+  {
+    bool position = true;
+
+    NormalFormat normal = NormalFormat::Oct16;
+
+    //uvs are only packed if all coordinates lie within [-uvRange, uvRange], since half float precision
+    //decreases with magnitude
+    bool uv = true;
+    float uvRange = 2.0f;
+
+    bool color = true;
+  };
+
+  static half toHalf(float value);
+
+  static float fromHalf(half value);
+
+  /**
+   * map a unit vector onto the octahedron and unfold it into [-1, 1]²
+   */
+  static void octEncode(float x, float y, float z, float &u, float &v);
+
+  static void octDecode(float u, float v, float &x, float &y, float &z);
+
+  //quantize to normalized integers with rounding, as decoded by OpenGL
+  static int8_t snorm8(float value);
+  static int16_t snorm16(float value);
+  static uint8_t unorm8(float value);
+  static uint16_t unorm16(float value);
+
+  /**
+   * create packed attributes for a geometry
+   *
+   * @return the packed attributes, nullptr if nothing could be packed
+   */
+  static PackedAttributes::Ptr pack(const BufferGeometry &geometry, const Options &options);
+
+  static PackedAttributes::Ptr pack(const BufferGeometry &geometry);
+
+  /**
+   * pack the geometry's attributes and attach the result to it
+   *
+   * @return true if any attribute was packed
+   */
+  static bool apply(BufferGeometry &geometry, const Options &options);
+
+  static bool apply(BufferGeometry &geometry);
+
+  /**
+   * @return the number of vertex attribute bytes uploaded for rendering
+   */
+  static size_t byteCount(BufferGeometry &geometry);
+};
+
+}
+
+#endif //THREEPP_VERTEXPACKING_H
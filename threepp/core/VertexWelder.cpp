@@ -0,0 +1,339 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "VertexWelder.h"
+#include <cmath>
+#include <algorithm>
+
+namespace three {
+
+using namespace std;
+
+const uint32_t VertexWelder::unused;
+
+namespace {
+
+struct Compared
+{
+  const float *data;
+  unsigned itemSize;
+  float tolerance;
+};
+
+/**
+ * the attributes compared between vertices. Positions first, since they differ most often
+ */
+vector<Compared> comparedAttributes(const BufferGeometry &geometry, const VertexWelder::Options &options)
+{
+  const BufferAttributeT<float>::Ptr &position = geometry.position();
+  size_t vertexCount = position->itemCount();
+
+  vector<Compared> compared;
+  auto add = [&](const BufferAttributeT<float>::Ptr &attribute, float tolerance) {
+    if(attribute && attribute->itemCount() == vertexCount)
+      compared.push_back({attribute->data_t(), attribute->itemSize(), tolerance});
+  };
+
+  add(position, 0);
+
+  //attributes which move the vertex
+  for(const auto &morph : geometry.morphPositions()) add(morph, options.positionTolerance);
+  for(const auto &indexed : geometry.indexedAttributes()) {
+    if(indexed.first.first == IndexedAttributeName::morphTarget) add(indexed.second, options.positionTolerance);
+  }
+  add(geometry.skinWeights(), options.attributeTolerance);
+
+  //bone indices must match
+  add(geometry.skinIndices(), 0);
+
+  if(options.positionsOnly) return compared;
+
+  for(const auto &attribute : {geometry.normal(), geometry.uv(), geometry.uv2(), geometry.color(),
+                               geometry.tangents(), geometry.bitangents()})
+    add(attribute, options.attributeTolerance);
+
+  for(const auto &morph : geometry.morphNormals()) add(morph, options.attributeTolerance);
+  for(const auto &indexed : geometry.indexedAttributes()) {
+    if(indexed.first.first == IndexedAttributeName::morphNormal) add(indexed.second, options.attributeTolerance);
+  }
+
+  return compared;
+}
+
+//open addressing table of the welded vertices, keyed by grid cell
+class CellTable
+{
+  struct Entry
+  {
+    int32_t x, y, z;
+    uint32_t vertex;
+  };
+
+  vector<Entry> _entries;
+  size_t _mask;
+
+  size_t hash(int32_t x, int32_t y, int32_t z) const
+  {
+    return ((uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)z * 83492791u) & _mask;
+  }
+
+public:
+  explicit CellTable(size_t count)
+  {
+    size_t capacity = 16;
+    while(capacity < count * 2) capacity *= 2;
+
+    _entries.resize(capacity, Entry {0, 0, 0, VertexWelder::unused});
+    _mask = capacity - 1;
+  }
+
+  void insert(int32_t x, int32_t y, int32_t z, uint32_t vertex)
+  {
+    size_t slot = hash(x, y, z);
+    while(_entries[slot].vertex != VertexWelder::unused) slot = (slot + 1) & _mask;
+
+    _entries[slot] = Entry {x, y, z, vertex};
+  }
+
+  //@return the first vertex in the cell that match accepts, or unused
+  template <typename Match>
+  uint32_t find(int32_t x, int32_t y, int32_t z, Match match) const
+  {
+    for(size_t slot = hash(x, y, z); _entries[slot].vertex != VertexWelder::unused; slot = (slot + 1) & _mask) {
+      const Entry &entry = _entries[slot];
+      if(entry.x == x && entry.y == y && entry.z == z && match(entry.vertex)) return entry.vertex;
+    }
+    return VertexWelder::unused;
+  }
+};
+
+int32_t cellCoordinate(float value, float cellSize)
+{
+  //distinct cells folding onto one coordinate only cost comparisons
+  return (int32_t)(int64_t)std::floor(value / cellSize);
+}
+
+BufferAttributeT<float>::Ptr compacted(const BufferAttributeT<float>::Ptr &attribute,
+                                       const vector<uint32_t> &kept, size_t vertexCount)
+{
+  if(!attribute || attribute->itemCount() != vertexCount) return attribute;
+
+  unsigned itemSize = attribute->itemSize();
+  bool normalized = attribute->normalized();
+
+  BufferAttributeT<float>::Ptr result;
+  switch(itemSize) {
+    case 1:
+      result = attribute::prealloc<float>(kept.size(), normalized);
+      break;
+    case 2:
+      result = attribute::prealloc<float, UV>(kept.size(), normalized);
+      break;
+    case 3:
+      result = attribute::prealloc<float, Vertex>(kept.size(), normalized);
+      break;
+    case 4:
+      result = attribute::prealloc<float, math::Vector4>(kept.size(), normalized);
+      break;
+    default:
+      return attribute;
+  }
+  result->dynamic = attribute->dynamic;
+
+  const float *source = attribute->data_t();
+  float *target = result->data<float>();
+  for(size_t v = 0; v < kept.size(); v++) {
+    copy(source + kept[v] * itemSize, source + (kept[v] + 1) * itemSize, target + v * itemSize);
+  }
+  return result;
+}
+
+}
+
+vector<uint32_t> VertexWelder::remap(const BufferGeometry &geometry, const Options &options, size_t &uniqueCount)
+{
+  uniqueCount = 0;
+
+  const BufferAttributeT<float>::Ptr &position = geometry.position();
+  if(!position || position->itemSize() != 3) return vector<uint32_t>();
+
+  size_t vertexCount = position->itemCount();
+  vector<uint32_t> remap(vertexCount, unused);
+
+  //only referenced vertices are welded
+  vector<char> referenced(vertexCount, geometry.index() ? 0 : 1);
+  if(geometry.index()) {
+    const uint32_t *index = geometry.index()->data_t();
+    for(size_t i = 0, n = geometry.index()->size(); i < n; i++) {
+      if(index[i] < vertexCount) referenced[index[i]] = 1;
+    }
+  }
+
+  vector<Compared> compared = comparedAttributes(geometry, options);
+  const float *positions = position->data_t();
+
+  //cells much larger than the tolerance, so most positions are not near enough to a cell border to
+  //require looking into the neighbour cell
+  float tolerance = max(options.positionTolerance, 0.0f);
+  float cellSize = tolerance > 0 ? tolerance * 16 : 1.0f;
+  float toleranceSq = tolerance * tolerance;
+
+  auto equal = [&](uint32_t a, uint32_t b) {
+    const float *pa = positions + a * 3, *pb = positions + b * 3;
+    float dx = pa[0] - pb[0], dy = pa[1] - pb[1], dz = pa[2] - pb[2];
+    if(dx * dx + dy * dy + dz * dz > toleranceSq) return false;
+
+    for(size_t c = 1; c < compared.size(); c++) {
+      const Compared &attribute = compared[c];
+      const float *va = attribute.data + a * attribute.itemSize, *vb = attribute.data + b * attribute.itemSize;
+      for(unsigned k = 0; k < attribute.itemSize; k++) {
+        if(std::fabs(va[k] - vb[k]) > attribute.tolerance) return false;
+      }
+    }
+    return true;
+  };
+
+  CellTable table(vertexCount);
+
+  for(uint32_t v = 0; v < vertexCount; v++) {
+    if(!referenced[v]) continue;
+
+    const float *p = positions + v * 3;
+    if(!std::isfinite(p[0]) || !std::isfinite(p[1]) || !std::isfinite(p[2])) {
+      remap[v] = (uint32_t)uniqueCount++;
+      continue;
+    }
+
+    //the cell and, per axis, the neighbour within tolerance if any
+    int32_t cell[3], neighbour[3];
+    unsigned near = 0;
+    for(unsigned k = 0; k < 3; k++) {
+      float offset = p[k] - std::floor(p[k] / cellSize) * cellSize;
+      cell[k] = cellCoordinate(p[k], cellSize);
+      neighbour[k] = offset < cellSize / 2 ? cell[k] - 1 : cell[k] + 1;
+      if(tolerance > 0 && min(offset, cellSize - offset) <= tolerance) near |= 1 << k;
+    }
+
+    uint32_t found = unused;
+    for(unsigned n = 0; n < 8 && found == unused; n++) {
+      if((n & near) != n) continue;
+
+      int32_t x = n & 1 ? neighbour[0] : cell[0];
+      int32_t y = n & 2 ? neighbour[1] : cell[1];
+      int32_t z = n & 4 ? neighbour[2] : cell[2];
+
+      found = table.find(x, y, z, [&](uint32_t other) {return equal(v, other);});
+    }
+
+    if(found != unused) {
+      remap[v] = remap[found];
+    }
+    else {
+      remap[v] = (uint32_t)uniqueCount++;
+      table.insert(cell[0], cell[1], cell[2], v);
+    }
+  }
+  return remap;
+}
+
+size_t VertexWelder::weld(BufferGeometry &geometry, const Options &options)
+{
+  size_t uniqueCount;
+  vector<uint32_t> remap = VertexWelder::remap(geometry, options, uniqueCount);
+  if(remap.empty()) return 0;
+
+  size_t vertexCount = remap.size();
+
+  //the first vertex of each welded set supplies its attributes
+  vector<uint32_t> kept(uniqueCount, unused);
+  for(uint32_t v = 0; v < vertexCount; v++) {
+    if(remap[v] != unused && kept[remap[v]] == unused) kept[remap[v]] = v;
+  }
+
+  //rewrite the index, dropping degenerate triangles
+  vector<uint32_t> index;
+  if(geometry.index()) {
+    const uint32_t *source = geometry.index()->data_t();
+    index.assign(source, source + geometry.index()->size());
+  }
+  else {
+    index.resize(vertexCount);
+    for(uint32_t v = 0; v < vertexCount; v++) index[v] = v;
+  }
+  for(uint32_t &i : index) {
+    if(i < vertexCount) i = remap[i];
+  }
+
+  if(options.removeDegenerate) {
+    size_t triangleCount = index.size() / 3;
+
+    //removed triangles before each triangle, for adjusting the groups
+    vector<uint32_t> removed(triangleCount + 1, 0);
+    size_t out = 0;
+    for(size_t t = 0; t < triangleCount; t++) {
+      uint32_t a = index[t * 3], b = index[t * 3 + 1], c = index[t * 3 + 2];
+      bool degenerate = a == b || b == c || c == a;
+
+      removed[t + 1] = removed[t] + (degenerate ? 1 : 0);
+      if(!degenerate) {
+        index[out++] = a;
+        index[out++] = b;
+        index[out++] = c;
+      }
+    }
+    //trailing indices that do not form a triangle
+    for(size_t i = triangleCount * 3; i < index.size(); i++) index[out++] = index[i];
+    index.resize(out);
+
+    if(removed[triangleCount] > 0 && !geometry.groups().empty()) {
+      vector<Group> groups = geometry.groups();
+      geometry.clearGroups();
+
+      for(const Group &group : groups) {
+        size_t first = min(group.start / 3, triangleCount);
+        size_t last = min((group.start + group.count) / 3, triangleCount);
+        size_t start = group.start - removed[first] * 3;
+        size_t count = group.count - (removed[last] - removed[first]) * 3;
+        geometry.addGroup((uint32_t)start, (uint32_t)count, (uint32_t)group.materialIndex);
+      }
+    }
+  }
+
+  geometry.setPosition(compacted(geometry.position(), kept, vertexCount));
+  geometry.setNormal(compacted(geometry.normal(), kept, vertexCount));
+  geometry.setColor(compacted(geometry.color(), kept, vertexCount));
+  geometry.setUV(compacted(geometry.uv(), kept, vertexCount));
+  geometry.setUV2(compacted(geometry.uv2(), kept, vertexCount));
+  geometry.setTangents(compacted(geometry.tangents(), kept, vertexCount));
+  geometry.setBitangents(compacted(geometry.bitangents(), kept, vertexCount));
+  geometry.setSkinIndices(compacted(geometry.skinIndices(), kept, vertexCount));
+  geometry.setSkinWeights(compacted(geometry.skinWeights(), kept, vertexCount));
+  geometry.setLineDistances(compacted(
+     dynamic_pointer_cast<BufferAttributeT<float>>(geometry.getAttribute(AttributeName::lineDistances)), kept, vertexCount));
+
+  for(auto &morph : geometry.getMorphPositions()) morph = compacted(morph, kept, vertexCount);
+  for(auto &morph : geometry.getMorphNormals()) morph = compacted(morph, kept, vertexCount);
+
+  //copied first, since addAttribute replaces the entries
+  auto indexedAttributes = geometry.indexedAttributes();
+  for(const auto &indexed : indexedAttributes) {
+    geometry.addAttribute(indexed.first.first, indexed.first.second, compacted(indexed.second, kept, vertexCount));
+  }
+
+  //a new attribute, so derived structures (BVH) are rebuilt
+  geometry.setIndex(attribute::copied<uint32_t>(index));
+
+  //unreferenced vertices were dropped, recomputed on demand
+  geometry.boundingBox().makeEmpty();
+  geometry.boundingSphere() = math::Sphere();
+
+  return vertexCount - uniqueCount;
+}
+
+size_t VertexWelder::weld(BufferGeometry &geometry)
+{
+  return weld(geometry, Options());
+}
+
+}
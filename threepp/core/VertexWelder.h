@@ -0,0 +1,63 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_VERTEXWELDER_H
+#define THREEPP_VERTEXWELDER_H
+
+#include <vector>
+#include "BufferGeometry.h"
+
+namespace three {
+
+/**
+ * merges the vertices of a triangle geometry whose attributes are all equal within a tolerance, as
+ * produced by importers that split vertices per face. Positions are hashed into a grid in a flat open
+ * addressing table, so each vertex is only compared against the vertices in the neighbouring cells.
+ * The remap is built in one pass over the vertices, and attributes and index are compacted in linear
+ * time. Vertices not referenced by any triangle are dropped
+ */
+class DLX VertexWelder
+{
+public:
+  //remap entry of an unreferenced vertex
+  static const uint32_t unused = 0xffffffff;
+
+  struct Options
+  {
+    //maximum distance between merged positions
+    float positionTolerance = 1e-5f;
+
+    //maximum difference per component of all other attributes
+    float attributeTolerance = 1e-4f;
+
+    //remove the triangles that collapse to a line or a point
+    bool removeDegenerate = true;
+
+    //ignore the shading attributes (normals, uvs, colors, tangents), for identifying the vertices of the
+    //surface. Morph positions and skinning are still compared, vertices they move apart stay separate
+    bool positionsOnly = false;
+  };
+
+  /**
+   * compute the new position of each vertex. Non-indexed geometries are treated as if indexed in order
+   *
+   * @param uniqueCount receives the number of vertices after welding
+   * @return the new index of each vertex, or unused
+   */
+  static std::vector<uint32_t> remap(const BufferGeometry &geometry, const Options &options, size_t &uniqueCount);
+
+  /**
+   * weld a geometry in place. Vertex attributes are replaced by compacted copies, non-indexed
+   * geometries receive an index, and groups are adjusted to removed triangles
+   *
+   * @return the number of vertices removed
+   */
+  static size_t weld(BufferGeometry &geometry, const Options &options);
+
+  static size_t weld(BufferGeometry &geometry);
+};
+
+}
+
+#endif //THREEPP_VERTEXWELDER_H
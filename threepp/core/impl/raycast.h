@@ -25,7 +25,8 @@ inline bool checkIntersection(const Object3D &object,
                               const Raycaster &raycaster,
                               const math::Ray &ray,
                               const math::Vector3 &pA, const math::Vector3 &pB, const math::Vector3 &pC,
-                              Intersection &result)
+                              Intersection &result,
+                              math::Vector3 *localPoint=nullptr)
 {
   bool intersect;
   if (material.side == Side::Back) {
@@ -43,6 +44,7 @@ inline bool checkIntersection(const Object3D &object,
 
   if (!intersect) return false;
 
+  if(localPoint) *localPoint = result.point;
   result.point.apply(object.matrixWorld());
 
   float distance = raycaster.origin().distanceTo(result.point);
@@ -81,14 +83,15 @@ inline bool checkBufferGeometryIntersection(const Object3D &object,
   const math::Vector3 &vB = position->item_at<math::Vector3>(b);
   const math::Vector3 &vC = position->item_at<math::Vector3>(c);
 
-  if (checkIntersection(object, material, raycaster, ray, vA, vB, vC, intersection)) {
+  math::Vector3 localPoint;
+  if (checkIntersection(object, material, raycaster, ray, vA, vB, vC, intersection, &localPoint)) {
 
     if(uv) {
       const math::Vector2 &uvA = uv->item_at<math::Vector2>(a);
       const math::Vector2 &uvB = uv->item_at<math::Vector2>(b);
       const math::Vector2 &uvC = uv->item_at<math::Vector2>(c);
 
-      intersection.uv = uvIntersection(intersection.point, vA, vB, vC, uvA, uvB, uvC);
+      intersection.uv = uvIntersection(localPoint, vA, vB, vC, uvA, uvB, uvC);
     }
 
     intersection.face = Face3(a, b, c, math::Triangle::normal(vA, vB, vC));
@@ -100,6 +103,64 @@ inline bool checkBufferGeometryIntersection(const Object3D &object,
   return false;
 }
 
+/**
+ * like checkBufferGeometryIntersection, but only determines the hit point and distance, and rejects
+ * hits beyond limit. The face normal and uv are left to completeBufferGeometryIntersection
+ */
+inline bool checkBufferGeometryHit(const Object3D &object,
+                                   const Material &material,
+                                   const Raycaster &raycaster,
+                                   const math::Ray &ray,
+                                   const BufferAttributeT<float>::Ptr &position,
+                                   unsigned a, unsigned b, unsigned c,
+                                   float limit,
+                                   Intersection &intersection)
+{
+  const math::Vector3 &vA = position->item_at<math::Vector3>(a);
+  const math::Vector3 &vB = position->item_at<math::Vector3>(b);
+  const math::Vector3 &vC = position->item_at<math::Vector3>(c);
+
+  if (!checkIntersection(object, material, raycaster, ray, vA, vB, vC, intersection)) return false;
+  if (intersection.distance > limit) return false;
+
+  intersection.face.a = a;
+  intersection.face.b = b;
+  intersection.face.c = c;
+  intersection.faceIndex = a;
+  intersection.deferred = true;
+
+  return true;
+}
+
+/**
+ * compute face normal and uv of a hit found by checkBufferGeometryHit
+ */
+inline void completeBufferGeometryIntersection(const Object3D &object,
+                                               const BufferAttributeT<float>::Ptr &position,
+                                               const BufferAttributeT<float>::Ptr &uv,
+                                               Intersection &intersection)
+{
+  unsigned a = intersection.face.a, b = intersection.face.b, c = intersection.face.c;
+
+  const math::Vector3 &vA = position->item_at<math::Vector3>(a);
+  const math::Vector3 &vB = position->item_at<math::Vector3>(b);
+  const math::Vector3 &vC = position->item_at<math::Vector3>(c);
+
+  intersection.face.normal = math::Triangle::normal(vA, vB, vC);
+
+  if(uv) {
+    math::Vector3 point = intersection.point;
+    point.apply(object.matrixWorld().inverted());
+
+    const math::Vector2 &uvA = uv->item_at<math::Vector2>(a);
+    const math::Vector2 &uvB = uv->item_at<math::Vector2>(b);
+    const math::Vector2 &uvC = uv->item_at<math::Vector2>(c);
+
+    intersection.uv = uvIntersection(point, vA, vB, vC, uvA, uvB, uvC);
+  }
+  intersection.deferred = false;
+}
+
 }
 }
 #endif //THREEPP_RAYCAST_H
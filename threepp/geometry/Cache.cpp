@@ -0,0 +1,85 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "Cache.h"
+#include <mutex>
+#include <algorithm>
+#include <unordered_map>
+
+namespace three {
+namespace geometry {
+
+namespace {
+
+struct Entries
+{
+  std::mutex mutex;
+  std::unordered_map<std::string, std::weak_ptr<Geometry>> map;
+
+  //expired entries are swept when the map grows beyond this
+  size_t sweepAt = 64;
+
+  void sweep()
+  {
+    for(auto it = map.begin(); it != map.end(); ) {
+      if(it->second.expired()) it = map.erase(it);
+      else it++;
+    }
+    sweepAt = std::max<size_t>(64, map.size() * 2);
+  }
+};
+
+//never destroyed, geometries may be released during static destruction
+Entries &entries()
+{
+  static Entries *entries = new Entries();
+  return *entries;
+}
+
+}
+
+Geometry::Ptr Cache::find(const std::string &key)
+{
+  Entries &e = entries();
+  std::lock_guard<std::mutex> lock(e.mutex);
+
+  auto found = e.map.find(key);
+  return found != e.map.end() ? found->second.lock() : nullptr;
+}
+
+Geometry::Ptr Cache::insert(const std::string &key, const Geometry::Ptr &geometry)
+{
+  Entries &e = entries();
+  std::lock_guard<std::mutex> lock(e.mutex);
+
+  std::weak_ptr<Geometry> &entry = e.map[key];
+
+  Geometry::Ptr existing = entry.lock();
+  if(existing) return existing;
+
+  entry = geometry;
+  if(e.map.size() > e.sweepAt) e.sweep();
+
+  return geometry;
+}
+
+size_t Cache::size()
+{
+  Entries &e = entries();
+  std::lock_guard<std::mutex> lock(e.mutex);
+
+  e.sweep();
+  return e.map.size();
+}
+
+void Cache::clear()
+{
+  Entries &e = entries();
+  std::lock_guard<std::mutex> lock(e.mutex);
+
+  e.map.clear();
+}
+
+}
+}
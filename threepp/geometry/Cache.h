@@ -0,0 +1,100 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_GEOM_CACHE_H
+#define THREEPP_GEOM_CACHE_H
+
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <type_traits>
+#include <threepp/core/Geometry.h>
+#include <threepp/util/osdecl.h>
+
+namespace three {
+namespace geometry {
+
+/**
+ * content addressed cache of generated geometries. A geometry is keyed by its type and the arguments
+ * passed to its make function, and shared by all objects requesting the same parameters. Since the
+ * renderer keeps GPU buffers per geometry, these are shared as well. Entries do not own the geometry,
+ * it is released together with its last user.
+ *
+ * Cached geometries must not be modified
+ */
+class DLX Cache
+{
+  static Geometry::Ptr find(const std::string &key);
+
+  //@return geometry or, if another thread was faster, the geometry it inserted
+  static Geometry::Ptr insert(const std::string &key, const Geometry::Ptr &geometry);
+
+  static void append(std::string &) {}
+
+  template <typename T, typename ... Args>
+  static void append(std::string &params, const T &value, const Args &... args)
+  {
+    appendValue(params, value);
+    append(params, args...);
+  }
+
+  //numbers and enums are keyed by kind and value bytes, so integer and float arguments never collide
+  template <typename T>
+  static typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type
+  appendValue(std::string &params, const T &value)
+  {
+    params.push_back(std::is_floating_point<T>::value ? 'f' : 'i');
+    params.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  struct Fields
+  {
+    std::string &params;
+
+    template <typename T>
+    void operator()(const T &value) const {appendValue(params, value);}
+  };
+
+  //parameter structs are keyed field by field, never by their padding, through their visit() method
+  template <typename T>
+  static typename std::enable_if<std::is_class<T>::value>::type
+  appendValue(std::string &params, const T &value)
+  {
+    value.visit(Fields {params});
+  }
+
+public:
+  /**
+   * @return the geometry created by G::make(args...), shared with all previous callers using the same
+   * arguments as long as any of them still holds it
+   */
+  template <typename G, typename ... Args>
+  static std::shared_ptr<G> get(const Args &... args)
+  {
+    //type name and parameter values
+    std::string key(typeid(G).name());
+    key.push_back('\0');
+    append(key, args...);
+
+    Geometry::Ptr geometry = find(key);
+    if(!geometry) geometry = insert(key, G::make(args...));
+
+    return std::static_pointer_cast<G>(geometry);
+  }
+
+  /**
+   * @return the number of geometries currently shared through the cache
+   */
+  static size_t size();
+
+  /**
+   * forget all entries. Geometries in use stay valid, but are no longer shared with new callers
+   */
+  static void clear();
+};
+
+}
+}
+
+#endif //THREEPP_GEOM_CACHE_H
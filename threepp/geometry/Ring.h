@@ -24,6 +24,12 @@ struct RingParams
     thetaSegments = std::max(3u, thetaSegments);
     phiSegments = std::max(1u, phiSegments);
   }
+
+  //call f with each field (see geometry::Cache)
+  template <typename F>
+  void visit(F f) const {
+    f(innerRadius); f(outerRadius); f(thetaSegments); f(phiSegments); f(thetaStart); f(thetaLength);
+  }
 };
 
 class DLX Ring : public LinearGeometry, public RingParams
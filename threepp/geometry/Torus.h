@@ -18,6 +18,12 @@ struct TorusParams
   unsigned radialSegments = 8;
   unsigned tubularSegments = 6;
   float arc = (float)M_PI * 2;
+
+  //call f with each field (see geometry::Cache)
+  template <typename F>
+  void visit(F f) const {
+    f(radius); f(tube); f(radialSegments); f(tubularSegments); f(arc);
+  }
 };
 
 class DLX Torus : public LinearGeometry, public TorusParams
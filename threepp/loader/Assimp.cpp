@@ -11,6 +11,9 @@
 #include <assimp/scene.h>
 
 #include <threepp/core/BufferGeometry.h>
+#include <threepp/core/Simplifier.h>
+#include <threepp/core/IndexOptimizer.h>
+#include <threepp/objects/LOD.h>
 #include <threepp/material/MeshLambertMaterial.h>
 #include <threepp/material/MeshToonMaterial.h>
 #include <threepp/material/MeshPhysicalMaterial.h>
@@ -188,25 +191,37 @@ struct Access
   const aiScene * aiscene;
   ResourceLoader &loader;
   enum_map<ShadingModel, ShadingModel> &modelMap;
+  const AssimpOptions &options;
 
   unordered_map<string, QImage> images;
   unordered_map<unsigned, Mesh::Ptr> meshes;
+  unordered_map<unsigned, BufferGeometry::Ptr> geometries;
   unordered_map<unsigned, MeshMaker::Ptr> makers;
 
+  //simplified geometries per mesh, one per lodRatios entry. nullptr where no reduction was possible
+  unordered_map<unsigned, vector<BufferGeometry::Ptr>> lodGeometries;
+
   const AssimpMaterialHandler *materialHandler = nullptr;
 
   Access(Scene::Ptr scene, const aiScene * aiscene,
          ResourceLoader &loader,
-         enum_map<ShadingModel, ShadingModel> &modelMap,
+         AssimpOptions &options,
          const AssimpMaterialHandler *materialHandler)
-     : scene(scene), aiscene(aiscene), loader(loader), modelMap(modelMap), materialHandler(materialHandler) {}
+     : scene(scene), aiscene(aiscene), loader(loader), modelMap(options.modelMap), options(options),
+       materialHandler(materialHandler) {}
 
   void readMaterial(unsigned materialIndex);
 
   BufferAttributeT<float>::Ptr readUVChannel(unsigned index, const aiMesh *mesh);
 
+  BufferGeometry::Ptr readGeometry(int index);
+
   Mesh::Ptr readMesh(int index);
 
+  void simplifyMeshes();
+
+  Object3D::Ptr readLOD(int index);
+
   void readObject(const aiNode *ai, Object3D::Ptr object);
 
   void readScene()
@@ -215,6 +230,8 @@ struct Access
       readMaterial(i);
     }
 
+    if(!options.lodRatios.empty()) simplifyMeshes();
+
     readObject(aiscene->mRootNode, scene);
 
     for(int i=0; i<aiscene->mNumMeshes; i++) {
@@ -602,8 +619,10 @@ void Access::readObject(const aiNode *ai, Object3D::Ptr object)
      m.a1, m.a2, m.a3, m.a4, m.b1, m.b2, m.b3, m.b4, m.c1, m.c2, m.c3, m.c4, m.d1, m.d2, m.d3, m.d4);
 
   for(unsigned i=0; i<ai->mNumMeshes; i++) {
-    Mesh::Ptr mesh = readMesh(ai->mMeshes[i]);
-    object->add(mesh);
+    if(lodGeometries.count(ai->mMeshes[i]) > 0)
+      object->add(readLOD(ai->mMeshes[i]));
+    else
+      object->add(readMesh(ai->mMeshes[i]));
   }
 
   for(unsigned i=0; i<ai->mNumChildren; i++) {
@@ -615,6 +634,56 @@ void Access::readObject(const aiNode *ai, Object3D::Ptr object)
   object->_matrix.decompose(object->_position, object->_quaternion, object->_scale);
 }
 
+void Access::simplifyMeshes()
+{
+  vector<BufferGeometry::Ptr> sources;
+  for(unsigned i=0; i<aiscene->mNumMeshes; i++) {
+    sources.push_back(readGeometry(i));
+  }
+
+  //each level is simplified from the full geometry, so errors don't accumulate
+  for(float ratio : options.lodRatios) {
+    Simplifier::Options simplify;
+    simplify.ratio = ratio;
+    simplify.maxError = options.lodMaxError;
+
+    vector<BufferGeometry::Ptr> simplified = Simplifier::simplify(sources, simplify);
+
+    for(unsigned i=0; i<simplified.size(); i++) {
+      //vertices are shared with the source geometry, so only the index is reordered
+      if(simplified[i] && options.optimizeIndices) IndexOptimizer::optimize(*simplified[i], false);
+
+      if(simplified[i] || lodGeometries.count(i) > 0) lodGeometries[i].push_back(simplified[i]);
+    }
+  }
+}
+
+Object3D::Ptr Access::readLOD(int index)
+{
+  Mesh::Ptr mesh = readMesh(index);
+  const vector<BufferGeometry::Ptr> &levels = lodGeometries[index];
+
+  LOD::Ptr lod = LOD::make(LOD::Metric::ScreenSize);
+  lod->_name = mesh->_name;
+  lod->addLevel(mesh, numeric_limits<float>::infinity());
+
+  //levels were only recorded from the first successful reduction on
+  size_t first = options.lodRatios.size() - levels.size();
+
+  for(size_t i=0; i<levels.size(); i++) {
+    if(!levels[i]) continue;
+
+    size_t r = first + i;
+    float threshold = r < options.lodThresholds.size() ? options.lodThresholds[r] : options.lodRatios[r] * 0.5f;
+
+    Mesh::Ptr level = DynamicMesh::make(levels[i], mesh->material());
+    level->_name = mesh->_name;
+    lod->addLevel(level, threshold);
+  }
+
+  return lod;
+}
+
 BufferAttributeT<float>::Ptr Access::readUVChannel(unsigned index, const aiMesh *ai)
 {
   if(ai->mTextureCoords[index]) {
@@ -639,7 +708,7 @@ Mesh::Ptr Access::readMesh(int index)
   aiMesh *ai = aiscene->mMeshes[index];
   Mesh::Ptr mesh;
 
-  BufferGeometry::Ptr geometry = BufferGeometry::make();
+  BufferGeometry::Ptr geometry = readGeometry(index);
   if(makers.count(ai->mMaterialIndex)) {
     mesh = makers[ai->mMaterialIndex]->makeMesh(geometry);
   }
@@ -651,6 +720,17 @@ Mesh::Ptr Access::readMesh(int index)
   if(mesh->_name.empty())
     mesh->_name = ai->mName.C_Str();
 
+  //mesh.matrixAutoUpdate = false;
+  return mesh;
+}
+
+BufferGeometry::Ptr Access::readGeometry(int index)
+{
+  if(geometries.count(index) > 0) return geometries[index];
+
+  aiMesh *ai = aiscene->mMeshes[index];
+  BufferGeometry::Ptr geometry = BufferGeometry::make();
+
   auto indices = attribute::growing<uint32_t>(true);
 
   for(unsigned i=0; i<ai->mNumFaces; i++) {
@@ -763,8 +843,13 @@ Mesh::Ptr Access::readMesh(int index)
 
     this.threeNode = mesh;
 #endif
-  //mesh.matrixAutoUpdate = false;
-  return mesh;
+  if(options.weldVertices) VertexWelder::weld(*geometry, options.welding);
+  if(options.optimizeIndices) IndexOptimizer::optimize(*geometry);
+  if(options.packVertices) VertexPacking::apply(*geometry, options.packing);
+  if(options.interleaveVertices) geometry->interleave();
+
+  geometries[index] = geometry;
+  return geometry;
 }
 
 void Access::readMaterial(unsigned materialIndex)
@@ -893,7 +978,7 @@ void Assimp::loadScene(string name, ResourceLoader &loader)
     return;
   }
 
-  Access access(_scene, aiscene, loader, modelMap, _materialHandler);
+  Access access(_scene, aiscene, loader, *this, _materialHandler);
   access.readScene();
 }
 
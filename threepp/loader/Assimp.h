@@ -10,6 +10,8 @@
 #include <string>
 #include <unordered_map>
 
+#include <threepp/core/VertexPacking.h>
+#include <threepp/core/VertexWelder.h>
 #include <threepp/material/Material.h>
 #include <threepp/objects/Mesh.h>
 #include <threepp/scene/Scene.h>
@@ -30,6 +32,31 @@ struct AssimpOptions
 {
   enum_map<ShadingModel, ShadingModel> modelMap;
 
+  //merge vertices that are equal within tolerance, beyond the exact matches joined by Assimp
+  //(see VertexWelder)
+  bool weldVertices = false;
+  VertexWelder::Options welding;
+
+  //reorder index and vertex buffers for vertex cache, overdraw and fetch efficiency
+  bool optimizeIndices = true;
+
+  //render from compact vertex formats (see VertexPacking)
+  bool packVertices = false;
+  VertexPacking::Options packing;
+
+  //render position, normal, uv and color from one interleaved buffer (see BufferGeometry::interleave)
+  bool interleaveVertices = false;
+
+  //triangle ratios of generated detail levels, finest first. If empty, no levels are generated
+  std::vector<float> lodRatios;
+
+  //screen size thresholds of the generated levels (see LOD::Metric::ScreenSize). Missing entries
+  //default to half the level's ratio
+  std::vector<float> lodThresholds;
+
+  //maximum simplification error, relative to the mesh extent
+  float lodMaxError = 0.02f;
+
   AssimpOptions() {
     modelMap[ShadingModel::Phong] = ShadingModel::Phong;
     modelMap[ShadingModel::Gouraud] = ShadingModel::Phong;
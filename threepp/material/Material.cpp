@@ -15,10 +15,10 @@
 
 namespace three {
 
-uint16_t Material::___material_id_count = 0;
+std::atomic<uint64_t> Material::___material_id_count(0);
 
 Material::Material(const Material &material, const material::Info &info, const material::Typer &typer)
-   : uuid(sole::uuid4()), id(___material_id_count++), info(info), typer(typer)
+   : id(++___material_id_count), info(info), typer(typer)
 {
   fog = material.fog;
   lights = material.lights;
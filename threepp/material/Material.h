@@ -6,10 +6,11 @@
 #define THREEPP_MATERIAL_H
 
 #include <memory>
+#include <atomic>
 #include <threepp/util/osdecl.h>
 #include <threepp/Constants.h>
 #include <threepp/textures/Texture.h>
-#include <threepp/util/sole.h>
+#include <threepp/util/ResourceId.h>
 #include <threepp/util/simplesignal.h>
 #include <threepp/math/Plane.h>
 #include <threepp/util/Resolver.h>
@@ -120,10 +121,12 @@ struct MetalnessMap
 
 struct DLX Material
 {
-  static uint16_t ___material_id_count;
+  static std::atomic<uint64_t> ___material_id_count;
 
-  const sole::uuid uuid;
-  uint16_t id;
+  const ResourceId resourceId;
+
+  //1-based, never reused
+  uint64_t id;
 
   std::string name;
 
@@ -190,7 +193,7 @@ struct DLX Material
 
 protected:
   Material(const material::Info &info, const material::Typer &typer)
-     : uuid(sole::uuid4()), id(___material_id_count++), info(info), typer(typer) {}
+     : id(++___material_id_count), info(info), typer(typer) {}
 
   Material(const Material &material, const material::Info &info, const material::Typer &typer);
 
@@ -0,0 +1,118 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "LOD.h"
+#include <threepp/camera/Camera.h>
+#include <threepp/math/Box3.h>
+
+namespace three {
+
+using namespace std;
+
+LOD::LOD(const LOD &lod) : Object3D(lod), _metric(lod._metric), _hysteresis(lod._hysteresis), autoUpdate(lod.autoUpdate)
+{
+  Object3D::typer = object::Typer(this);
+
+  //children were cloned in order, map the levels onto the clones
+  if(_children.size() == lod._children.size()) {
+    for(const Level &level : lod._levels) {
+      auto found = find(lod._children.begin(), lod._children.end(), level.object);
+      if(found != lod._children.end())
+        _levels.push_back(Level {_children[found - lod._children.begin()], level.threshold});
+    }
+  }
+}
+
+LOD &LOD::addLevel(const Object3D::Ptr &object, float threshold)
+{
+  if(object->parent() != this) add(object);
+
+  //finest first
+  auto pos = find_if(_levels.begin(), _levels.end(), [this, threshold](const Level &level) {
+    return _metric == Metric::Distance ? level.threshold > threshold : level.threshold < threshold;
+  });
+  _levels.insert(pos, Level {object, threshold});
+
+  _sphereValid = false;
+  return *this;
+}
+
+void LOD::clearLevels()
+{
+  for(const Level &level : _levels) {
+    //update() hid all but the current level
+    level.object->visible() = true;
+    remove(level.object);
+  }
+  _levels.clear();
+  _current = 0;
+  _sphereValid = false;
+}
+
+void LOD::computeSphere()
+{
+  math::Box3 box;
+
+  function<void(Object3D &, const math::Matrix4 &)> expand = [&](Object3D &object, const math::Matrix4 &matrix)
+  {
+    const Geometry::Ptr geometry = object.geometry();
+    if(geometry) {
+      if(geometry->boundingSphere().isEmpty()) geometry->computeBoundingSphere();
+
+      math::Sphere sphere = geometry->boundingSphere();
+      sphere.apply(matrix);
+
+      math::Vector3 extent(sphere.radius());
+      box.expandByPoint(sphere.center() - extent);
+      box.expandByPoint(sphere.center() + extent);
+    }
+    for(const auto &child : object.children()) expand(*child, matrix * child->matrix());
+  };
+
+  if(!_levels.empty()) expand(*_levels.front().object, _levels.front().object->matrix());
+
+  _sphere = box.isEmpty() ? math::Sphere() : box.getBoundingSphere();
+  _sphereValid = true;
+}
+
+size_t LOD::update(const Camera &camera)
+{
+  if(_levels.empty()) return 0;
+
+  if(!_sphereValid) computeSphere();
+
+  math::Sphere sphere = _sphere;
+  sphere.apply(_matrixWorld);
+
+  float value;
+  if(_metric == Metric::Distance) {
+    value = camera.matrixWorld().getPosition().distanceTo(sphere.center());
+  }
+  else {
+    //clip w of the center, and the projection's vertical scale
+    const float *p = camera.projectionMatrix().elements();
+    math::Vector3 view = sphere.center();
+    view.apply(camera.matrixWorldInverse());
+
+    float w = p[11] * view.z() + p[15];
+    value = w > 0 ? sphere.radius() * p[5] / w : numeric_limits<float>::infinity();
+  }
+
+  //true if value lies beyond the threshold of level index, moved outwards by margin
+  auto beyond = [&](size_t index, float margin) {
+    return _metric == Metric::Distance ? value >= _levels[index].threshold * (1 + margin)
+                                       : value <= _levels[index].threshold * (1 - margin);
+  };
+
+  size_t level = min(_current, _levels.size() - 1);
+  while(level + 1 < _levels.size() && beyond(level + 1, _hysteresis)) level++;
+  while(level > 0 && !beyond(level, -_hysteresis)) level--;
+
+  _current = level;
+  for(size_t i = 0; i < _levels.size(); i++) _levels[i].object->visible() = i == level;
+
+  return level;
+}
+
+}
@@ -0,0 +1,121 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_LOD_H
+#define THREEPP_LOD_H
+
+#include <threepp/core/Object3D.h>
+#include <threepp/math/Sphere.h>
+
+namespace three {
+
+/**
+ * level of detail. Holds alternative representations of the same content as children, ordered from
+ * finest to coarsest, and shows only one of them. The level is chosen by the renderer for every frame,
+ * based on camera distance or on projected screen size. A hysteresis band around each threshold keeps
+ * the level from flickering when the camera rests near a switching point
+ */
+class DLX LOD : public Object3D
+{
+public:
+  enum class Metric
+  {
+    //thresholds are camera distances, a level is used beyond its threshold
+    Distance,
+
+    //thresholds are projected bounding sphere radii relative to the viewport height, a level is used
+    //below its threshold
+    ScreenSize
+  };
+
+  struct Level
+  {
+    Object3D::Ptr object;
+    float threshold;
+  };
+
+private:
+  Metric _metric;
+  float _hysteresis = 0.1f;
+
+  std::vector<Level> _levels;
+  size_t _current = 0;
+
+  //bounds of the finest level in local coordinates, computed on demand
+  math::Sphere _sphere;
+  bool _sphereValid = false;
+
+  void computeSphere();
+
+protected:
+  explicit LOD(Metric metric) : Object3D(), _metric(metric)
+  {
+    Object3D::typer = object::Typer(this);
+  }
+
+  LOD(const LOD &lod);
+
+public:
+  using Ptr = std::shared_ptr<LOD>;
+  static Ptr make(Metric metric=Metric::Distance) {
+    return Ptr(new LOD(metric));
+  }
+
+  //select the level during rendering
+  bool autoUpdate = true;
+
+  /**
+   * add a level. The object becomes a child of this LOD unless it already is one. Levels are kept
+   * ordered from finest to coarsest according to the metric
+   */
+  LOD &addLevel(const Object3D::Ptr &object, float threshold);
+
+  /**
+   * remove all levels and the corresponding children. The removed objects are made visible again
+   */
+  void clearLevels();
+
+  /**
+   * @param hysteresis the relative band around each threshold within which the current level is kept
+   */
+  LOD &setHysteresis(float hysteresis)
+  {
+    _hysteresis = hysteresis;
+    return *this;
+  }
+
+  LOD &setMetric(Metric metric)
+  {
+    _metric = metric;
+    return *this;
+  }
+
+  Metric metric() const {return _metric;}
+
+  float hysteresis() const {return _hysteresis;}
+
+  const std::vector<Level> &levels() const {return _levels;}
+
+  size_t currentLevel() const {return _current;}
+
+  /**
+   * must be called if the finest level's geometry changes, so the bounds are recomputed
+   */
+  void invalidate() {_sphereValid = false;}
+
+  /**
+   * choose the level for the given camera and make only that level visible. Matrices must be up to date
+   *
+   * @return the selected level
+   */
+  size_t update(const Camera &camera);
+
+  LOD *cloned() const override {
+    return new LOD(*this);
+  }
+};
+
+}
+
+#endif //THREEPP_LOD_H
@@ -33,12 +33,14 @@ void Mesh::raycast(const Raycaster &raycaster, IntersectList &intersects)
   std::vector<math::Ray> rays(raycaster.rays());
 
   bool bbox = !geometry()->boundingBox().isEmpty();
+  hit = !bbox;
   for(auto &ray : rays) {
     ray.apply(inverseMatrix);
 
-    // Check boundingBox before continuing
-    if(bbox && !ray.intersectsBox(geometry()->boundingBox())) return;
+    // Check boundingBox before continuing. For ray bundles, one ray hitting is enough
+    if(bbox && ray.intersectsBox(geometry()->boundingBox())) hit = true;
   }
+  if(!hit) return;
 
   geometry()->raycast(*this, raycaster, rays, intersects);
 }
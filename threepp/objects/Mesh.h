@@ -58,6 +58,14 @@ public:
 
   float morphTargetInfluence(unsigned index) const {return _morphTargetInfluences.at(index);}
 
+  void setMorphTargetInfluences(const std::vector<float> &influences) {_morphTargetInfluences = influences;}
+
+  void setMorphTargetInfluence(unsigned index, float influence)
+  {
+    if(index >= _morphTargetInfluences.size()) _morphTargetInfluences.resize(index + 1, 0.0f);
+    _morphTargetInfluences[index] = influence;
+  }
+
   void raycast(const Raycaster &raycaster, IntersectList &intersects) override;
 
   Mesh *cloned() const override {
@@ -0,0 +1,168 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "Skeleton.h"
+#include <cstring>
+#include <threepp/math/Math.h>
+#include <threepp/util/Parallel.h>
+
+namespace three {
+
+using namespace std;
+
+namespace {
+
+//bones per work item. Smaller batches are processed on the calling thread
+const size_t boneGrain = 256;
+
+/**
+ * column-major 4x4 product. Each output column is a 4-wide multiply-add of the columns of a, so
+ * that the compiler can keep columns in vector registers
+ */
+inline void multiply(const float *a, const float *b, float *out)
+{
+  for(unsigned c = 0; c < 4; c++) {
+    const float *bc = b + c * 4;
+    float *oc = out + c * 4;
+
+    for(unsigned r = 0; r < 4; r++) {
+      oc[r] = a[r] * bc[0] + a[4 + r] * bc[1] + a[8 + r] * bc[2] + a[12 + r] * bc[3];
+    }
+  }
+}
+
+}
+
+bool Skeleton::computeMatrices(size_t begin, size_t end, char *changed)
+{
+  bool any = false;
+  float offset[16];
+
+  for(size_t i = begin; i < end; i++) {
+    float *entry = _palette->_values.data() + i * 16;
+
+    // compute the offset between the current and the original transform
+    if(_bones[i])
+      multiply(_bones[i]->matrixWorld().elements(), _boneInverses[i].elements(), offset);
+    else
+      memcpy(offset, _boneInverses[i].elements(), sizeof(offset));
+
+    changed[i] = memcmp(offset, entry, sizeof(offset)) != 0;
+    if(changed[i]) {
+      memcpy(entry, offset, sizeof(offset));
+      any = true;
+    }
+  }
+  return any;
+}
+
+void Skeleton::markDirty(size_t first, size_t last)
+{
+  if(!_boneTexture) return;
+
+  size_t firstRow = first * 4 / _boneTextureSize;
+  size_t lastRow = (last * 4 - 1) / _boneTextureSize;
+
+  _boneTexture->needsUpdate(firstRow, lastRow - firstRow + 1);
+}
+
+void Skeleton::createBoneTexture()
+{
+  if(_boneTexture) return;
+
+  float size = sqrt(_bones.size() * 4); // 4 pixels needed for 1 matrix
+  size = math::ceilPowerOfTwo(size);
+  size = max(size, 4.0f);
+
+  _palette->resize((size_t)size);
+  _boneTextureSize = (size_t)size;
+
+  TextureOptions options = DataTexture::options();
+  options.format = TextureFormat::RGBA;
+  options.type = TextureType::Float;
+  options.flipY = false;
+
+  _boneTexture = DataTexture::make(options, _palette, false);
+  _boneTexture->setGenerateMipmaps(false);
+}
+
+void Skeleton::pose()
+{
+  // recover the bind-time world matrices
+  size_t index = 0;
+  for(Bone::Ptr bone : _bones) {
+    if(bone) bone->matrixWorld() = _boneInverses[index].inverted();
+    index++;
+  }
+
+  // compute the local matrices, positions, rotations and scales
+  for(Bone::Ptr bone : _bones) {
+    if(!bone) continue;
+
+    const Bone *parent = bone->parent() ? dynamic_cast<const Bone *>(bone->parent()) : nullptr;
+    if (parent) {
+      bone->matrix() = parent->matrixWorld().inverted();
+      bone->matrix() *= bone->matrixWorld();
+    }
+    else {
+      bone->matrix() = bone->matrixWorld();
+    }
+    bone->matrix().decompose( bone->position(), bone->quaternion(), bone->scale());
+  }
+}
+
+void Skeleton::update()
+{
+  vector<char> changed(_bones.size());
+
+  if(!computeMatrices(0, _bones.size(), changed.data())) return;
+
+  auto first = find(changed.begin(), changed.end(), 1);
+  auto last = find(changed.rbegin(), changed.rend(), 1);
+
+  markDirty(first - changed.begin(), changed.rend() - last);
+}
+
+void Skeleton::update(const std::vector<Skeleton *> &skeletons)
+{
+  //bone offsets of the skeletons in the combined range
+  vector<size_t> offsets;
+  offsets.reserve(skeletons.size() + 1);
+
+  size_t total = 0;
+  for(Skeleton *skeleton : skeletons) {
+    offsets.push_back(total);
+    total += skeleton->_bones.size();
+  }
+  offsets.push_back(total);
+
+  vector<char> changed(total);
+
+  parallel::for_each(0, total, [&](size_t begin, size_t end) {
+
+    size_t s = upper_bound(offsets.begin(), offsets.end(), begin) - offsets.begin() - 1;
+
+    for(size_t b = begin; b < end; s++) {
+      size_t e = min(end, offsets[s + 1]);
+      if(e > b) {
+        skeletons[s]->computeMatrices(b - offsets[s], e - offsets[s], changed.data() + offsets[s]);
+      }
+      b = e;
+    }
+  }, boneGrain);
+
+  for(size_t s = 0; s < skeletons.size(); s++) {
+    auto begin = changed.begin() + offsets[s], end = changed.begin() + offsets[s + 1];
+
+    auto first = find(begin, end, 1);
+    if(first == end) continue;
+
+    size_t last = offsets[s + 1] - offsets[s];
+    while(last > 0 && !*(begin + last - 1)) last--;
+
+    skeletons[s]->markDirty(first - begin, last);
+  }
+}
+
+}
@@ -6,7 +6,7 @@
 #define THREEPP_SKELETON_H
 
 #include <threepp/core/Object3D.h>
-#include <threepp/textures/Texture.h>
+#include <threepp/textures/DataTexture.h>
 
 namespace three {
 
@@ -29,84 +29,109 @@ public:
   }
 };
 
-class Skeleton
+/**
+ * the bone palette, one column-major 4x4 matrix per bone. Shared between the skeleton and
+ * its bone texture. If a texture is used, the data is padded to the texture size
+ */
+class BonePalette : public TextureData
 {
-  std::vector<Bone::Ptr> _bones;
-  std::vector<float> _boneMatrices;
-  std::vector<math::Matrix4> _boneInverses;
-  Texture::Ptr _boneTexture;
-  size_t _boneTextureSize;
+  friend class Skeleton;
 
-  Skeleton() {}
+  std::vector<float> _values;
 
-  explicit Skeleton(const std::vector<Bone::Ptr> bones) : _bones(bones)
+  explicit BonePalette(size_t bones) : _values(bones * 16) {}
+
+  void resize(size_t textureSize)
   {
-    for(Bone::Ptr bone : _bones) {
-      _boneInverses.push_back(bone->matrixWorld().inverted());
-    }
-  }
-public:
-  using Ptr = std::shared_ptr<Skeleton>;
-  static Ptr make(const std::vector<Bone::Ptr> bones) {
-    return Ptr(new Skeleton(bones));
+    _width = _height = textureSize;
+    _values.resize(textureSize * textureSize * 4); // 4 floats per RGBA pixel
   }
 
-  const std::vector<Bone::Ptr> bones() const {return _bones;}
-  const std::vector<float> boneMatrices() const {return _boneMatrices;}
-  const std::vector<math::Matrix4> boneInverses() const {return _boneInverses;}
-  const Texture::Ptr boneTexture() const {return _boneTexture;}
-  const size_t boneTextureSize() const {return _boneTextureSize;}
-
-  std::vector<float> &boneMatrices() {return _boneMatrices;}
-
-  Skeleton &setBoneTexture(Texture::Ptr texture) {
-    _boneTexture = texture;
-    return *this;
+public:
+  const byte *bytes() const override {
+    return reinterpret_cast<const byte *>(_values.data());
   }
+};
 
-  Skeleton &setBoneTextureSize(size_t size) {
-    _boneTextureSize = size;
-    return *this;
-  }
+class DLX Skeleton
+{
+  std::vector<Bone::Ptr> _bones;
+  std::vector<math::Matrix4> _boneInverses;
+  std::shared_ptr<BonePalette> _palette;
+  DataTexture::Ptr _boneTexture;
+  size_t _boneTextureSize = 0;
 
-  void pose()
+  explicit Skeleton(const std::vector<Bone::Ptr> &bones)
+     : _bones(bones), _palette(new BonePalette(bones.size()))
   {
-    // recover the bind-time world matrices
-    size_t index = 0;
-    for(Bone::Ptr bone : _bones) {
-      bone->matrixWorld() = _boneInverses[index++].inverted();
-    }
-
-    // compute the local matrices, positions, rotations and scales
     for(Bone::Ptr bone : _bones) {
-      const Bone *parent = bone->parent() ? dynamic_cast<const Bone *>(bone->parent()) : nullptr;
-      if (parent) {
-        bone->matrix() = parent->matrixWorld().inverted();
-        bone->matrix() *= bone->matrixWorld();
-      }
-      else {
-        bone->matrix() = bone->matrixWorld();
-      }
-      bone->matrix().decompose( bone->position(), bone->quaternion(), bone->scale());
+      _boneInverses.push_back(bone ? bone->matrixWorld().inverted() : math::Matrix4::identity());
     }
   }
 
-  void update()
+  Skeleton(const std::vector<Bone::Ptr> &bones, const std::vector<math::Matrix4> &boneInverses)
+     : _bones(bones), _boneInverses(boneInverses), _palette(new BonePalette(bones.size()))
   {
-    // flatten bone matrices to array
-    size_t index = 0;
-    for(Bone::Ptr bone : _bones) {
-      // compute the offset between the current and the original transform
-      math::Matrix4 matrix = bone ? bone->matrixWorld() : math::Matrix4::identity();
+    if(_boneInverses.size() != _bones.size())
+      throw std::invalid_argument("Skeleton: number of bone inverses does not match number of bones");
+  }
 
-      math::Matrix4 offsetMatrix = matrix * _boneInverses[index];
-      offsetMatrix.writeTo(_boneMatrices.data(), index * 16);
-    }
+  /**
+   * compute the palette entries for bones [begin, end) and mark those which changed
+   *
+   * @return true if any entry changed
+   */
+  bool computeMatrices(size_t begin, size_t end, char *changed);
 
-    if (_boneTexture) {
-      _boneTexture->needsUpdate();
-    }
+  /**
+   * propagate changed palette entries to the bone texture
+   */
+  void markDirty(size_t first, size_t last);
+
+public:
+  using Ptr = std::shared_ptr<Skeleton>;
+
+  /**
+   * create a skeleton. The inverse bind matrices are computed from the current world matrices of the bones
+   */
+  static Ptr make(const std::vector<Bone::Ptr> &bones) {
+    return Ptr(new Skeleton(bones));
+  }
+
+  static Ptr make(const std::vector<Bone::Ptr> &bones, const std::vector<math::Matrix4> &boneInverses) {
+    return Ptr(new Skeleton(bones, boneInverses));
   }
+
+  const std::vector<Bone::Ptr> &bones() const {return _bones;}
+  const std::vector<float> &boneMatrices() const {return _palette->_values;}
+  const std::vector<math::Matrix4> &boneInverses() const {return _boneInverses;}
+  const DataTexture::Ptr &boneTexture() const {return _boneTexture;}
+  size_t boneTextureSize() const {return _boneTextureSize;}
+
+  /**
+   * create the float texture holding the bone palette, if not already done.
+   * Layout (1 matrix = 4 pixels): RGBA RGBA RGBA RGBA (=> column1, column2, column3, column4)
+   *
+   *   8x8  pixel texture max   16 bones
+   *  16x16 pixel texture max   64 bones
+   *  32x32 pixel texture max  256 bones
+   *  64x64 pixel texture max 1024 bones
+   */
+  void createBoneTexture();
+
+  void pose();
+
+  /**
+   * recompute the bone palette from the bones' world matrices. Only the rows of the bone texture
+   * that hold changed matrices are uploaded
+   */
+  void update();
+
+  /**
+   * update a batch of skeletons. The bones of all skeletons are processed as one range that is
+   * split across worker threads
+   */
+  static void update(const std::vector<Skeleton *> &skeletons);
 };
 
 }
@@ -0,0 +1,146 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "SkinnedMesh.h"
+#include <cstring>
+#include <algorithm>
+#include <threepp/util/Parallel.h>
+
+namespace three {
+
+namespace {
+
+//vertices per work item
+const size_t vertexGrain = 2048;
+
+}
+
+BufferGeometry::Ptr SkinnedMesh::skinnedGeometry()
+{
+  BufferGeometry *geometry = _geometry->typer;
+  if(!geometry || !geometry->position() || !geometry->skinIndices() || !geometry->skinWeights()) {
+    releaseSkinnedGeometry();
+    return nullptr;
+  }
+
+  //rebuilt when the mesh's geometry, its index or its vertex count changed
+  if(_skinned && _skinnedSource == _geometry && _skinned->index() == geometry->index()
+     && _skinned->position()->size() == geometry->position()->size())
+    return _skinned;
+
+  releaseSkinnedGeometry();
+
+  _skinned = BufferGeometry::make();
+  *_skinned = *geometry;
+
+  //the packed and interleaved copies hold the bind pose
+  _skinned->setPacked(nullptr);
+  _skinned->setInterleaved(nullptr);
+  for(const Group &group : geometry->groups()) _skinned->addGroup(group.start, group.count, group.materialIndex);
+  if(geometry->tangents()) _skinned->setTangents(geometry->tangents());
+  if(geometry->bitangents()) _skinned->setBitangents(geometry->bitangents());
+
+  const BufferAttributeT<float>::Ptr &position = geometry->position();
+  _skinned->setPosition(BufferAttributeT<float>::Ptr(position->clone()));
+  _skinned->position()->dynamic = true;
+
+  const BufferAttributeT<float>::Ptr &normal = geometry->normal();
+  if(normal && normal->size() == position->size()) {
+    _skinned->setNormal(BufferAttributeT<float>::Ptr(normal->clone()));
+    _skinned->normal()->dynamic = true;
+  }
+  else _skinned->setNormal(nullptr);
+
+  _skinnedSource = _geometry;
+  _sourceConnection = _skinnedSource->onDispose.connect(*this, &SkinnedMesh::onSourceDispose);
+
+  return _skinned;
+}
+
+void SkinnedMesh::releaseSkinnedGeometry()
+{
+  if(_skinnedSource) {
+    _skinnedSource->onDispose.disconnect(_sourceConnection);
+    _skinnedSource = nullptr;
+    _sourceConnection = nullptr;
+  }
+  if(_skinned) {
+    //releases the GPU buffers
+    _skinned->dispose();
+    _skinned = nullptr;
+  }
+}
+
+void SkinnedMesh::applySkinning()
+{
+  BufferGeometry::Ptr skinned = skinnedGeometry();
+  if(!_skeleton || !skinned) return;
+
+  BufferGeometry *geometry = _skinnedSource->typer;
+
+  // bindMatrixInverse * bone * bindMatrix per bone. Blending these is equivalent to what the
+  // vertex shader does, but saves the per-vertex matrix products
+  const std::vector<float> &boneMatrices = _skeleton->boneMatrices();
+  size_t numBones = _skeleton->bones().size();
+
+  _skinMatrices.resize(numBones * 16);
+  for(size_t i = 0; i < numBones; i++) {
+    math::Matrix4 matrix;
+    memcpy(matrix.elements(), boneMatrices.data() + i * 16, sizeof(float) * 16);
+    matrix *= _bindMatrix;
+    matrix.premultiply(_bindMatrixInverse);
+    memcpy(_skinMatrices.data() + i * 16, matrix.elements(), sizeof(float) * 16);
+  }
+
+  const float *skinMatrices = _skinMatrices.data();
+  const float *indices = geometry->skinIndices()->data_t();
+  const float *weights = geometry->skinWeights()->data_t();
+  const float *restPositions = geometry->position()->data_t();
+  const float *restNormals = skinned->normal() ? geometry->normal()->data_t() : nullptr;
+
+  float *positions = skinned->position()->data<float>();
+  float *normals = restNormals ? skinned->normal()->data<float>() : nullptr;
+
+  size_t count = std::min(geometry->position()->itemCount(), geometry->skinWeights()->itemCount());
+
+  parallel::for_each(0, count, [&](size_t begin, size_t end) {
+
+    float m[16];
+    for(size_t v = begin; v < end; v++) {
+
+      //blend the matrices of the 4 influencing bones
+      for(unsigned e = 0; e < 16; e++) m[e] = 0;
+
+      for(unsigned j = 0; j < 4; j++) {
+        float w = weights[v * 4 + j];
+        if(w == 0) continue;
+
+        size_t bone = (size_t)indices[v * 4 + j];
+        if(bone >= numBones) continue;
+
+        const float *b = skinMatrices + bone * 16;
+        for(unsigned e = 0; e < 16; e++) m[e] += b[e] * w;
+      }
+
+      const float *p = restPositions + v * 3;
+      float *out = positions + v * 3;
+      out[0] = m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12];
+      out[1] = m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13];
+      out[2] = m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14];
+
+      if(normals) {
+        const float *n = restNormals + v * 3;
+        float *nout = normals + v * 3;
+        nout[0] = m[0] * n[0] + m[4] * n[1] + m[8] * n[2];
+        nout[1] = m[1] * n[0] + m[5] * n[1] + m[9] * n[2];
+        nout[2] = m[2] * n[0] + m[6] * n[1] + m[10] * n[2];
+      }
+    }
+  }, vertexGrain);
+
+  skinned->position()->needsUpdate();
+  if(normals) skinned->normal()->needsUpdate();
+}
+
+}
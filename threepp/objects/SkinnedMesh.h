@@ -7,10 +7,11 @@
 
 #include "Mesh.h"
 #include "Skeleton.h"
+#include <threepp/core/BufferGeometry.h>
 
 namespace three {
 
-class SkinnedMesh : public Mesh
+class DLX SkinnedMesh : public Mesh
 {
   //BindMode bindMode = BindMode::attached;
   math::Matrix4 _bindMatrix;
@@ -18,6 +19,19 @@ class SkinnedMesh : public Mesh
 
   Skeleton::Ptr _skeleton;
 
+  //deformed copy of the geometry rendered while skinning on the CPU. Shares all attributes except
+  //position and normal with the source, which keeps the bind pose
+  BufferGeometry::Ptr _skinned;
+  Geometry::Ptr _skinnedSource;
+  Geometry::OnDispose::ConnectionId _sourceConnection = nullptr;
+
+  std::vector<float> _skinMatrices;
+
+  //set by the renderer while the skeleton doesn't fit into the uniform bone palette
+  bool _cpuFallback = false;
+
+  void onSourceDispose(Geometry *geometry) {releaseSkinnedGeometry();}
+
 protected:
   SkinnedMesh(const BufferGeometry::Ptr &geometry, const Material::Ptr &material)
      : Mesh(geometry, {material})
@@ -26,16 +40,77 @@ protected:
   }
 
 public:
+  ~SkinnedMesh() override
+  {
+    if(_skinnedSource) _skinnedSource->onDispose.disconnect(_sourceConnection);
+  }
+
   using Ptr = std::shared_ptr<SkinnedMesh>;
   static Ptr make(const BufferGeometry::Ptr &geometry, const Material::Ptr &material)
   {
     return Ptr(new SkinnedMesh(geometry, material));
   }
 
+  /**
+   * deform the vertices on the CPU instead of in the vertex shader. Used for targets without vertex
+   * texture fetch. Independent of this flag, the renderer skins on the CPU for as long as the skeleton
+   * has more bones than the uniform bone palette can hold
+   */
+  bool cpuSkinning = false;
+
+  bool cpuFallback() const {return _cpuFallback;}
+
+  void setCpuFallback(bool fallback) {_cpuFallback = fallback;}
+
+  /**
+   * @return true if the vertices are currently deformed on the CPU
+   */
+  bool skinsOnCPU() const {return cpuSkinning || _cpuFallback;}
+
   const Skeleton::Ptr skeleton() const {return _skeleton;}
 
   const math::Matrix4 &bindMatrix() const {return _bindMatrix;}
   const math::Matrix4 &bindMatrixInverse() const {return _bindMatrixInverse;}
+
+  /**
+   * attach a skeleton, using the mesh's current world matrix as bind matrix
+   */
+  void bind(const Skeleton::Ptr &skeleton)
+  {
+    updateMatrixWorld(true);
+    bind(skeleton, _matrixWorld);
+  }
+
+  void bind(const Skeleton::Ptr &skeleton, const math::Matrix4 &bindMatrix)
+  {
+    _skeleton = skeleton;
+    _bindMatrix = bindMatrix;
+    _bindMatrixInverse = bindMatrix.inverted();
+  }
+
+  void pose()
+  {
+    if(_skeleton) _skeleton->pose();
+  }
+
+  /**
+   * @return the geometry to render while skinning on the CPU, created on first use. It shares all
+   * attributes with the mesh's geometry except position and normal. nullptr if the geometry has no
+   * positions or skin attributes
+   */
+  BufferGeometry::Ptr skinnedGeometry();
+
+  /**
+   * deform the skinned geometry's positions and normals from the bind pose using the current bone
+   * palette. Vertices are processed concurrently
+   */
+  void applySkinning();
+
+  /**
+   * dispose the skinned geometry, once skinning moves to the GPU. Also done when the mesh's geometry
+   * is disposed
+   */
+  void releaseSkinnedGeometry();
 };
 
 };
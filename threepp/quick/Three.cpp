@@ -30,6 +30,7 @@ Q_DECLARE_METATYPE(three::math::Euler);
 #include "objects/Line.h"
 #include "objects/ModelRef.h"
 #include "objects/Node.h"
+#include "objects/LOD.h"
 #include "objects/Box.h"
 #include "objects/Plane.h"
 #include "objects/Sphere.h"
@@ -110,6 +111,7 @@ void init()
   qmlRegisterType<three::quick::ConvexHull>("three.quick", 1, 0, "ConvexHull");
   qmlRegisterType<three::quick::ModelRef>("three.quick", 1, 0, "ModelRef");
   qmlRegisterType<three::quick::Node>("three.quick", 1, 0, "Node");
+  qmlRegisterType<three::quick::LOD>("three.quick", 1, 0, "LOD");
   qmlRegisterType<three::quick::AmbientLight>("three.quick", 1, 0, "AmbientLight");
   qmlRegisterType<three::quick::SpotLight>("three.quick", 1, 0, "SpotLight");
   qmlRegisterType<three::quick::PointLight>("three.quick", 1, 0, "PointLight");
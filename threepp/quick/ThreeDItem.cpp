@@ -441,6 +441,10 @@ bool Interactor::mouseMoved(QMouseEvent *event) {
   return _enabled ? handleMouseMoved(event) : false;
 }
 
+bool Interactor::hoverMoved(QHoverEvent *event) {
+  return _enabled ? handleHoverMoved(event) : false;
+}
+
 bool Interactor::mouseWheel(QWheelEvent *event) {
   return _enabled ? handleMouseWheel(event) : false;
 }
@@ -471,6 +475,17 @@ void ThreeDItem::mouseMoveEvent(QMouseEvent *event)
   }
 }
 
+void ThreeDItem::hoverMoveEvent(QHoverEvent *event)
+{
+  event->ignore();
+  for (auto contrl : _interactors) {
+    if (contrl->hoverMoved(event)) {
+      update();
+      return;
+    }
+  }
+}
+
 void ThreeDItem::mousePressEvent(QMouseEvent *event)
 {
   event->ignore();
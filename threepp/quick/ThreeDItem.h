@@ -40,6 +40,9 @@ protected:
 
   virtual bool handleMouseMoved(QMouseEvent *event) {return false;}
 
+  //only called while the item accepts hover events
+  virtual bool handleHoverMoved(QHoverEvent *event) {return false;}
+
   virtual bool handleMouseWheel(QWheelEvent *event) {return false;}
 
   virtual bool handleTouchEvent(QTouchEvent *event) {return false;}
@@ -71,6 +74,12 @@ public:
    */
   bool mouseMoved(QMouseEvent *event);
 
+  /**
+   * @param event
+   * @return true if the item should be updated
+   */
+  bool hoverMoved(QHoverEvent *event);
+
   /**
    * @param event
    * @return true if the item should be updated
@@ -289,6 +298,8 @@ public:
 
   ShadowMap *shadowMap() {return &_shadowMap;}
 
+  const three::OpenGLRenderer::Ptr &renderer() const {return _renderer;}
+
   void lockWhile(std::function<void()>);
 
   Q_INVOKABLE void clear();
@@ -304,6 +315,8 @@ protected:
 
   void mouseMoveEvent(QMouseEvent *event) override;
 
+  void hoverMoveEvent(QHoverEvent *event) override;
+
   void mousePressEvent(QMouseEvent *event) override;
 
   void mouseReleaseEvent(QMouseEvent *event) override;
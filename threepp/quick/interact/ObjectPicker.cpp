@@ -76,7 +76,7 @@ void ObjectPicker::scaleTo(ThreeQObject *object)
   }
 }
 
-void ObjectPicker::findIntersects(float ex, float ey)
+void ObjectPicker::findIntersects(float ex, float ey, Object3D *picked)
 {
   float x = (ex / (float)_item->width()) * 2 - 1;
   float y = -(ey / (float)_item->height()) * 2 + 1;
@@ -87,6 +87,13 @@ void ObjectPicker::findIntersects(float ex, float ey)
   _intersects.clear();
   _currentIntersect.object.clear();
 
+  //hovering: the GPU already picked the object at this position, only that one needs to be raycast
+  if(picked) {
+    raycaster.intersectObject(*picked, _intersects, false);
+    if(!_intersects.empty()) _intersects.prepare();
+    return;
+  }
+
   for (const auto &obj : _objects) {
     Object3D::Ptr o3d;
 
@@ -101,12 +108,12 @@ void ObjectPicker::findIntersects(float ex, float ey)
     raycaster.intersectObject( *o3d, _intersects, true);
   }
   if(_scene && _intersects.empty()) {
-    //if scene was given, and no objects given or intersected, try scene's children
-    for (auto obj : _scene->scene()->children()) {
-      raycaster.intersectObject( *obj, _intersects, true );
-    }
+    //if scene was given, and no objects given or intersected, try scene's children. If only the
+    //closest hit per ray is requested, the scene index can stop early
+    if(_closestOnly) raycaster.setMode(RaycastMode::Closest);
+    raycaster.intersectObjects(_scene->scene()->children(), _sceneIndex, _intersects);
   }
-  if(!_intersects.empty()) _intersects.prepare();
+  else if(!_intersects.empty()) _intersects.prepare();
 }
 
 bool ObjectPicker::handleMousePressed(QMouseEvent *event)
@@ -177,6 +184,83 @@ bool ObjectPicker::handleMouseDoubleClicked(QMouseEvent *event)
   return false;
 }
 
+bool ObjectPicker::handleHoverMoved(QHoverEvent *event)
+{
+  if(!_hoverEnabled || !_camera || !_item || !_item->renderer()) return false;
+
+  //served by the next render, the result is fetched in resolvePick()
+  three::Scene::Ptr scene = _scene ? _scene->scene() : nullptr;
+  _item->renderer()->picking().request((unsigned)event->pos().x(), (unsigned)event->pos().y(), 0, scene);
+  _pickPending = true;
+  _item->update();
+
+  //other interactors still see the event
+  return false;
+}
+
+bool ObjectPicker::pickable(Object3D *object) const
+{
+  //picking from the scene accepts any object
+  if(_objects.empty()) return _scene != nullptr;
+
+  for(Object3D *o = object; o; o = o->parent()) {
+    for (const auto &obj : _objects) {
+      auto *to = obj.value<ThreeQObject *>();
+      if(to && to->object().get() == o) return true;
+
+      auto *po = obj.value<Pickable *>();
+      if(po && po->object().get() == o) return true;
+    }
+  }
+  return false;
+}
+
+void ObjectPicker::resolvePick()
+{
+  if(!_pickPending || !_item || !_item->renderer()) return;
+
+  OpenGLRenderer::Picking::Result result;
+  if(!_item->renderer()->picking().result(result)) {
+    //the readback is resolved during the next render
+    _item->update();
+    return;
+  }
+  _pickPending = false;
+
+  Object3D *hovered = result.object && pickable(result.object.get()) ? result.object.get() : nullptr;
+  if(hovered == _hovered) return;
+
+  _hovered = hovered;
+  if(_hovered && _camera) {
+    findIntersects(result.x, result.y, _hovered);
+    if(!_intersects.empty()) {
+      emit objectHovered();
+      return;
+    }
+    _hovered = nullptr;
+  }
+  emit hoverLeft();
+}
+
+void ObjectPicker::connectRendered(ThreeDItem *item, bool connect)
+{
+  auto change = [this, item, connect]() {
+    if(connect)
+      _renderedConnection = item->onRendered.connect([this](OpenGLRenderer::Ptr, Renderer::Target::Ptr) {
+        //called on the render thread
+        if(_pickPending) QMetaObject::invokeMethod(this, "resolvePick", Qt::QueuedConnection);
+      });
+    else if(_renderedConnection) {
+      item->onRendered.disconnect(_renderedConnection);
+      _renderedConnection = nullptr;
+    }
+  };
+
+  //the renderer is created with the item's component
+  if(item->renderer()) item->lockWhile(change);
+  else change();
+}
+
 QVariant ObjectPicker::intersect(unsigned index)
 {
   if(_intersects.empty() || _intersects.count(0) <= index)
@@ -252,6 +336,7 @@ ObjectPicker::ObjectPicker(QObject *parent)
 }
 
 ObjectPicker::~ObjectPicker() {
+  if(_item) connectRendered(_item, false);
   if(_accessObject) _accessObject->deleteLater();
   if(_rays) delete _rays;
 }
@@ -259,8 +344,15 @@ ObjectPicker::~ObjectPicker() {
 void ObjectPicker::setItem(ThreeDItem *item)
 {
   if(_item != item) {
+    if(_item) connectRendered(_item, false);
+
     _item = item;
     Interactor::setItem(item);
+
+    if(_item) {
+      connectRendered(_item, true);
+      if(_hoverEnabled) _item->setAcceptHoverEvents(true);
+    }
   }
 
   for(const auto &picker : _pickers) {
@@ -287,6 +379,26 @@ void ObjectPicker::setUnifyClicked(bool unify)
   }
 }
 
+void ObjectPicker::setClosestOnly(bool closestOnly)
+{
+  if(_closestOnly != closestOnly) {
+    _closestOnly = closestOnly;
+    emit closestOnlyChanged();
+  }
+}
+
+void ObjectPicker::setHoverEnabled(bool hoverEnabled)
+{
+  if(_hoverEnabled != hoverEnabled) {
+    _hoverEnabled = hoverEnabled;
+
+    //the item does not know about other hovering interactors, so hover events stay enabled
+    if(_hoverEnabled && _item) _item->setAcceptHoverEvents(true);
+
+    emit hoverEnabledChanged();
+  }
+}
+
 void ObjectPicker::setCamera(Camera *camera)
 {
   if(_camera != camera) {
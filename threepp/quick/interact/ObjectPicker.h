@@ -8,6 +8,8 @@
 #include <QObject>
 #include <QVariantList>
 #include <vector>
+#include <atomic>
+#include <threepp/core/SceneIndex.h>
 #include <threepp/quick/cameras/Camera.h>
 #include <threepp/quick/ThreeQObjectRoot.h>
 #include <threepp/quick/ThreeDItem.h>
@@ -115,7 +117,8 @@ signals:
 /**
  * a picker handles mouse events and determines, whether the mouse coordinates correspond to
  * one or more objects in the 3D space. It supports different ray configurations, ranging from
- * single ray to multi-ray
+ * single ray to multi-ray. With hover enabled, the object under the mouse is picked on the GPU
+ * (see OpenGLRenderer::Picking), and only that object is raycast
  */
 class ObjectPicker : public ThreeQObjectRoot, public Interactor
 {
@@ -127,6 +130,8 @@ Q_OBJECT
   Q_PROPERTY(ThreeQObject *prototype READ prototype WRITE setPrototype NOTIFY prototypeChanged)
   Q_PROPERTY(QQmlListProperty<three::quick::ObjectPicker> pickers READ pickers)
   Q_PROPERTY(bool unifyClicked READ unifyClicked WRITE setUnifyClicked NOTIFY unifyClickedChanged)
+  Q_PROPERTY(bool closestOnly READ closestOnly WRITE setClosestOnly NOTIFY closestOnlyChanged)
+  Q_PROPERTY(bool hoverEnabled READ hoverEnabled WRITE setHoverEnabled NOTIFY hoverEnabledChanged)
   Q_CLASSINFO("DefaultProperty", "pickers")
 
   ThreeDItem *_item = nullptr;
@@ -138,6 +143,21 @@ Q_OBJECT
 
   IntersectList _intersects;
 
+  //broad-phase index over the scene, used when picking from the scene's children
+  SceneIndex _sceneIndex;
+
+  //only report the closest hit per ray when picking from the scene's children
+  bool _closestOnly = false;
+
+  //GPU picking on hover. Presses always raycast the scene, since the pick may stem from an earlier
+  //frame with a different camera or scene
+  bool _hoverEnabled = false;
+  std::atomic<bool> _pickPending {false};
+  Object3D *_hovered = nullptr;
+
+  using OnRenderedId = decltype(ThreeDItem::onRendered)::ConnectionId;
+  OnRenderedId _renderedConnection = nullptr;
+
   QVariantList _objects;
 
   Intersect _currentIntersect;
@@ -157,6 +177,13 @@ Q_OBJECT
 
   QQmlListProperty<ObjectPicker> pickers();
 
+  bool pickable(Object3D *object) const;
+
+  void connectRendered(ThreeDItem *item, bool connect);
+
+private slots:
+  void resolvePick();
+
 public:
   explicit ObjectPicker(QObject *parent = nullptr);
 
@@ -178,6 +205,8 @@ public:
 
   bool handleMouseDoubleClicked(QMouseEvent *event) override;
 
+  bool handleHoverMoved(QHoverEvent *event) override;
+
   Q_INVOKABLE void scaleTo(ThreeQObject *object);
 
   Q_INVOKABLE QVariant intersect(unsigned index);
@@ -194,10 +223,23 @@ public:
 
   void setUnifyClicked(bool unify);
 
+  bool closestOnly() const {return _closestOnly;}
+
+  void setClosestOnly(bool closestOnly);
+
+  bool hoverEnabled() const {return _hoverEnabled;}
+
+  void setHoverEnabled(bool hoverEnabled);
+
 protected:
   QVariantList objects() {return _objects;}
 
-  void findIntersects(float x, float y);
+  /**
+   * raycast at the given item position
+   *
+   * @param picked if not null, only raycast this object, which was picked on the GPU at the position
+   */
+  void findIntersects(float x, float y, Object3D *picked=nullptr);
 
   void setObjects(const QVariantList &list);
 
@@ -240,9 +282,17 @@ signals:
   void enabledChanged();
   void raysChanged();
   void unifyClickedChanged();
+  void closestOnlyChanged();
+  void hoverEnabledChanged();
 
   void objectPicked();
   void objectDoublePicked();
+
+  //the mouse entered an object. intersect() and pickedParents() refer to the hovered object
+  void objectHovered();
+
+  //the mouse left the hovered object
+  void hoverLeft();
 };
 
 }
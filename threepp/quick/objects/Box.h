@@ -7,6 +7,7 @@
 
 #include <threepp/quick/scene/Scene.h>
 #include <threepp/geometry/Box.h>
+#include <threepp/geometry/Cache.h>
 #include <threepp/material/MeshBasicMaterial.h>
 #include <threepp/material/MeshLambertMaterial.h>
 #include <threepp/objects/Mesh.h>
@@ -24,13 +25,11 @@ class Box : public ThreeQObject
   float _width=0, _height=0, _depth=0;
 
   DynamicMesh::Ptr _mesh;
-  geometry::Box::Ptr _box;
 
 protected:
   three::Object3D::Ptr _create() override
   {
-    _box = geometry::Box::make(_width, _height, _depth);
-    _mesh = DynamicMesh::make(_box);
+    _mesh = DynamicMesh::make(geometry::Cache::get<geometry::Box>(_width, _height, _depth));
     _mesh->setMaterial(material()->getMaterial());
 
     return _mesh;
@@ -50,7 +49,6 @@ public:
   void setWidth(float width) {
     if(_width != width) {
       _width = width;
-      if(_mesh) _box->setWidth(width);
       emit widthChanged();
     }
   }
@@ -58,7 +56,6 @@ public:
   void setHeight(float height) {
     if(_height != height) {
       _height = height;
-      if(_mesh) _box->setHeight(height);
       emit heightChanged();
     }
   }
@@ -66,7 +63,6 @@ public:
   void setDepth(float depth) {
     if(_depth != depth) {
       _depth = depth;
-      if(_mesh) _box->setDepth(depth);
       emit depthChanged();
     }
   }
@@ -7,6 +7,7 @@
 
 #include <threepp/quick/scene/Scene.h>
 #include <threepp/geometry/Cylinder.h>
+#include <threepp/geometry/Cache.h>
 #include <threepp/material/MeshBasicMaterial.h>
 #include <threepp/material/MeshLambertMaterial.h>
 #include <threepp/objects/Mesh.h>
@@ -40,8 +41,8 @@ class Cylinder : public ThreeQObject
 protected:
   three::Object3D::Ptr _create() override
   {
-    _mesh = DynamicMesh::make(geometry::Cylinder::make(_radiusTop, _radiusBottom, _height, _heightSegments,
-                                                       _radialSegments, _openEnded, _thetaStart, _thetaLength));
+    _mesh = DynamicMesh::make(geometry::Cache::get<geometry::Cylinder>(_radiusTop, _radiusBottom, _height, _heightSegments,
+                                                                       _radialSegments, _openEnded, _thetaStart, _thetaLength));
     _mesh->setMaterial(material()->getMaterial());
 
     return _mesh;
@@ -0,0 +1,119 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPPQ_QUICK_LOD_H
+#define THREEPPQ_QUICK_LOD_H
+
+#include <QVariantList>
+#include <threepp/objects/LOD.h>
+#include <threepp/quick/scene/Scene.h>
+#include <threepp/quick/objects/ThreeQObject.h>
+
+namespace three {
+namespace quick {
+
+/**
+ * level of detail. The child objects are the levels, finest first. The thresholds list holds one
+ * threshold per child, interpreted according to the metric
+ */
+class LOD : public ThreeQObject
+{
+Q_OBJECT
+  Q_PROPERTY(Metric metric READ metric WRITE setMetric NOTIFY metricChanged)
+  Q_PROPERTY(QVariantList thresholds READ thresholds WRITE setThresholds NOTIFY thresholdsChanged)
+  Q_PROPERTY(float hysteresis READ hysteresis WRITE setHysteresis NOTIFY hysteresisChanged)
+  Q_PROPERTY(int currentLevel READ currentLevel)
+
+public:
+  enum Metric {Distance, ScreenSize};
+  Q_ENUM(Metric)
+
+private:
+  Metric _metric = Distance;
+  QVariantList _thresholds;
+  float _hysteresis = 0.1f;
+
+  three::LOD::Ptr _lod;
+
+  //the child objects in declaration order
+  std::vector<Object3D::Ptr> _levelObjects;
+
+  void updateLevels()
+  {
+    //children without a threshold stay plain, always visible children
+    _lod->clearLevels();
+    for(size_t i = 0; i < _levelObjects.size(); i++) {
+      if(i < (size_t)_thresholds.size())
+        _lod->addLevel(_levelObjects[i], _thresholds[i].toFloat());
+      else if(_levelObjects[i]->parent() != _lod.get())
+        _lod->add(_levelObjects[i]);
+    }
+  }
+
+protected:
+  three::Object3D::Ptr _create() override
+  {
+    _lod = three::LOD::make(_metric == ScreenSize ? three::LOD::Metric::ScreenSize : three::LOD::Metric::Distance);
+    _lod->setHysteresis(_hysteresis);
+
+    return _lod;
+  }
+
+  void _post_create() override
+  {
+    _levelObjects = _lod->children();
+    updateLevels();
+  }
+
+public:
+  LOD(QObject *parent=nullptr) : ThreeQObject(parent) {}
+
+  Metric metric() const {return _metric;}
+
+  const QVariantList &thresholds() const {return _thresholds;}
+
+  float hysteresis() const {return _hysteresis;}
+
+  int currentLevel() const {return _lod ? (int)_lod->currentLevel() : 0;}
+
+  void setMetric(Metric metric)
+  {
+    if(_metric != metric) {
+      _metric = metric;
+      if(_lod) {
+        _lod->setMetric(metric == ScreenSize ? three::LOD::Metric::ScreenSize : three::LOD::Metric::Distance);
+        updateLevels();
+      }
+      emit metricChanged();
+    }
+  }
+
+  void setThresholds(const QVariantList &thresholds)
+  {
+    if(_thresholds != thresholds) {
+      _thresholds = thresholds;
+      if(_lod) updateLevels();
+      emit thresholdsChanged();
+    }
+  }
+
+  void setHysteresis(float hysteresis)
+  {
+    if(_hysteresis != hysteresis) {
+      _hysteresis = hysteresis;
+      if(_lod) _lod->setHysteresis(hysteresis);
+      emit hysteresisChanged();
+    }
+  }
+
+signals:
+  void metricChanged();
+  void thresholdsChanged();
+  void hysteresisChanged();
+};
+
+}
+}
+
+#endif //THREEPPQ_QUICK_LOD_H
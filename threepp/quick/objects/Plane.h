@@ -7,6 +7,7 @@
 
 #include <threepp/quick/scene/Scene.h>
 #include <threepp/geometry/Plane.h>
+#include <threepp/geometry/Cache.h>
 #include <threepp/material/MeshBasicMaterial.h>
 #include <threepp/material/MeshLambertMaterial.h>
 #include <threepp/objects/Mesh.h>
@@ -32,11 +33,11 @@ protected:
   {
     switch(_geometryType) {
       case Three::LinearGeometry: {
-        _mesh = DynamicMesh::make(geometry::Plane::make(_width, _height, _widthSegments, _heightSegments));
+        _mesh = DynamicMesh::make(geometry::Cache::get<geometry::Plane>(_width, _height, _widthSegments, _heightSegments));
         break;
       }
       case Three::BufferGeometry: {
-        _mesh = DynamicMesh::make(geometry::buffer::Plane::make(_width, _height, _widthSegments, _heightSegments));
+        _mesh = DynamicMesh::make(geometry::Cache::get<geometry::buffer::Plane>(_width, _height, _widthSegments, _heightSegments));
         break;
       }
     }
@@ -7,6 +7,7 @@
 
 #include <threepp/quick/objects/ThreeQObject.h>
 #include <threepp/geometry/Ring.h>
+#include <threepp/geometry/Cache.h>
 #include <threepp/material/MeshBasicMaterial.h>
 #include <threepp/material/MeshLambertMaterial.h>
 #include <threepp/objects/Mesh.h>
@@ -31,7 +32,7 @@ Q_OBJECT
 protected:
   three::Object3D::Ptr _create() override
   {
-    _mesh = DynamicMesh::make(geometry::Ring::make(_params));
+    _mesh = DynamicMesh::make(geometry::Cache::get<geometry::Ring>(_params));
     _mesh->setMaterial(material()->getMaterial());
 
     return _mesh;
@@ -7,6 +7,7 @@
 
 #include <threepp/quick/scene/Scene.h>
 #include <threepp/geometry/Sphere.h>
+#include <threepp/geometry/Cache.h>
 #include <threepp/material/MeshBasicMaterial.h>
 #include <threepp/material/MeshLambertMaterial.h>
 #include <threepp/objects/Mesh.h>
@@ -31,11 +32,11 @@ protected:
   {
     switch(_geometryType) {
       case Three::LinearGeometry: {
-        _mesh = DynamicMesh::make(geometry::Sphere::make(_radius, _widthSegments, _heightSegments));
+        _mesh = DynamicMesh::make(geometry::Cache::get<geometry::Sphere>((float)_radius, _widthSegments, _heightSegments));
         break;
       }
       case Three::BufferGeometry: {
-        _mesh = DynamicMesh::make(geometry::buffer::Sphere::make(_radius, _widthSegments, _heightSegments));
+        _mesh = DynamicMesh::make(geometry::Cache::get<geometry::buffer::Sphere>((float)_radius, _widthSegments, _heightSegments));
         break;
       }
     }
@@ -7,6 +7,7 @@
 
 #include <threepp/quick/scene/Scene.h>
 #include <threepp/geometry/Torus.h>
+#include <threepp/geometry/Cache.h>
 #include <threepp/material/MeshBasicMaterial.h>
 #include <threepp/material/MeshLambertMaterial.h>
 #include <threepp/objects/Mesh.h>
@@ -30,7 +31,7 @@ Q_OBJECT
 protected:
   three::Object3D::Ptr _create() override
   {
-    _mesh = DynamicMesh::make(geometry::Torus::make(_params));
+    _mesh = DynamicMesh::make(geometry::Cache::get<geometry::Torus>(_params));
     _mesh->setMaterial(material()->getMaterial());
 
     return _mesh;
@@ -42,12 +42,84 @@ public:
 
   virtual Shadow &shadow() = 0;
 
+  /**
+   * GPU picking. Object ids are rendered into an offscreen buffer and read back asynchronously,
+   * so the cost does not depend on the triangle count of the scene. A request is served by the
+   * next render call, its result becomes available one render call later. Requests and results
+   * may be exchanged with threads other than the render thread
+   */
+  class DLX Picking {
+  public:
+    struct Result
+    {
+      //the picked object, null if nothing was hit
+      Object3D::Ptr object;
+
+      //the instance index for instanced geometries, 0 otherwise
+      unsigned instance = 0;
+
+      //the requested position
+      unsigned x = 0, y = 0;
+    };
+
+    /**
+     * request a pick. Replaces a previous request which was not yet served. Requests are served by the
+     * next render to the default framebuffer or an external target, never by render-to-texture passes
+     *
+     * @param x horizontal position in pixels, relative to the left of the viewport
+     * @param y vertical position in pixels, relative to the top of the viewport
+     * @param radius the object nearest to the position within this radius is picked
+     * @param scene if given, only a render of this scene serves the request
+     */
+    virtual void request(unsigned x, unsigned y, unsigned radius=0, const Scene::Ptr &scene=nullptr) = 0;
+
+    /**
+     * retrieve the result of the latest request
+     *
+     * @return false if no new result is available
+     */
+    virtual bool result(Result &result) = 0;
+  };
+
+  virtual Picking &picking() = 0;
+
+  /**
+   * GPU memory statistics
+   */
+  struct DLX MemoryInfo {
+    unsigned geometries = 0;
+    unsigned textures = 0;
+
+    //bytes held by vertex/index buffers and by textures
+    size_t bufferBytes = 0;
+    size_t textureBytes = 0;
+
+    //0 means unlimited
+    size_t budget = 0;
+
+    //number of resources released to stay within budget
+    unsigned evictions = 0;
+  };
+
+  virtual const MemoryInfo &memoryInfo() const = 0;
+
+  /**
+   * limit the GPU memory used by buffers and textures. If exceeded, least recently drawn resources are
+   * released and re-uploaded from their CPU copies on demand. Render targets are never evicted
+   *
+   * @param bytes the budget, 0 for unlimited
+   */
+  virtual void setMemoryBudget(size_t bytes) = 0;
+
   // clearing
   bool autoClear = true;
   bool autoClearColor = true;
   bool autoClearDepth = true;
   bool autoClearStencil = true;
 
+  // cull objects hidden behind large opaque meshes, using a CPU depth buffer
+  bool occlusionCulling = false;
+
   std::mutex mutex;
 
   using Ptr = std::shared_ptr<OpenGLRenderer>;
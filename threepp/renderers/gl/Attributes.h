@@ -5,10 +5,13 @@
 #ifndef THREEPP_ATTRIBUTES_H
 #define THREEPP_ATTRIBUTES_H
 
+#include <vector>
 #include <QOpenGLFunctions>
 #include <threepp/core/BufferAttribute.h>
+#include <threepp/core/InterleavedBufferAttribute.h>
 #include <threepp/Constants.h>
 #include "Helpers.h"
+#include "Residency.h"
 
 namespace three {
 namespace gl {
@@ -16,45 +19,127 @@ namespace gl {
 class Attributes
 {
   QOpenGLFunctions * const _fn;
-  std::unordered_map<sole::uuid, Buffer> _buffers;
+  Residency &_residency;
+  SlotTable<Buffer> _buffers;
 
-  void createBuffer(Buffer &buffer, const BufferAttribute &attribute, BufferType bufferType)
+  std::vector<uint16_t> _narrowed;
+
+  //interleaved attributes share the GL buffer of their InterleavedBuffer
+  static BufferAttribute &source(const BufferAttribute &attribute)
+  {
+    const InterleavedBufferAttribute *interleaved = dynamic_cast<const InterleavedBufferAttribute *>(&attribute);
+    return interleaved ? *interleaved->buffer() : const_cast<BufferAttribute &>(attribute);
+  }
+
+  /**
+   * 32 bit element indices are converted to 16 bit if all of them fit, which halves index memory
+   * and fetch bandwidth for all meshes with less than 65536 vertices. The CPU side index stays 32 bit
+   * for raycasting and the geometry tools. 8 bit indices are not used, since many drivers convert
+   * them on the CPU
+   *
+   * @return true if the range was converted into _narrowed
+   */
+  bool narrow(const BufferAttribute &attribute, BufferType bufferType, size_t start, size_t count)
+  {
+    if(bufferType != BufferType::ElementArray || attribute.glType() != GL_UNSIGNED_INT) return false;
+
+    const uint32_t *data = static_cast<const uint32_t *>(attribute.data(start));
+    _narrowed.resize(count);
+    for(size_t i = 0; i < count; i++) {
+      if(data[i] > 0xffff) return false;
+      _narrowed[i] = (uint16_t)data[i];
+    }
+    return true;
+  }
+
+  /**
+   * (re-)allocate the bound buffer with the attribute's data
+   *
+   * @return the number of bytes uploaded
+   */
+  size_t upload(Buffer &buffer, const BufferAttribute &attribute, BufferType bufferType, GLenum usage)
+  {
+    size_t count = attribute.byteCount() / attribute.bytesPerElement();
+
+    if(narrow(attribute, bufferType, 0, count)) {
+      _fn->glBufferData((GLenum)bufferType, count * sizeof(uint16_t), _narrowed.data(), usage);
+
+      buffer.type = GL_UNSIGNED_SHORT;
+      buffer.bytesPerElement = sizeof(uint16_t);
+    }
+    else {
+      _fn->glBufferData((GLenum)bufferType, attribute.byteCount(), attribute.data(0), usage);
+
+      buffer.type = attribute.glType();
+      buffer.bytesPerElement = attribute.bytesPerElement();
+    }
+    return count * buffer.bytesPerElement;
+  }
+
+  void createBuffer(const BufferAttribute &attribute, BufferType bufferType)
   {
     GLenum usage = attribute.dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
 
+    //the attribute keeps its data, so the buffer can be re-created after eviction
+    ResourceKey key = attribute.resourceId;
+    _residency.add(key, Residency::Kind::Buffer, attribute.byteCount(), [this, key]() {
+      Buffer *found = _buffers.find(key);
+      if(found) {
+        _fn->glDeleteBuffers(1, &found->handle);
+        _buffers.erase(key);
+      }
+    });
+
+    //a buffer left behind by a destroyed attribute which had the same slot is released
+    Buffer &buffer = _buffers.insert(key, [this](const ResourceKey &stale, Buffer &previous) {
+      _fn->glDeleteBuffers(1, &previous.handle);
+      _residency.remove(stale);
+    });
     _fn->glGenBuffers(1, &buffer.handle);
 
     _fn->glBindBuffer((GLenum)bufferType, buffer.handle);
-    _fn->glBufferData((GLenum)bufferType, attribute.byteCount(), attribute.data(0), usage);
+    _residency.resize(key, upload(buffer, attribute, bufferType, usage));
 
     const_cast<BufferAttribute &>(attribute).onUpload.emitSignal(attribute);
 
-    buffer.type = attribute.glType();
-    buffer.bytesPerElement = attribute.bytesPerElement();
     buffer.version = attribute.version();
   }
 
 public:
-  Attributes(QOpenGLFunctions *fn) : _fn(fn) {}
+  Attributes(QOpenGLFunctions *fn, Residency &residency) : _fn(fn), _residency(residency) {}
 
-  void updateBuffer(const Buffer &buffer, BufferAttribute &attribute, BufferType bufferType)
+  void updateBuffer(Buffer &buffer, BufferAttribute &attribute, BufferType bufferType)
   {
     UpdateRange &updateRange = attribute.updateRange();
 
     _fn->glBindBuffer((GLenum)bufferType, buffer.handle);
 
     if(!attribute.dynamic) {
-      _fn->glBufferData((GLenum)bufferType, attribute.byteCount(), attribute.data(0), GL_STATIC_DRAW );
+      _residency.resize(attribute.resourceId, upload(buffer, attribute, bufferType, GL_STATIC_DRAW));
     }
     else if(updateRange.count == -1) {
-      // Not using update ranges
-      _fn->glBufferSubData((GLenum)bufferType, 0, attribute.byteCount(), attribute.data(0));
+      // Not using update ranges. Re-allocated, since the index width may have changed
+      _residency.resize(attribute.resourceId, upload(buffer, attribute, bufferType, GL_DYNAMIC_DRAW));
     }
     else if(updateRange.count == 0 ) {
 
       throw std::logic_error("updateBuffer: dynamic BufferAttributeBase marked as needsUpdate but updateRange.count is 0, ensure you are using set methods or updating manually");
 
-    } else {
+    }
+    else if(buffer.type != attribute.glType()) {
+      //narrowed index buffer. If the range no longer fits, the whole buffer goes back to 32 bit
+      if(narrow(attribute, bufferType, updateRange.start, updateRange.count)) {
+        _fn->glBufferSubData((GLenum)bufferType,
+                             updateRange.start * buffer.bytesPerElement,
+                             updateRange.count * buffer.bytesPerElement,
+                             _narrowed.data());
+      }
+      else {
+        _residency.resize(attribute.resourceId, upload(buffer, attribute, bufferType, GL_DYNAMIC_DRAW));
+      }
+      updateRange.count = -1; // reset range
+    }
+    else {
       _fn->glBufferSubData((GLenum)bufferType,
                       updateRange.start * buffer.bytesPerElement,
                       updateRange.count * buffer.bytesPerElement,
@@ -66,39 +151,40 @@ public:
 
   bool has(const BufferAttribute &attribute )
   {
-    return _buffers.count(attribute.uuid) > 0;
+    return _buffers.count(source(attribute).resourceId) > 0;
   }
 
   const Buffer &get(const BufferAttribute &attribute ) const {
 
-    //if ( attribute.isInterleavedBufferAttributeBase ) attribute = attribute.data;
-
-    return _buffers.at(attribute.uuid);
+    return _buffers.at(source(attribute).resourceId);
   }
 
-  void remove(const BufferAttribute &attribute)
+  void remove(const BufferAttribute &geometryAttribute)
   {
-    //if ( attribute.isInterleavedBufferAttributeBase ) attribute = attribute.data;
+    const BufferAttribute &attribute = source(geometryAttribute);
 
-    if (_buffers.find(attribute.uuid) != _buffers.end()) {
+    const Buffer *data = _buffers.find(attribute.resourceId);
+    if (data) {
 
-      const Buffer &data = _buffers[ attribute.uuid ];
+      _fn->glDeleteBuffers(1, &data->handle);
 
-      _fn->glDeleteBuffers(1, &data.handle);
-
-      _buffers.erase(attribute.uuid);
+      _buffers.erase(attribute.resourceId);
+      _residency.remove(attribute.resourceId);
     }
   }
 
-  void update(BufferAttribute &attribute, BufferType bufferType)
+  void update(BufferAttribute &geometryAttribute, BufferType bufferType)
   {
-    //if ( attribute.isInterleavedBufferAttributeBase ) attribute = attribute.data;
-    auto found = _buffers.find(attribute.uuid);
-    if (found == _buffers.end()) {
-       createBuffer(_buffers[ attribute.uuid ], attribute, bufferType );
+    BufferAttribute &attribute = source(geometryAttribute);
+
+    Buffer *found = _buffers.find(attribute.resourceId);
+    if (!found) {
+       createBuffer(attribute, bufferType );
     }
     else {
-      Buffer &buffer = found->second;
+      _residency.touch(attribute.resourceId);
+
+      Buffer &buffer = *found;
       if ( buffer.version < attribute.version() ) {
         updateBuffer(buffer, attribute, bufferType);
         buffer.version = attribute.version();
@@ -29,7 +29,9 @@ enum class Extension : uint16_t
   OES_standard_derivatives        = 1<<10,
   ANGLE_instanced_arrays          = 1<<11,
   OES_element_index_uint          = 1<<12,
-  GLEXT_draw_buffers              = 1<<13
+  GLEXT_draw_buffers              = 1<<13,
+  OES_compressed_ETC1_RGB8_texture = 1<<14,
+  ARB_ES3_compatibility           = 1<<15
 };
 
 class UseExtension
@@ -87,7 +89,7 @@ public:
     }
     switch (extension) {
       case Extension::EXT_texture_compression_s3tc:
-        _extensions[extension] = context->hasExtension( "EXT_texture_compression_s3tc" );
+        _extensions[extension] = context->hasExtension( "GL_EXT_texture_compression_s3tc" );
         break;
       case Extension::ARB_depth_texture:
         _extensions[extension] = context->hasExtension("ARB_depth_texture");
@@ -124,6 +126,14 @@ public:
       case Extension::EXT_frag_depth:
         _extensions[extension] = context->hasExtension("EXT_frag_depth");
         break;
+      case Extension::OES_compressed_ETC1_RGB8_texture:
+        _extensions[extension] = context->hasExtension("GL_OES_compressed_ETC1_RGB8_texture");
+        break;
+      case Extension::ARB_ES3_compatibility:
+        //ETC2/EAC are core in OpenGL ES 3.0
+        _extensions[extension] = context->hasExtension("GL_ARB_ES3_compatibility")
+                                 || (context->isOpenGLES() && context->format().majorVersion() >= 3);
+        break;
     }
     return _extensions[extension];
   }
@@ -158,6 +168,13 @@ public:
       case TextureFormat::RGBA_S3TC_DXT3:
       case TextureFormat::RGBA_S3TC_DXT5:
         return get(Extension::EXT_texture_compression_s3tc) ? format : TextureFormat::Undefined;
+      case TextureFormat::RGB_ETC1:
+        if(get(Extension::OES_compressed_ETC1_RGB8_texture)) return format;
+        //ETC2 decoders are required to accept ETC1 data
+        return get(Extension::ARB_ES3_compatibility) ? TextureFormat::RGB_ETC2 : TextureFormat::Undefined;
+      case TextureFormat::RGB_ETC2:
+      case TextureFormat::RGBA_ETC2_EAC:
+        return get(Extension::ARB_ES3_compatibility) ? format : TextureFormat::Undefined;
       default:
         return format;
     }
@@ -10,7 +10,9 @@
 #include <threepp/core/Object3D.h>
 #include <threepp/core/LinearGeometry.h>
 #include <threepp/core/BufferGeometry.h>
+#include <threepp/core/EdgeIndex.h>
 #include "Attributes.h"
+#include "Capabilities.h"
 
 
 namespace three {
@@ -21,59 +23,100 @@ class Geometries
   struct GeometryInfo {
     BufferGeometry::Ptr geometry;
     BufferGeometry::OnDispose::ConnectionId connectionId;
+
+    //deformed copy of another geometry, owning only its position and normal
+    bool deformed = false;
   };
-  std::unordered_map<unsigned, GeometryInfo> geometries;
-  std::unordered_map<unsigned, BufferAttributeT<uint32_t>::Ptr> wireframeAttributes;
+  std::unordered_map<size_t, GeometryInfo> geometries;
+  std::unordered_map<size_t, EdgeIndex::Ptr> wireframes;
 
-  unsigned geometryCount = 0;
+  //the render copies last uploaded for a buffer geometry
+  struct Copies {
+    PackedAttributes::Ptr packed;
+    InterleavedAttributes::Ptr interleaved;
+  };
+  std::unordered_map<size_t, Copies> copies;
 
   Attributes &_attributes;
+  MemoryInfo &_infoMemory;
+  Capabilities &_capabilities;
+
+  void remove(const PackedAttributes::Ptr &packed)
+  {
+    if(!packed) return;
+
+    for(const BufferAttribute::Ptr &attribute : {packed->position, packed->normal, packed->uv, packed->color}) {
+      if(attribute) _attributes.remove(*attribute);
+    }
+  }
+
+  void remove(const InterleavedAttributes::Ptr &interleaved)
+  {
+    if(interleaved && interleaved->buffer) _attributes.remove(*interleaved->buffer);
+  }
 
   void onGeometryDispose(Geometry *geometry)
   {
     GeometryInfo &gi = geometries[ geometry->id ];
     BufferGeometry::Ptr buffergeometry = gi.geometry;
 
-    if (buffergeometry->index()) {
-      _attributes.remove( *buffergeometry->index() );
+    if(gi.deformed) {
+      //the other attributes are still used by the source geometry
+      if(buffergeometry->position()) _attributes.remove(*buffergeometry->position());
+      if(buffergeometry->normal()) _attributes.remove(*buffergeometry->normal());
     }
+    else {
+      if (buffergeometry->index()) {
+        _attributes.remove( *buffergeometry->index() );
+      }
 
-    if(buffergeometry->position()) _attributes.remove(*buffergeometry->position());
-    if(buffergeometry->normal()) _attributes.remove(*buffergeometry->normal());
-    if(buffergeometry->color()) _attributes.remove(*buffergeometry->color());
-    if(buffergeometry->uv()) _attributes.remove(*buffergeometry->uv());
-    if(buffergeometry->uv2()) _attributes.remove(*buffergeometry->uv2());
+      for(const BufferAttribute::Ptr &attribute : {buffergeometry->position(), buffergeometry->normal(),
+                                                   buffergeometry->color(), buffergeometry->uv()}) {
+        if(attribute) _attributes.remove(*attribute);
+      }
+      if(buffergeometry->uv2()) _attributes.remove(*buffergeometry->uv2());
+      if(buffergeometry->skinIndices()) _attributes.remove(*buffergeometry->skinIndices());
+      if(buffergeometry->skinWeights()) _attributes.remove(*buffergeometry->skinWeights());
+    }
+
+    auto uploaded = copies.find(buffergeometry->id);
+    if(uploaded != copies.end()) {
+      remove(uploaded->second.packed);
+      remove(uploaded->second.interleaved);
+      copies.erase(uploaded);
+    }
 
     geometry->onDispose.disconnect(gi.connectionId);
 
     geometries.erase(geometry->id);
 
-    // TODO Remove duplicate code
-    if (wireframeAttributes.find(geometry->id) != wireframeAttributes.end()) {
-      auto &attribute = wireframeAttributes[geometry->id];
-      _attributes.remove( *attribute );
-      wireframeAttributes.erase(geometry->id);
-    }
-
-    if (wireframeAttributes.find(buffergeometry->id) != wireframeAttributes.end()) {
-      auto &attribute = wireframeAttributes[buffergeometry->id];
-      _attributes.remove( *attribute );
-      wireframeAttributes.erase(buffergeometry->id);
+    for(size_t id : {geometry->id, buffergeometry->id}) {
+      auto found = wireframes.find(id);
+      if(found != wireframes.end()) {
+        _attributes.remove(*found->second->edges());
+        wireframes.erase(found);
+      }
     }
 
-    //infoMemory.geometries --;
-    geometryCount--;
+    _infoMemory.geometries --;
   }
 
 public:
-  Geometries(Attributes &attributes) : _attributes(attributes) {}
-
-  BufferGeometry::Ptr get(Object3D::Ptr object, Geometry::Ptr geometry)
+  Geometries(Attributes &attributes, MemoryInfo &infoMemory, Capabilities &capabilities)
+     : _attributes(attributes), _infoMemory(infoMemory), _capabilities(capabilities) {}
+
+  /**
+   * @param deformed the geometry is a copy that shares all attributes but position and normal with
+   * another geometry, like the output of CPU skinning. Only these two are released on disposal
+   */
+  BufferGeometry::Ptr get(Object3D::Ptr object, Geometry::Ptr geometry, bool deformed=false)
   {
     GeometryInfo &gi = geometries[ geometry->id ];
 
     if (gi.geometry) return gi.geometry;
 
+    gi.deformed = deformed;
+
     geometry->onDispose.connect(*this, &Geometries::onGeometryDispose);
 
     BufferGeometry *buffergeometry = geometry->typer;
@@ -83,7 +126,7 @@ public:
     }
     else gi.geometry = CAST2(geometry, BufferGeometry);
 
-    geometryCount++;
+    _infoMemory.geometries ++;
 
     return gi.geometry;
   }
@@ -94,13 +137,33 @@ public:
       _attributes.update(*buffergeometry->getIndex(), BufferType::ElementArray);
     }
 
-    if(buffergeometry->position()) _attributes.update(*buffergeometry->position(), BufferType::Array);
-    if(buffergeometry->normal()) _attributes.update(*buffergeometry->normal(), BufferType::Array);
-    if(buffergeometry->color()) _attributes.update(*buffergeometry->color(), BufferType::Array);
-    if(buffergeometry->uv()) _attributes.update(*buffergeometry->uv(), BufferType::Array);
+    //the render copies follow in-place modifications of their float attributes. Buffers of copies
+    //that were rebuilt, replaced or dropped are released
+    buffergeometry->updateCopies();
+
+    Copies &uploaded = copies[ buffergeometry->id ];
+    if (uploaded.packed != buffergeometry->packed()) {
+      remove(uploaded.packed);
+      uploaded.packed = buffergeometry->packed();
+    }
+    if (uploaded.interleaved != buffergeometry->interleaved()) {
+      remove(uploaded.interleaved);
+      uploaded.interleaved = buffergeometry->interleaved();
+    }
+
+    //packed attributes replace the float ones
+    for(AttributeName name : {AttributeName::position, AttributeName::normal, AttributeName::color, AttributeName::uv}) {
+      BufferAttribute::Ptr attribute = buffergeometry->getAttribute(name);
+      if(attribute) _attributes.update(*attribute, BufferType::Array);
+    }
     if(buffergeometry->uv2()) _attributes.update(*buffergeometry->uv2(), BufferType::Array);
+    if(buffergeometry->skinIndices()) _attributes.update(*buffergeometry->skinIndices(), BufferType::Array);
+    if(buffergeometry->skinWeights()) _attributes.update(*buffergeometry->skinWeights(), BufferType::Array);
 
-    // morph targets
+    // morph targets. With float vertex textures, the targets are sampled from the morph texture
+    // and never bound as vertex attributes
+
+    if ( _capabilities.floatVertexTextures ) return;
 
     for (BufferAttributeT<float>::Ptr pos : buffergeometry->morphPositions()) {
       _attributes.update(*pos, BufferType::Array);
@@ -110,59 +173,32 @@ public:
     }
   }
 
-  BufferAttributeT<uint32_t>::Ptr getWireframeAttribute(const BufferGeometry::Ptr geometry)
+  /**
+   * @return the edges of the geometry's triangles, each edge once. Groups are deduplicated separately,
+   * so every group draws its complete wireframe
+   */
+  EdgeIndex::Ptr getWireframe(const BufferGeometry::Ptr &geometry)
   {
-    BufferAttributeT<uint32_t>::Ptr attribute = wireframeAttributes[ geometry->id ];
-
-    if ( attribute ) return attribute;
+    EdgeIndex::Options options;
+    options.splitGroups = true;
 
-    attribute::prealloc_t<uint32_t> indices;
+    EdgeIndex::Ptr &wireframe = wireframes[ geometry->id ];
 
-    if (geometry->index()) {
+    if ( wireframe && wireframe->builtFor( *geometry, options ) ) {
 
-      auto array = geometry->index()->data_t();
-      unsigned num = geometry->index()->size();
-
-      indices = attribute::prealloc<uint32_t>(num * 2 + num % 3, false);
-      for (size_t i = 0; i < num; i += 3) {
-
-        auto a = array[ i + 0 ];
-        auto b = array[ i + 1 ];
-        auto c = array[ i + 2 ];
-
-        indices->next() = a;
-        indices->next() = b;
-        indices->next() = b;
-        indices->next() = c;
-        indices->next() = c;
-        indices->next() = a;
-      }
+      BufferAttributeT<uint32_t>::Ptr edges = wireframe->edges();
+      if ( wireframe->update() ) _attributes.remove( *edges );
     }
     else {
 
-      unsigned num = geometry->position()->size() / 3 - 1;
-
-      indices = attribute::prealloc<uint32_t>(num * 2 + num % 3, false);
-      for (size_t i = 0; i < num; i += 3 ) {
-
-        uint32_t a = i + 0;
-        uint32_t b = i + 1;
-        uint32_t c = i + 2;
-
-        indices->next() = a;
-        indices->next() = b;
-        indices->next() = b;
-        indices->next() = c;
-        indices->next() = c;
-        indices->next() = a;
-      }
+      if ( wireframe ) _attributes.remove( *wireframe->edges() );
+      wireframe = EdgeIndex::make( *geometry, options );
     }
 
-    _attributes.update(*indices, BufferType::ElementArray);
-
-    wireframeAttributes[ geometry->id ] = indices;
+    //the buffer may have been evicted
+    _attributes.update( *wireframe->edges(), BufferType::ElementArray );
 
-    return indices;
+    return wireframe;
   }
 };
 
@@ -7,15 +7,15 @@
 
 #include <string>
 #include <threepp/Constants.h>
+#include <threepp/renderers/OpenGLRenderer.h>
+#include <threepp/core/BufferGeometry.h>
+#include <threepp/core/Object3D.h>
 #include <QOpenGLFunctions>
 
 namespace three {
 namespace gl {
 
-struct MemoryInfo {
-  unsigned geomtries = 0;
-  unsigned textures = 0;
-};
+using MemoryInfo = OpenGLRenderer::MemoryInfo;
 
 struct RenderInfo
 {
@@ -24,8 +24,21 @@ struct RenderInfo
   unsigned  vertices = 0;
   unsigned  faces = 0;
   unsigned  points = 0;
+  unsigned  occluded = 0;
 };
 
+/**
+ * @return the packed vertex attributes of the object's buffer geometry, or nullptr
+ */
+inline const PackedAttributes *packedAttributes(const Object3D &object)
+{
+  const Geometry::Ptr geometry = object.geometry();
+  if(!geometry) return nullptr;
+
+  BufferGeometry *bufferGeometry = geometry->typer;
+  return bufferGeometry ? bufferGeometry->packed().get() : nullptr;
+}
+
 struct Buffer
 {
   GLuint handle;
@@ -103,7 +103,7 @@ struct Entry<RectAreaLight> : public EntryBase
 class UniformsCache
 {
 public:
-  std::unordered_map<unsigned, lights::EntryBase::Ptr> lights;
+  std::unordered_map<uint64_t, lights::EntryBase::Ptr> lights;
 
 public:
 
@@ -0,0 +1,202 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "MorphTargets.h"
+#include <threepp/util/Parallel.h>
+
+namespace three {
+namespace gl {
+
+using namespace std;
+
+constexpr size_t MorphTargets::maxInfluences;
+
+namespace {
+
+//texture width, chosen to keep the row computation cheap and the texture reasonably square
+const size_t morphTextureWidth = 4096;
+
+//vertices per work item when filling the texture
+const size_t vertexGrain = 4096;
+
+}
+
+void MorphTargets::update(Mesh *object, BufferGeometry::Ptr geometry, Material::Ptr material, Program::Ptr program)
+{
+  auto objectInfluences = object->morphTargetInfluences();
+
+  size_t length = objectInfluences.size();
+
+  if (_influencesList.find(geometry->id) == _influencesList.end()) {
+
+    // initialise list
+    auto res = _influencesList.emplace(geometry->id, std::vector<Influence>(length));
+    res.first->second.resize(length);
+
+    for ( size_t i = 0; i < length; i ++ ) {
+
+      res.first->second[ i ].first = i;
+      res.first->second[ i ].second = 0;
+    }
+  }
+  std::vector<Influence> &influences = _influencesList[ geometry->id ];
+  influences.resize(length);
+
+  bool morphTargets = material->morphTargets && !geometry->morphPositions().empty();
+  bool morphNormals = morphTargets && material->morphNormals && !geometry->morphNormals().empty();
+
+  // Remove current morphAttributes, all 8 slots may be bound from the previous draw
+  for ( unsigned i = 0; i < 8; i ++ ) {
+
+    if (morphTargets) geometry->removeAttribute(IndexedAttributeName::morphTarget, i);
+    if (morphNormals) geometry->removeAttribute(IndexedAttributeName::morphNormal, i);
+  }
+
+  // Collect influences
+  for (unsigned i = 0; i < length; i ++ ) {
+
+    auto &influence = influences[ i ];
+
+    influence.first = i;
+    influence.second = objectInfluences[ i ];
+  }
+
+  std::sort(influences.begin(), influences.end(), [](const Influence &a, const Influence &b) {
+    return std::abs(b.second) < std::abs(a.second);
+  });
+
+  // Add morphAttributes
+  for (unsigned i = 0; i < 8; i ++ ) {
+
+    //sorted by magnitude, negative weights are as significant as positive ones
+    if(i < length && influences[ i ].second != 0) {
+
+      Influence influence = influences[ i ];
+
+      auto index = influence.first;
+      auto value = influence.second;
+
+      if (morphTargets) geometry->addAttribute(IndexedAttributeName::morphTarget, i, geometry->morphPositions()[index]);
+      if (morphNormals) geometry->addAttribute(IndexedAttributeName::morphNormal, i, geometry->morphNormals()[index]);
+
+      _morphInfluences[ i ] = value;
+      continue;
+    }
+    _morphInfluences[ i ] = 0;
+  }
+
+  std::vector<float> values(_morphInfluences.begin(), _morphInfluences.end());
+  program->getUniforms()->set(UniformName::morphTargetInfluences, values);
+}
+
+void MorphTargets::build(MorphTexture &morph, BufferGeometry &geometry)
+{
+  const auto &positions = geometry.morphPositions();
+  const auto &normals = geometry.morphNormals();
+
+  const BufferAttributeT<float>::Ptr &basePosition = geometry.position();
+  const BufferAttributeT<float>::Ptr &baseNormal = geometry.normal();
+
+  size_t targets = positions.size();
+  size_t vertexCount = basePosition ? basePosition->itemCount() : 0;
+  bool withNormals = baseNormal && normals.size() == targets;
+  size_t stride = withNormals ? 2 : 1;
+
+  size_t texels = std::max<size_t>(targets * vertexCount * stride, 1);
+  size_t width = std::min<size_t>(std::min<size_t>(texels, morphTextureWidth), (size_t)_capabilities.maxTextureSize);
+  size_t height = (texels + width - 1) / width;
+
+  if(height > (size_t)_capabilities.maxTextureSize)
+    throw std::logic_error("morph targets exceed the maximum texture size");
+
+  std::vector<float> data(width * height * 4, 0.0f);
+
+  parallel::for_each(0, targets * vertexCount, [&](size_t begin, size_t end) {
+
+    for(size_t i = begin; i < end; i++) {
+      size_t target = i / vertexCount, vertex = i % vertexCount;
+      float *texel = data.data() + i * stride * 4;
+
+      const BufferAttributeT<float> &position = *positions[target];
+      if(vertex < position.itemCount()) {
+        const float *p = position.data_t() + vertex * 3;
+        const float *b = basePosition->data_t() + vertex * 3;
+        for(unsigned c = 0; c < 3; c++) texel[c] = p[c] - b[c];
+      }
+
+      if(withNormals) {
+        const BufferAttributeT<float> &normal = *normals[target];
+        if(vertex < normal.itemCount() && vertex < baseNormal->itemCount()) {
+          const float *n = normal.data_t() + vertex * 3;
+          const float *b = baseNormal->data_t() + vertex * 3;
+          for(unsigned c = 0; c < 3; c++) texel[4 + c] = n[c] - b[c];
+        }
+      }
+    }
+  }, vertexGrain);
+
+  if(morph.texture) morph.texture->dispose();
+
+  TextureOptions options = DataTexture::options();
+  options.format = TextureFormat::RGBA;
+  options.type = TextureType::Float;
+  options.flipY = false;
+
+  morph.texture = DataTexture::make(options, data, width, height);
+  morph.texture->setGenerateMipmaps(false);
+  morph.width = (GLint)width;
+  morph.stride = (GLint)stride;
+  morph.vertexCount = (GLint)vertexCount;
+  morph.targets = targets;
+  morph.version = morphVersion(geometry);
+}
+
+void MorphTargets::setUniforms(Mesh *object, BufferGeometry &geometry, Uniforms &uniforms)
+{
+  auto found = _morphTextures.find(geometry.id);
+  if(found == _morphTextures.end()) {
+    found = _morphTextures.emplace(geometry.id, MorphTexture()).first;
+    found->second.connectionId = geometry.onDispose.connect(*this, &MorphTargets::onGeometryDispose);
+    build(found->second, geometry);
+  }
+  else if(found->second.version != morphVersion(geometry)) {
+    build(found->second, geometry);
+  }
+  const MorphTexture &morph = found->second;
+
+  // compact list of active influences, in target order
+  const std::vector<float> &influences = object->morphTargetInfluences();
+  size_t count = std::min(influences.size(), morph.targets);
+
+  _active.clear();
+  for(size_t i = 0; i < count; i++) {
+    if(influences[i] != 0.0f) _active.emplace_back(i, influences[i]);
+  }
+
+  // rarely needed: keep the strongest influences if there are too many
+  if(_active.size() > maxInfluences) {
+    std::nth_element(_active.begin(), _active.begin() + maxInfluences, _active.end(),
+                     [](const Influence &a, const Influence &b) {
+                       return std::abs(a.second) > std::abs(b.second);
+                     });
+    _active.resize(maxInfluences);
+  }
+
+  _activeValues.resize(_active.size() * 2);
+  for(size_t i = 0; i < _active.size(); i++) {
+    _activeValues[i * 2] = (float)_active[i].first;
+    _activeValues[i * 2 + 1] = _active[i].second;
+  }
+
+  Texture::Ptr texture = morph.texture;
+  uniforms.set(UniformName::morphTexture, texture);
+  uniforms.set(UniformName::morphTextureWidth, morph.width);
+  uniforms.set(UniformName::morphTextureStride, morph.stride);
+  uniforms.set(UniformName::morphVertexCount, morph.vertexCount);
+  uniforms.set(UniformName::morphInfluenceCount, (GLint)_active.size());
+  if(!_activeValues.empty()) uniforms.set(UniformName::morphInfluences, _activeValues);
+}
+
+}
+}
@@ -12,6 +12,8 @@
 #include <threepp/objects/Mesh.h>
 #include <threepp/core/BufferGeometry.h>
 #include <threepp/material/Material.h>
+#include <threepp/textures/DataTexture.h>
+#include "Capabilities.h"
 #include "Program.h"
 
 namespace three {
@@ -19,83 +21,74 @@ namespace gl {
 
 class MorphTargets
 {
+public:
+  //maximum number of simultaneously active influences on the texture path
+  static constexpr size_t maxInfluences = 64;
+
+private:
   QOpenGLFunctions * const _fn;
+  Capabilities &_capabilities;
+
   std::array<float, 8> _morphInfluences;
 
   using Influence = std::pair<size_t, float>;
-  std::unordered_map<uint32_t, std::vector<Influence>> _influencesList;
+  std::unordered_map<size_t, std::vector<Influence>> _influencesList;
 
-public:
-  MorphTargets(QOpenGLFunctions *fn) : _fn(fn) {}
-
-  void update(Mesh *object, BufferGeometry::Ptr geometry, Material::Ptr material, Program::Ptr program)
+  /**
+   * all morph targets of a geometry, stored as deltas from the base geometry
+   */
+  struct MorphTexture
   {
-    auto objectInfluences = object->morphTargetInfluences();
-
-    size_t length = objectInfluences.size();
-
-    if (_influencesList.find(geometry->id) == _influencesList.end()) {
-
-      // initialise list
-      auto res = _influencesList.emplace(geometry->id, std::vector<Influence>(length));
-      res.first->second.resize(length);
-
-      for ( size_t i = 0; i < length; i ++ ) {
-
-        res.first->second[ i ].first = i;
-        res.first->second[ i ].second = 0;
-      }
-    }
-    std::vector<Influence> &influences = _influencesList[ geometry->id ];
-
-    bool morphTargets = material->morphTargets && !geometry->morphPositions().empty();
-    bool morphNormals = material->morphNormals && !geometry->morphNormals().empty();
-
-    // Remove current morphAttributes
-    for ( unsigned i = 0; i < length; i ++ ) {
-
-      auto &influence = influences[ i ];
-
-      if (influence.first != 0 ) {
-        if (morphTargets) geometry->removeAttribute(IndexedAttributeName::morphTarget, i);
-        if (morphNormals) geometry->removeAttribute(IndexedAttributeName::morphNormal, i);
-      }
-    }
-
-    // Collect influences
-    for (unsigned i = 0; i < length; i ++ ) {
-
-      auto &influence = influences[ i ];
-
-      influence.first = i;
-      influence.second = objectInfluences[ i ];
-    }
-
-    std::sort(influences.begin(), influences.end(), [](const Influence &a, const Influence &b) {
-      return std::abs(b.second) > std::abs(a.second);
-    });
-
-    // Add morphAttributes
-    for (unsigned i = 0; i < 8; i ++ ) {
-
-      Influence influence = influences[ i ];
+    DataTexture::Ptr texture;
+    GLint width = 0;
+    GLint stride = 1;
+    GLint vertexCount = 0;
+    size_t targets = 0;
+
+    //sum of the morph attribute versions the texture was built from
+    unsigned version = 0;
+    Geometry::OnDispose::ConnectionId connectionId = nullptr;
+  };
+  std::unordered_map<size_t, MorphTexture> _morphTextures;
+
+  std::vector<Influence> _active;
+  std::vector<float> _activeValues;
+
+  static unsigned morphVersion(const BufferGeometry &geometry)
+  {
+    unsigned version = 0;
+    for(const auto &attribute : geometry.morphPositions()) version += attribute->version();
+    for(const auto &attribute : geometry.morphNormals()) version += attribute->version();
+    return version;
+  }
 
-      auto index = influence.first;
-      auto value = influence.second;
+  void onGeometryDispose(Geometry *geometry)
+  {
+    auto found = _morphTextures.find(geometry->id);
+    if(found == _morphTextures.end()) return;
 
-      if(value > 0) {
-        if (morphTargets) geometry->addAttribute(IndexedAttributeName::morphTarget, i, geometry->morphPositions()[index]);
-        if (morphNormals) geometry->addAttribute(IndexedAttributeName::morphNormal, i, geometry->morphNormals()[index]);
+    geometry->onDispose.disconnect(found->second.connectionId);
+    if(found->second.texture) found->second.texture->dispose();
 
-        _morphInfluences[ i ] = value;
-        continue;
+    _morphTextures.erase(found);
+  }
 
-      }
-      _morphInfluences[ i ] = 0;
-    }
+  void build(MorphTexture &morph, BufferGeometry &geometry);
 
-    //program->getUniforms().setValue( gl, 'morphTargetInfluences', morphInfluences );
-  }
+public:
+  MorphTargets(QOpenGLFunctions *fn, Capabilities &capabilities) : _fn(fn), _capabilities(capabilities) {}
+
+  /**
+   * attribute path, used without vertex texture fetch. Binds the attributes of the 8 strongest
+   * influences to the morph attribute slots
+   */
+  void update(Mesh *object, BufferGeometry::Ptr geometry, Material::Ptr material, Program::Ptr program);
+
+  /**
+   * texture path. Sets the uniforms for the geometry's morph texture and the compact list of non-zero
+   * influences. Vertex attribute bindings are not affected
+   */
+  void setUniforms(Mesh *object, BufferGeometry &geometry, Uniforms &uniforms);
 };
 
 }
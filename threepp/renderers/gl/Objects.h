@@ -7,6 +7,7 @@
 
 #include <vector>
 #include <threepp/core/Object3D.h>
+#include <threepp/objects/SkinnedMesh.h>
 #include "Helpers.h"
 #include "Geometries.h"
 
@@ -15,7 +16,7 @@ namespace gl {
 
 class Objects
 {
-  std::unordered_map<unsigned, unsigned> _updateList;
+  std::unordered_map<size_t, unsigned> _updateList;
 
   Geometries &_geometries;
   RenderInfo &_infoRender;
@@ -30,7 +31,13 @@ public:
     unsigned frame = _infoRender.frame;
 
     Geometry::Ptr geometry = object->geometry();
-    BufferGeometry::Ptr buffergeometry = _geometries.get( object, geometry );
+
+    // meshes skinned on the CPU render a deformed copy, the bind pose geometry may be shared
+    SkinnedMesh *skinned = object->typer;
+    BufferGeometry::Ptr deformed = skinned && skinned->skinsOnCPU() ? skinned->skinnedGeometry() : nullptr;
+    if (deformed) geometry = deformed;
+
+    BufferGeometry::Ptr buffergeometry = _geometries.get( object, geometry, (bool)deformed );
 
     // Update once per frame
     if (_updateList.count(buffergeometry->id) == 0 || _updateList[ buffergeometry->id] != frame ) {
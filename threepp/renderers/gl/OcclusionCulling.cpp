@@ -0,0 +1,323 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "OcclusionCulling.h"
+#include <threepp/util/Parallel.h>
+#include <cmath>
+
+namespace three {
+namespace gl {
+
+using namespace std;
+
+namespace {
+
+//rows rasterized by one task
+static const unsigned bandHeight = 16;
+
+//transform a point by a column major matrix
+inline void project(const float *m, const float *p, float *clip)
+{
+  clip[0] = m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12];
+  clip[1] = m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13];
+  clip[2] = m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14];
+  clip[3] = m[3] * p[0] + m[7] * p[1] + m[11] * p[2] + m[15];
+}
+
+}
+
+OcclusionCulling::OcclusionCulling(unsigned width, unsigned height)
+{
+  setResolution(width, height);
+}
+
+OcclusionCulling &OcclusionCulling::setResolution(unsigned width, unsigned height)
+{
+  if(width == 0 || height == 0) throw invalid_argument("OcclusionCulling: resolution must not be empty");
+
+  _width = width;
+  _height = height;
+  return *this;
+}
+
+OcclusionCulling &OcclusionCulling::setOccluderLimits(unsigned maxOccluders, size_t maxTriangles, float minSize)
+{
+  _maxOccluders = maxOccluders;
+  _maxTriangles = maxTriangles;
+  _minOccluderSize = minSize;
+  return *this;
+}
+
+void OcclusionCulling::begin(const math::Matrix4 &projScreenMatrix, const math::Vector3 &cameraPosition)
+{
+  _projScreenMatrix = projScreenMatrix;
+  _cameraPosition = cameraPosition;
+  _occluders.clear();
+  _triangles.clear();
+
+  _levels.resize(1);
+  _levelSizes.resize(1);
+  _levels[0].assign(_width * _height, 1.0f);
+  _levelSizes[0] = make_pair(_width, _height);
+}
+
+void OcclusionCulling::addOccluder(const Object3D &object, const BufferGeometry &geometry, Side side)
+{
+  if(!geometry.position()) return;
+
+  math::Sphere sphere = geometry.boundingSphere();
+  sphere.apply(object.matrixWorld());
+
+  float distance = sphere.center().distanceTo(_cameraPosition);
+
+  //the camera is inside the bounding sphere, the occluder probably surrounds it
+  float score = distance > sphere.radius() ? sphere.radius() / distance : numeric_limits<float>::max();
+  if(score < _minOccluderSize) return;
+
+  _occluders.push_back(Occluder {&object, &geometry, side, score});
+}
+
+void OcclusionCulling::transform(const Occluder &occluder, std::vector<Triangle> &triangles) const
+{
+  const BufferGeometry &geometry = *occluder.geometry;
+
+  math::Matrix4 matrix;
+  matrix.multiply(_projScreenMatrix, occluder.object->matrixWorld());
+  const float *m = matrix.elements();
+
+  //mirroring transforms flip the winding
+  bool mirrored = occluder.object->matrixWorld().determinant() < 0;
+
+  const float *position = geometry.position()->data_t();
+  const uint32_t *index = geometry.index() ? geometry.index()->data_t() : nullptr;
+  size_t count = index ? geometry.index()->size() : geometry.position()->itemCount();
+
+  size_t start = min<size_t>(geometry.drawRange().start, count);
+  size_t end = geometry.drawRange().count > 0 ? min<size_t>(start + geometry.drawRange().count, count) : count;
+  end = start + (end - start) / 3 * 3;
+
+  float halfWidth = _width * 0.5f, halfHeight = _height * 0.5f;
+
+  for(size_t i = start; i < end; i += 3) {
+
+    Triangle triangle;
+    bool clipped = false;
+
+    for(unsigned k = 0; k < 3; k++) {
+      size_t vertex = index ? index[i + k] : i + k;
+
+      float clip[4];
+      project(m, position + vertex * 3, clip);
+
+      //crossing the near plane. Skipping the triangle only makes the test more conservative
+      if(clip[2] < -clip[3] || clip[3] <= 0) {
+        clipped = true;
+        break;
+      }
+
+      float w = 1.0f / clip[3];
+      triangle.x[k] = (clip[0] * w + 1.0f) * halfWidth;
+      triangle.y[k] = (clip[1] * w + 1.0f) * halfHeight;
+      triangle.z[k] = clip[2] * w;
+    }
+    if(clipped) continue;
+
+    float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0])
+                 - (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+    if(area == 0) continue;
+
+    bool front = (area > 0) != mirrored;
+    if((front && occluder.side == Side::Back) || (!front && occluder.side == Side::Front)) continue;
+
+    if(area < 0) {
+      swap(triangle.x[1], triangle.x[2]);
+      swap(triangle.y[1], triangle.y[2]);
+      swap(triangle.z[1], triangle.z[2]);
+    }
+    triangles.push_back(triangle);
+  }
+}
+
+void OcclusionCulling::rasterize(const Triangle &t, unsigned rowBegin, unsigned rowEnd)
+{
+  float minX = min(t.x[0], min(t.x[1], t.x[2])), maxX = max(t.x[0], max(t.x[1], t.x[2]));
+  float minY = min(t.y[0], min(t.y[1], t.y[2])), maxY = max(t.y[0], max(t.y[1], t.y[2]));
+
+  //pixel centers are at +0.5
+  int left = max((int)ceil(minX - 0.5f), 0), right = min((int)floor(maxX - 0.5f), (int)_width - 1);
+  int bottom = max((int)ceil(minY - 0.5f), (int)rowBegin), top = min((int)floor(maxY - 0.5f), (int)rowEnd - 1);
+  if(left > right || bottom > top) return;
+
+  float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+
+  //depth plane
+  float dzdx = ((t.z[1] - t.z[0]) * (t.y[2] - t.y[0]) - (t.z[2] - t.z[0]) * (t.y[1] - t.y[0])) / area;
+  float dzdy = ((t.z[2] - t.z[0]) * (t.x[1] - t.x[0]) - (t.z[1] - t.z[0]) * (t.x[2] - t.x[0])) / area;
+
+  //edge functions, positive inside. Edge k is opposite to vertex k
+  float a[3], b[3], c[3];
+  for(unsigned k = 0; k < 3; k++) {
+    unsigned i = (k + 1) % 3, j = (k + 2) % 3;
+    a[k] = t.y[i] - t.y[j];
+    b[k] = t.x[j] - t.x[i];
+    c[k] = t.x[i] * t.y[j] - t.x[j] * t.y[i];
+  }
+
+  float px = left + 0.5f;
+  for(int y = bottom; y <= top; y++) {
+
+    float py = y + 0.5f;
+    float e0 = a[0] * px + b[0] * py + c[0];
+    float e1 = a[1] * px + b[1] * py + c[1];
+    float e2 = a[2] * px + b[2] * py + c[2];
+    float z = t.z[0] + dzdx * (px - t.x[0]) + dzdy * (py - t.y[0]);
+
+    float *row = _levels[0].data() + y * _width;
+
+    //branch free so the compiler can vectorize the span
+    for(int x = left; x <= right; x++) {
+      float dx = (float)(x - left);
+      float w0 = e0 + a[0] * dx, w1 = e1 + a[1] * dx, w2 = e2 + a[2] * dx;
+      float depth = z + dzdx * dx;
+
+      bool inside = (w0 >= 0) & (w1 >= 0) & (w2 >= 0) & (depth < row[x]);
+      row[x] = inside ? depth : row[x];
+    }
+  }
+}
+
+void OcclusionCulling::buildPyramid()
+{
+  unsigned width = _width, height = _height;
+
+  while(width > 1 || height > 1) {
+
+    unsigned w = (width + 1) / 2, h = (height + 1) / 2;
+    const vector<float> &src = _levels.back();
+    vector<float> dst(w * h);
+
+    for(unsigned y = 0; y < h; y++) {
+      unsigned sy0 = y * 2, sy1 = min(sy0 + 1, height - 1);
+
+      for(unsigned x = 0; x < w; x++) {
+        unsigned sx0 = x * 2, sx1 = min(sx0 + 1, width - 1);
+
+        dst[y * w + x] = max(max(src[sy0 * width + sx0], src[sy0 * width + sx1]),
+                             max(src[sy1 * width + sx0], src[sy1 * width + sx1]));
+      }
+    }
+    _levels.push_back(move(dst));
+    _levelSizes.push_back(make_pair(w, h));
+
+    width = w;
+    height = h;
+  }
+}
+
+void OcclusionCulling::rasterize()
+{
+  //largest first
+  sort(_occluders.begin(), _occluders.end(), [](const Occluder &a, const Occluder &b) {return a.score > b.score;});
+
+  size_t budget = _maxTriangles;
+  unsigned selected = 0;
+  for(const Occluder &occluder : _occluders) {
+    if(selected == _maxOccluders) break;
+
+    const BufferGeometry &geometry = *occluder.geometry;
+    size_t triangles = (geometry.index() ? geometry.index()->size() : geometry.position()->itemCount()) / 3;
+    if(triangles > budget) continue;
+
+    budget -= triangles;
+    _occluders[selected++] = occluder;
+  }
+  _occluders.resize(selected);
+
+  //transform occluders concurrently, then rasterize horizontal bands concurrently
+  vector<vector<Triangle>> transformed(_occluders.size());
+  parallel::for_each(0, _occluders.size(), [&](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; i++) transform(_occluders[i], transformed[i]);
+  });
+
+  for(const auto &triangles : transformed)
+    _triangles.insert(_triangles.end(), triangles.begin(), triangles.end());
+
+  unsigned bands = (_height + bandHeight - 1) / bandHeight;
+  parallel::for_each(0, bands, [&](size_t begin, size_t end) {
+
+    unsigned rowBegin = (unsigned)begin * bandHeight;
+    unsigned rowEnd = min((unsigned)end * bandHeight, _height);
+
+    for(const Triangle &triangle : _triangles) {
+      float minY = min(triangle.y[0], min(triangle.y[1], triangle.y[2]));
+      float maxY = max(triangle.y[0], max(triangle.y[1], triangle.y[2]));
+      if(maxY < rowBegin || minY > rowEnd) continue;
+
+      rasterize(triangle, rowBegin, rowEnd);
+    }
+  });
+
+  buildPyramid();
+}
+
+bool OcclusionCulling::occluded(const math::Box3 &box, const math::Matrix4 &matrixWorld) const
+{
+  if(box.isEmpty() || _triangles.empty()) return false;
+
+  math::Matrix4 matrix;
+  matrix.multiply(_projScreenMatrix, matrixWorld);
+  const float *m = matrix.elements();
+
+  float minX = numeric_limits<float>::max(), maxX = -minX, minY = minX, maxY = -minX, minZ = minX;
+
+  for(unsigned i = 0; i < 8; i++) {
+    float corner[3] = {
+       (i & 1) ? box.max().x() : box.min().x(),
+       (i & 2) ? box.max().y() : box.min().y(),
+       (i & 4) ? box.max().z() : box.min().z()
+    };
+    float clip[4];
+    project(m, corner, clip);
+
+    if(clip[2] < -clip[3] || clip[3] <= 0) return false;
+
+    float w = 1.0f / clip[3];
+    float x = (clip[0] * w + 1.0f) * _width * 0.5f;
+    float y = (clip[1] * w + 1.0f) * _height * 0.5f;
+
+    minX = min(minX, x); maxX = max(maxX, x);
+    minY = min(minY, y); maxY = max(maxY, y);
+    minZ = min(minZ, clip[2] * w);
+  }
+
+  //outside the buffer, left to frustum culling
+  if(maxX < 0 || maxY < 0 || minX >= _width || minY >= _height) return false;
+
+  int left = max((int)floor(minX), 0), right = min((int)floor(maxX), (int)_width - 1);
+  int bottom = max((int)floor(minY), 0), top = min((int)floor(maxY), (int)_height - 1);
+
+  //choose the level where the box covers at most 4x4 texels
+  unsigned level = 0;
+  while(level + 1 < _levels.size() && max(right - left, top - bottom) >> level > 3) level++;
+
+  const vector<float> &depth = _levels[level];
+  unsigned width = _levelSizes[level].first;
+
+  for(int y = bottom >> level; y <= top >> level; y++) {
+    for(int x = left >> level; x <= right >> level; x++) {
+      if(depth[y * width + x] >= minZ) return false;
+    }
+  }
+  return true;
+}
+
+bool OcclusionCulling::occluded(const Object3D &object, Geometry &geometry) const
+{
+  if(geometry.boundingBox().isEmpty()) geometry.computeBoundingBox();
+
+  return occluded(geometry.boundingBox(), object.matrixWorld());
+}
+
+}
+}
@@ -0,0 +1,124 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_OCCLUSIONCULLING_H
+#define THREEPP_OCCLUSIONCULLING_H
+
+#include <vector>
+#include <threepp/core/Object3D.h>
+#include <threepp/core/BufferGeometry.h>
+#include <threepp/math/Matrix4.h>
+#include <threepp/math/Box3.h>
+
+namespace three {
+namespace gl {
+
+/**
+ * software occlusion culling. A few large occluders are selected per frame and rasterized into a small
+ * CPU depth buffer, horizontal bands of which are filled concurrently. A hierarchical Z pyramid built
+ * from that buffer holds the farthest depth per texel, so a bounding box can be tested against a handful
+ * of texels regardless of its screen size. Depth is normalized device z, smaller is nearer.
+ *
+ * The test is conservative: occluders which cross the near plane or do not qualify are ignored,
+ * boxes which cross the near plane are never culled
+ */
+class OcclusionCulling
+{
+  struct Occluder
+  {
+    const Object3D *object;
+    const BufferGeometry *geometry;
+    Side side;
+    float score;
+  };
+
+  //screen space triangle, counterclockwise
+  struct Triangle
+  {
+    float x[3], y[3], z[3];
+  };
+
+  unsigned _width, _height;
+  unsigned _maxOccluders = 32;
+  size_t _maxTriangles = 100000;
+  float _minOccluderSize = 0.1f;
+
+  math::Matrix4 _projScreenMatrix;
+  math::Vector3 _cameraPosition;
+
+  std::vector<Occluder> _occluders;
+  std::vector<Triangle> _triangles;
+
+  //level 0 is the depth buffer, each further level holds the maximum of 2x2 texels of its predecessor
+  std::vector<std::vector<float>> _levels;
+  std::vector<std::pair<unsigned, unsigned>> _levelSizes;
+
+  void transform(const Occluder &occluder, std::vector<Triangle> &triangles) const;
+
+  void rasterize(const Triangle &triangle, unsigned rowBegin, unsigned rowEnd);
+
+  void buildPyramid();
+
+public:
+  OcclusionCulling(unsigned width=256, unsigned height=128);
+
+  /**
+   * set the depth buffer resolution. Takes effect with the next call to begin()
+   */
+  OcclusionCulling &setResolution(unsigned width, unsigned height);
+
+  /**
+   * @param maxOccluders the number of occluders rasterized per frame
+   * @param maxTriangles the total number of occluder triangles per frame. Occluders exceeding the
+   * remaining budget are skipped
+   * @param minSize the minimum ratio of bounding sphere radius to camera distance for an occluder
+   */
+  OcclusionCulling &setOccluderLimits(unsigned maxOccluders, size_t maxTriangles, float minSize);
+
+  unsigned width() const {return _width;}
+  unsigned height() const {return _height;}
+
+  /**
+   * start a new frame
+   *
+   * @param projScreenMatrix the camera's combined projection and view matrix
+   * @param cameraPosition the camera position in world space
+   */
+  void begin(const math::Matrix4 &projScreenMatrix, const math::Vector3 &cameraPosition);
+
+  /**
+   * offer an occluder candidate. Candidates are ranked by their projected size, only the largest are used
+   *
+   * @param side the faces of the geometry which are rendered
+   */
+  void addOccluder(const Object3D &object, const BufferGeometry &geometry, Side side);
+
+  /**
+   * rasterize the selected occluders and build the depth pyramid
+   */
+  void rasterize();
+
+  /**
+   * @return true if the box, transformed by matrixWorld, is hidden behind the occluders
+   */
+  bool occluded(const math::Box3 &box, const math::Matrix4 &matrixWorld) const;
+
+  /**
+   * @return true if the object's geometry bounding box is hidden behind the occluders
+   */
+  bool occluded(const Object3D &object, Geometry &geometry) const;
+
+  /**
+   * @return the depth buffer at the given pyramid level, row by row from the bottom
+   */
+  const std::vector<float> &depth(unsigned level=0) const {return _levels.at(level);}
+
+  size_t occluderCount() const {return _occluders.size();}
+  size_t triangleCount() const {return _triangles.size();}
+};
+
+}
+}
+
+#endif //THREEPP_OCCLUSIONCULLING_H
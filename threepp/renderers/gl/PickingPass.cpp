@@ -0,0 +1,378 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include <sstream>
+#include "PickingPass.h"
+#include "Renderer_impl.h"
+#include "shader/ShaderLib.h"
+#include <threepp/material/RawShaderMaterial.h>
+
+namespace three {
+namespace gl {
+
+using namespace std;
+
+namespace {
+
+//end of the #version directive, which must stay in front
+size_t versionEnd(const string &source)
+{
+  size_t version = source.find("#version");
+  if(version == string::npos) return 0;
+
+  size_t end = source.find('\n', version);
+  return end == string::npos ? source.size() : end + 1;
+}
+
+//the material's vertex shader with main() renamed, called from a main() that also writes the pick id
+string pickVertexShader(const string &source)
+{
+  size_t start = versionEnd(source);
+
+  stringstream ss;
+  ss << source.substr(0, start)
+     << "#define main pickMain" << endl
+     << source.substr(start) << endl
+     << "#undef main" << endl
+     << "uniform int pickId;" << endl
+     << "flat out uint vPickId;" << endl
+     << "void main() {" << endl
+     << "\tpickMain();" << endl
+     << "\tvPickId = uint( pickId ) + uint( gl_InstanceID );" << endl
+     << "}" << endl;
+
+  return ss.str();
+}
+
+}
+
+PickingPass::PickingPass(Renderer_impl &renderer) : _renderer(renderer)
+{
+  static constexpr uint16_t _NumberOfMaterialVariants =
+     (Flag::Morphing | Flag::Skinning | Flag::QuantizedPosition | Flag::OctNormal) + 1;
+
+  for (size_t i = 0; i < _NumberOfMaterialVariants; ++ i ) {
+
+    ShaderInfo si = shaderlib::get(ShaderID::pick);
+    ShaderMaterial::Ptr material = ShaderMaterial::make(
+       si.uniforms, si.vertexShader, si.fragmentShader, Side::Front, true, true, false);
+
+    material->morphTargets = ( i & Flag::Morphing ) != 0;
+    material->skinning = ( i & Flag::Skinning ) != 0;
+    material->blending = Blending::None;
+    material->lights = false;
+
+    _materials.push_back(material);
+  }
+}
+
+void PickingPass::request(unsigned x, unsigned y, unsigned radius, const Scene::Ptr &scene)
+{
+  lock_guard<mutex> lock(_mutex);
+
+  _request = Request {x, y, radius, scene, !scene};
+  _requested = true;
+}
+
+bool PickingPass::result(Result &result)
+{
+  lock_guard<mutex> lock(_mutex);
+
+  if(!_hasResult) return false;
+
+  result = _result;
+  _result = Result();
+  _hasResult = false;
+  return true;
+}
+
+ShaderMaterial::Ptr PickingPass::getShaderVariant(const Material::Ptr &material, const ShaderMaterial &shaderMaterial)
+{
+  ShaderVariant &variant = _shaderVariants[material->id];
+
+  if(!variant.pick || variant.vertexShader != shaderMaterial.vertexShader) {
+
+    string vertexShader = pickVertexShader(shaderMaterial.vertexShader);
+    string fragmentShader = shaderlib::get(ShaderID::pick).fragmentShader;
+
+    ShaderMaterial::Ptr pick;
+    if(material->is<RawShaderMaterial>()) {
+      //raw shaders get no prefix, the fragment shader needs the same version as the vertex shader
+      stringstream ss;
+      ss << shaderMaterial.vertexShader.substr(0, versionEnd(shaderMaterial.vertexShader))
+         << "precision highp float;" << endl
+         << "precision highp int;" << endl
+         << fragmentShader;
+
+      pick = RawShaderMaterial::make(shaderMaterial.uniforms, vertexShader.c_str(), ss.str().c_str(),
+                                     Side::Front, true, true, false);
+    }
+    else {
+      pick = ShaderMaterial::make(shaderMaterial.uniforms, vertexShader.c_str(), fragmentShader.c_str(),
+                                  Side::Front, true, true, false);
+    }
+
+    //the uniform values are shared with the material, defines and flags must match its vertex shader
+    pick->defines = shaderMaterial.defines;
+    pick->index0AttributeName = shaderMaterial.index0AttributeName;
+    pick->clipping = shaderMaterial.clipping;
+    pick->morphTargets = shaderMaterial.morphTargets;
+    pick->morphNormals = shaderMaterial.morphNormals;
+    pick->skinning = shaderMaterial.skinning;
+    pick->lights = shaderMaterial.lights;
+    pick->fog = shaderMaterial.fog;
+    pick->blending = Blending::None;
+
+    variant.material = material;
+    variant.vertexShader = shaderMaterial.vertexShader;
+    variant.pick = pick;
+  }
+
+  return variant.pick;
+}
+
+Material::Ptr PickingPass::getMaterial(const Object3D::Ptr &object, const Material::Ptr &material)
+{
+  ShaderMaterial::Ptr result;
+
+  if(ShaderMaterial *shaderMaterial = material->typer) {
+    result = getShaderVariant(material, *shaderMaterial);
+  }
+  else {
+    result = _materials[ variantIndex(object, material) ];
+  }
+
+  result->side = material->side;
+  result->wireframe = material->wireframe;
+  result->wireframeLineWidth = material->wireframeLineWidth;
+  result->depthTest = material->depthTest;
+
+  return result;
+}
+
+unsigned PickingPass::variantIndex(const Object3D::Ptr &object, const Material::Ptr &material)
+{
+  unsigned variantIndex = 0;
+
+  if ( material->morphTargets && object->geometry()->useMorphing() ) variantIndex |= Flag::Morphing;
+  if ( object->skinned() && material->skinning ) variantIndex |= Flag::Skinning;
+
+  const PackedAttributes *packed = packedAttributes(*object);
+  if ( packed && packed->position ) variantIndex |= Flag::QuantizedPosition;
+  if ( packed && packed->normal ) variantIndex |= Flag::OctNormal;
+
+  return variantIndex;
+}
+
+void PickingPass::renderItems(RenderList::iterator renderIterator, const Camera::Ptr &camera, uint32_t &nextId)
+{
+  while(renderIterator) {
+
+    const RenderItem &renderItem = *renderIterator;
+    renderIterator++;
+
+    //immediate render objects have no buffer geometry to draw with the id material
+    if(!renderItem.geometry || !renderItem.material->visible) continue;
+
+    uint32_t count = 1;
+    if(InstancedBufferGeometry *instanced = renderItem.geometry->typer)
+      count = std::max(instanced->maxInstancedCount(), 1u);
+
+    _slots.push_back(Slot {nextId, count, renderItem.object});
+
+    _renderer._pickId = (GLint)nextId;
+    nextId += count;
+
+    Material::Ptr material = getMaterial(renderItem.object, renderItem.material);
+    _renderer.renderBufferDirect(camera, nullptr, renderItem.geometry, material, renderItem.object, renderItem.group);
+  }
+}
+
+void PickingPass::render(const RenderList &renderList, const Scene::Ptr &scene, const Camera::Ptr &camera,
+                         const math::Vector4 &viewport)
+{
+  if(_fence) resolve();
+
+  //previous readback still in flight
+  if(_fence) return;
+
+  Request request;
+  {
+    lock_guard<mutex> lock(_mutex);
+
+    if(!_requested) return;
+
+    //another scene rendered to the same view is not what the request refers to
+    if(!_request.anyScene && _request.scene.lock() != scene) return;
+
+    request = _request;
+    _requested = false;
+  }
+
+  GLint vx = (GLint)viewport.x(), vy = (GLint)viewport.y();
+  GLsizei vw = (GLsizei)viewport.z(), vh = (GLsizei)viewport.w();
+  if(vw <= 0 || vh <= 0) return;
+
+  //the target covers the viewport at the same position, so pixel coordinates need no mapping
+  GLsizei width = vx + vw, height = vy + vh;
+  if(!_target || _target->width() != width || _target->height() != height) {
+
+    if(_target) _target->dispose();
+
+    RenderTargetInternal::Options options;
+    options.depthBuffer = true;
+    options.stencilBuffer = false;
+    options.minFilter = TextureFilter::Nearest;
+    options.magFilter = TextureFilter::Nearest;
+    options.format = TextureFormat::RGBA;
+    options.type = TextureType::UnsignedByte;
+
+    _target = RenderTargetInternal::make(options, width, height);
+  }
+  _target->setViewport(vx, vy, vw, vh);
+
+  //requested position in framebuffer coordinates, origin at the bottom
+  GLint px = vx + (GLint)(request.x * _renderer._pixelRatio);
+  GLint py = vy + vh - 1 - (GLint)(request.y * _renderer._pixelRatio);
+  GLint radius = (GLint)(request.radius * _renderer._pixelRatio);
+
+  GLint x0 = std::max(px - radius, vx), x1 = std::min(px + radius + 1, vx + vw);
+  GLint y0 = std::max(py - radius, vy), y1 = std::min(py + radius + 1, vy + vh);
+
+  if(x0 >= x1 || y0 >= y1) {
+    //outside the viewport
+    lock_guard<mutex> lock(_mutex);
+    _result = Result();
+    _result.x = request.x;
+    _result.y = request.y;
+    _hasResult = true;
+    return;
+  }
+
+  const Renderer::Target::Ptr renderTarget = _renderer.getRenderTarget();
+
+  _renderer.setRenderTarget(_target);
+
+  //only the requested region is drawn
+  gl::State &state = _renderer.state();
+  state.scissor(math::Vector4(x0, y0, x1 - x0, y1 - y0));
+  state.setScissorTest(true);
+
+  state.colorBuffer.setClear(0, 0, 0, 0);
+  _renderer.clear(true, true, false);
+
+  //forget the variants of deleted materials
+  for(auto it = _shaderVariants.begin(); it != _shaderVariants.end(); ) {
+    if(it->second.material.expired()) it = _shaderVariants.erase(it);
+    else it++;
+  }
+
+  //id 0 means background
+  _slots.clear();
+  uint32_t nextId = 1;
+
+  renderItems(renderList.opaque(), camera, nextId);
+  renderItems(renderList.transparent(), camera, nextId);
+
+  _renderer._pickId = 0;
+
+  //start the readback
+  _pending = request;
+  _centerX = px - x0;
+  _centerY = py - y0;
+  _regionX = x0;
+  _regionY = y0;
+  _regionWidth = x1 - x0;
+  _regionHeight = y1 - y0;
+
+  if(!_pixelBuffer) _renderer.glGenBuffers(1, &_pixelBuffer);
+
+  _renderer.glBindBuffer(GL_PIXEL_PACK_BUFFER, _pixelBuffer);
+  _renderer.glBufferData(GL_PIXEL_PACK_BUFFER, _regionWidth * _regionHeight * 4, nullptr, GL_STREAM_READ);
+  _renderer.glReadPixels(_regionX, _regionY, _regionWidth, _regionHeight, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  _renderer.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  _fence = _renderer.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  _renderer.setRenderTarget(renderTarget);
+  check_glerror(&_renderer);
+}
+
+void PickingPass::resolve()
+{
+  if(_renderer.glClientWaitSync(_fence, 0, 0) == GL_TIMEOUT_EXPIRED) return;
+
+  _renderer.glDeleteSync(_fence);
+  _fence = nullptr;
+
+  _renderer.glBindBuffer(GL_PIXEL_PACK_BUFFER, _pixelBuffer);
+  const uint8_t *pixels = (const uint8_t *)_renderer.glMapBufferRange(
+     GL_PIXEL_PACK_BUFFER, 0, _regionWidth * _regionHeight * 4, GL_MAP_READ_BIT);
+
+  //the nearest non-background pixel wins
+  uint32_t picked = 0;
+  if(pixels) {
+    GLint best = numeric_limits<GLint>::max();
+
+    for(GLint y = 0; y < _regionHeight; y++) {
+      for(GLint x = 0; x < _regionWidth; x++) {
+
+        const uint8_t *p = pixels + (y * _regionWidth + x) * 4;
+        uint32_t id = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+        if(!id) continue;
+
+        GLint dx = x - _centerX, dy = y - _centerY;
+        GLint distance = dx * dx + dy * dy;
+        if(distance < best) {
+          best = distance;
+          picked = id;
+        }
+      }
+    }
+    _renderer.glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  _renderer.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  Result result;
+  result.x = _pending.x;
+  result.y = _pending.y;
+
+  if(picked) {
+    auto found = upper_bound(_slots.begin(), _slots.end(), picked,
+                             [](uint32_t id, const Slot &slot) {return id < slot.base;});
+    if(found != _slots.begin()) {
+      const Slot &slot = *(found - 1);
+      if(picked < slot.base + slot.count) {
+        result.object = slot.object.lock();
+        result.instance = picked - slot.base;
+      }
+    }
+  }
+  _slots.clear();
+
+  lock_guard<mutex> lock(_mutex);
+  _result = result;
+  _hasResult = true;
+}
+
+void PickingPass::dispose()
+{
+  if(_fence) {
+    _renderer.glDeleteSync(_fence);
+    _fence = nullptr;
+  }
+  if(_pixelBuffer) {
+    _renderer.glDeleteBuffers(1, &_pixelBuffer);
+    _pixelBuffer = 0;
+  }
+  if(_target) {
+    _target->dispose();
+    _target = nullptr;
+  }
+  _slots.clear();
+  _shaderVariants.clear();
+}
+
+}
+}
@@ -0,0 +1,119 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_PICKINGPASS_H
+#define THREEPP_PICKINGPASS_H
+
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <threepp/renderers/OpenGLRenderer.h>
+#include <threepp/material/ShaderMaterial.h>
+#include "RenderTarget.h"
+#include "RenderLists.h"
+
+namespace three {
+namespace gl {
+
+class Renderer_impl;
+
+/**
+ * renders object ids into an offscreen RGBA8 target and reads the requested pixel region back through
+ * a pixel buffer object. Ids are assigned per draw call, instanced draws get one id per instance. The
+ * readback is synchronized with a fence and resolved during the following render call, so the render
+ * thread never waits for the GPU.
+ *
+ * Objects drawn with a ShaderMaterial are picked using the material's own vertex shader, so instance
+ * transforms and vertex displacement applied there match the rendered image
+ */
+class PickingPass : public OpenGLRenderer::Picking
+{
+  enum Flag : uint16_t {Morphing = 1, Skinning= 2, QuantizedPosition = 4, OctNormal = 8};
+
+  struct Request
+  {
+    unsigned x, y, radius;
+
+    //the scene to pick from, empty for any
+    std::weak_ptr<Scene> scene;
+    bool anyScene;
+  };
+
+  //the ids [base, base + count) belong to object
+  struct Slot
+  {
+    uint32_t base;
+    uint32_t count;
+    std::weak_ptr<Object3D> object;
+  };
+
+  //pick variant of a ShaderMaterial
+  struct ShaderVariant
+  {
+    std::weak_ptr<Material> material;
+    std::string vertexShader;
+    ShaderMaterial::Ptr pick;
+  };
+
+  Renderer_impl &_renderer;
+
+  std::vector<ShaderMaterial::Ptr> _materials;
+
+  //by material id
+  std::unordered_map<uint64_t, ShaderVariant> _shaderVariants;
+
+  RenderTargetInternal::Ptr _target;
+
+  //request and result are exchanged with other threads
+  std::mutex _mutex;
+  bool _requested = false;
+  Request _request;
+  bool _hasResult = false;
+  Result _result;
+
+  //readback in flight
+  GLuint _pixelBuffer = 0;
+  GLsync _fence = nullptr;
+  Request _pending;
+  GLint _regionX = 0, _regionY = 0, _centerX = 0, _centerY = 0;
+  GLsizei _regionWidth = 0, _regionHeight = 0;
+  std::vector<Slot> _slots;
+
+  Material::Ptr getMaterial(const Object3D::Ptr &object, const Material::Ptr &material);
+
+  static unsigned variantIndex(const Object3D::Ptr &object, const Material::Ptr &material);
+
+  ShaderMaterial::Ptr getShaderVariant(const Material::Ptr &material, const ShaderMaterial &shaderMaterial);
+
+  void renderItems(RenderList::iterator renderIterator, const Camera::Ptr &camera, uint32_t &nextId);
+
+  void resolve();
+
+public:
+  explicit PickingPass(Renderer_impl &renderer);
+
+  void request(unsigned x, unsigned y, unsigned radius, const Scene::Ptr &scene) override;
+
+  bool result(Result &result) override;
+
+  /**
+   * called by the renderer after a scene was rendered to a view. Resolves a completed readback, then
+   * serves a new request for the scene, if any, using the render list of the frame
+   *
+   * @param viewport the viewport the scene was rendered to, in pixels
+   */
+  void render(const RenderList &renderList, const Scene::Ptr &scene, const Camera::Ptr &camera,
+              const math::Vector4 &viewport);
+
+  /**
+   * release GL resources. The context must be current
+   */
+  void dispose();
+};
+
+}
+}
+
+#endif //THREEPP_PICKINGPASS_H
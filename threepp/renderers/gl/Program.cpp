@@ -179,6 +179,12 @@ void Program::fetchAttributeLocations(enum_map<AttributeName, GLint> &attributes
     else if(!strncmp(info.name, "normal", 100)) {
       attributes[AttributeName::normal] = _renderer.glGetAttribLocation(_program, info.name);
     }
+    else if(!strncmp(info.name, "skinIndex", 100)) {
+      attributes[AttributeName::skinIndex] = _renderer.glGetAttribLocation(_program, info.name);
+    }
+    else if(!strncmp(info.name, "skinWeight", 100)) {
+      attributes[AttributeName::skinWeight] = _renderer.glGetAttribLocation(_program, info.name);
+    }
     else {
       throw std::logic_error("unknown attribute");
     }
@@ -456,7 +462,13 @@ Program::Program(Renderer_impl &renderer,
     if(*parameters->useVertexTexture) ss << "#define BONE_TEXTURE" << endl;
 
     if(*parameters->morphTargets) ss << "#define USE_MORPHTARGETS" << endl;
-    if(*parameters->morphNormals && !*parameters->flatShading) ss << "#define USE_MORPHNORMALS" << endl;
+    if(*parameters->morphTargets && *parameters->morphNormals && !*parameters->flatShading) ss << "#define USE_MORPHNORMALS" << endl;
+    if(*parameters->morphTexture) {
+      ss << "#define USE_MORPHTEXTURE" << endl;
+      ss << "#define MAX_MORPH_INFLUENCES " << *parameters->maxMorphTargets << endl;
+    }
+    if(*parameters->quantizedPosition) ss << "#define QUANTIZED_POSITION" << endl;
+    if(*parameters->octNormal) ss << "#define OCT_NORMAL" << endl;
     if(*parameters->doubleSided) ss << "#define DOUBLE_SIDED" << endl;
     if(*parameters->flipSided) ss << "#define FLIP_SIDED" << endl;
 
@@ -488,7 +500,7 @@ Program::Program(Renderer_impl &renderer,
 
     ss << "#endif" << endl;
 
-    ss << "#ifdef USE_MORPHTARGETS" << endl;
+    ss << "#if defined( USE_MORPHTARGETS ) && ! defined( USE_MORPHTEXTURE )" << endl;
 
     ss << "	in vec3 morphTarget0;" << endl;
     ss << "	in vec3 morphTarget1;" << endl;
@@ -520,6 +532,24 @@ Program::Program(Renderer_impl &renderer,
 
     ss << "#endif" << endl;
 
+    ss << "#ifdef QUANTIZED_POSITION" << endl;
+
+    ss << "	uniform vec3 positionOffset;" << endl;
+    ss << "	uniform vec3 positionScale;" << endl;
+
+    ss << "#endif" << endl;
+
+    ss << "#ifdef OCT_NORMAL" << endl;
+
+    ss << "	vec3 octDecode( vec2 e ) {" << endl;
+    ss << "		vec3 n = vec3( e, 1.0 - abs( e.x ) - abs( e.y ) );" << endl;
+    ss << "		float t = max( -n.z, 0.0 );" << endl;
+    ss << "		n.xy += vec2( n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t );" << endl;
+    ss << "		return normalize( n );" << endl;
+    ss << "	}" << endl;
+
+    ss << "#endif" << endl;
+
     prefixVertex = ss.str();
 
     ss.seekp(stringstream::beg);
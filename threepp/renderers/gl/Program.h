@@ -225,8 +225,11 @@ public:
   ProgramParameterT<bool>            useVertexTexture {all};
   ProgramParameterT<bool>            morphTargets {all};
   ProgramParameterT<bool>            morphNormals {all};
+  ProgramParameterT<bool>            morphTexture {all};
   ProgramParameterT<size_t>          maxMorphTargets {all};
   ProgramParameterT<size_t>          maxMorphNormals {all};
+  ProgramParameterT<bool>            quantizedPosition {all};
+  ProgramParameterT<bool>            octNormal {all};
   ProgramParameterT<size_t>          numDirLights {all};
   ProgramParameterT<size_t>          numPointLights {all};
   ProgramParameterT<size_t>          numSpotLights {all};
@@ -192,9 +192,17 @@ ProgramParameters::Ptr Programs::getParameters(const Renderer_impl &renderer,
 
   parameters->morphTargets = material->morphTargets;
   parameters->morphNormals = material->morphNormals;
-  parameters->maxMorphTargets = renderer._maxMorphTargets;
+
+  // with vertex texture fetch, all targets are read from a texture and only the active influences are passed
+  parameters->morphTexture = material->morphTargets && _capabilities.floatVertexTextures;
+  parameters->maxMorphTargets = *parameters->morphTexture ? MorphTargets::maxInfluences : renderer._maxMorphTargets;
   parameters->maxMorphNormals = renderer._maxMorphNormals;
 
+  // packed vertex attributes are decoded in the vertex shader
+  const PackedAttributes *packed = packedAttributes(*object);
+  parameters->quantizedPosition = packed && packed->position;
+  parameters->octNormal = packed && packed->normal;
+
   parameters->numDirLights = lights.directional.size();
   parameters->numPointLights = lights.point.size();
   parameters->numSpotLights = lights.spot.size();
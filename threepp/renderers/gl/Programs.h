@@ -33,35 +33,42 @@ public:
     return Ptr(new Programs(extensions, capabilities));
   }
 
-  unsigned allocateBones(SkinnedMesh *skinnedMesh)
+  /**
+   * @return the number of bone matrices the shader can hold, 1024 if they are read from a texture
+   */
+  size_t bonePaletteSize() const
   {
-    const Skeleton::Ptr skeleton = skinnedMesh->skeleton();
-    const std::vector<Bone::Ptr> bones = skeleton->bones();
+    if (_capabilities.floatVertexTextures ) return 1024;
 
-    if (_capabilities.floatVertexTextures ) {
-      return 1024;
-    }
-    else {
+    //  - leave some extra space for other uniforms
+    //  - limit here is ANGLE's 254 max uniform vectors
+    //    (up to 54 should be safe)
+    return (size_t)std::floor((_capabilities.maxVertexUniforms - 20) / 4 );
+  }
 
-      // default for when object is not specified
-      // ( for example when prebuilding shader to be used with multiple objects )
-      //
-      //  - leave some extra space for other uniforms
-      //  - limit here is ANGLE's 254 max uniform vectors
-      //    (up to 54 should be safe)
+  /**
+   * @return true if the mesh's skeleton fits into the bone palette
+   */
+  bool fitsBonePalette(SkinnedMesh *skinnedMesh) const
+  {
+    const Skeleton::Ptr skeleton = skinnedMesh->skeleton();
+    return !skeleton || skeleton->bones().size() <= bonePaletteSize();
+  }
 
-      //var nVertexUniforms = _capabilities.maxVertexUniforms;
-      size_t nVertexMatrices = (size_t)std::floor((_capabilities.maxVertexUniforms - 20) / 4 );
+  /**
+   * @return the palette size for the shader, 0 if the shader doesn't skin: there are no bones, or the
+   * mesh is deformed on the CPU
+   */
+  unsigned allocateBones(SkinnedMesh *skinnedMesh)
+  {
+    const Skeleton::Ptr skeleton = skinnedMesh->skeleton();
 
-      size_t maxBones = std::min( nVertexMatrices, bones.size());
+    if (!skeleton || skeleton->bones().empty() || skinnedMesh->skinsOnCPU()) return 0;
 
-      if (maxBones < bones.size()) {
+    if (_capabilities.floatVertexTextures ) return 1024;
 
-        //Skeleton has ' + bones.length + ' bones. This GPU supports ' + maxBones + '.' );
-        return 0;
-      }
-      return maxBones;
-    }
+    //CPU fallback is decided by the renderer if the skeleton doesn't fit
+    return (unsigned)std::min( bonePaletteSize(), skeleton->bones().size());
   }
 
   ProgramParameters::Ptr getParameters(const Renderer_impl &renderer,
@@ -86,7 +93,8 @@ public:
     return program;
   }
 
-  void releaseProgram(Program::Ptr program)
+  //drop the program from the cache if the caller holds the only other reference
+  void releaseProgram(const Program::Ptr &program)
   {
     if (program.use_count() == 2) {
 
@@ -34,6 +34,16 @@ struct MaterialProperties
   LightsHash lightsHash;
   size_t numClippingPlanes = 0;
   size_t numIntersection = 0;
+  bool quantizedPosition = false;
+  bool octNormal = false;
+
+  //programs built for the other vertex formats, indexed by formatIndex()
+  Program::Ptr formatPrograms[4];
+
+  static unsigned formatIndex(bool quantizedPosition, bool octNormal)
+  {
+    return (quantizedPosition ? 1 : 0) | (octNormal ? 2 : 0);
+  }
   ShaderID shaderID = ShaderID::undefined;
   three::Shader shader;
   std::vector<Uniform::Ptr> uniformsList;
@@ -41,67 +51,73 @@ struct MaterialProperties
 
 class Properties
 {
-  std::unordered_map<sole::uuid, GlProperties> glProperties;
+  SlotTable<GlProperties> glProperties;
 
-  std::unordered_map<sole::uuid, MaterialProperties> materialProperties;
+  SlotTable<MaterialProperties> materialProperties;
 
 public:
-  GlProperties &getGlProperties(const sole::uuid &uuid)
+  GlProperties &getGlProperties(const ResourceKey &key)
+  {
+    return glProperties[key];
+  }
+
+  //nullptr if there are no properties for key
+  GlProperties *findGlProperties(const ResourceKey &key)
   {
-    return glProperties[uuid];
+    return glProperties.find(key);
   }
 
-  MaterialProperties &getMaterialProperties(const sole::uuid &uuid)
+  MaterialProperties &getMaterialProperties(const ResourceKey &key)
   {
-    return materialProperties[uuid];
+    return materialProperties[key];
   }
 
   template<typename T, typename std::enable_if<!std::is_base_of<Material, T>{}, int>::type = 0>
   GlProperties &get(const T &tee)
   {
-    return getGlProperties(tee.uuid);
+    return getGlProperties(tee.resourceId);
   }
 
   template<typename T, typename std::enable_if<!std::is_base_of<Material, T>{}, int>::type = 0>
   GlProperties &get(const std::shared_ptr<T> tee)
   {
-    return getGlProperties(tee->uuid);
+    return getGlProperties(tee->resourceId);
   }
 
   template<typename T, typename std::enable_if<!std::is_base_of<Material, T>{}, int>::type = 0>
   void remove(const T &tee)
   {
-    glProperties.erase(tee.uuid);
+    glProperties.erase(tee.resourceId);
   }
 
   template<typename T, typename std::enable_if<!std::is_base_of<Material, T>{}, int>::type = 0>
   bool has(const T &tee)
   {
-    return glProperties.count(tee.uuid) > 0;
+    return glProperties.count(tee.resourceId) > 0;
   }
 
   template<typename T, typename std::enable_if<std::is_base_of<Material, T>{}, int>::type = 0>
   MaterialProperties &get(const T &material)
   {
-    return getMaterialProperties(material.uuid);
+    return getMaterialProperties(material.resourceId);
   }
 
   template<typename T, typename std::enable_if<std::is_base_of<Material, T>{}, int>::type = 0>
   MaterialProperties &get(const std::shared_ptr<T> material)
   {
-    return getMaterialProperties(material->uuid);
+    return getMaterialProperties(material->resourceId);
   }
 
   template<typename T, typename std::enable_if<std::is_base_of<Material, T>{}, int>::type = 0>
   void remove(const T &material)
   {
-    materialProperties.erase(material.uuid);
+    materialProperties.erase(material.resourceId);
   }
 
   template<typename T, typename std::enable_if<std::is_base_of<Material, T>{}, int>::type = 0>
   bool has(const T &material)
   {
-    return materialProperties.count(material.uuid) > 0;
+    return materialProperties.count(material.resourceId) > 0;
   }
 
   void clear()
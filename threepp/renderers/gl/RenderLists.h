@@ -16,7 +16,7 @@ namespace gl {
 
 struct RenderItem
 {
-  unsigned id;
+  uint64_t id;
   Object3D::Ptr object;
   BufferGeometry::Ptr geometry;
   Material::Ptr material;
@@ -27,7 +27,7 @@ struct RenderItem
 
   RenderItem(Object3D::Ptr object, BufferGeometry::Ptr geometry, Material::Ptr material, float z, const Group *group,
              Program::Ptr program=nullptr)
-     : object(object), geometry(geometry), material(material), program(program), renderOrder(object->renderOrder()),
+     : id(object->id()), object(object), geometry(geometry), material(material), program(program), renderOrder(object->renderOrder()),
        z(z), group(group)
   {}
 };
@@ -167,6 +167,24 @@ public:
 
   iterator transparent() const {return iterator(_transparent, _renderItems);}
 
+  /**
+   * remove the items for which predicate returns true
+   *
+   * @return the number of removed items
+   */
+  template <typename Predicate>
+  unsigned cull(Predicate predicate)
+  {
+    unsigned count = 0;
+    for(std::vector<size_t> *indizes : {&_opaque, &_transparent}) {
+      auto end = std::remove_if(indizes->begin(), indizes->end(),
+                                [&](size_t index) {return predicate(_renderItems[index]);});
+      count += (unsigned)(indizes->end() - end);
+      indizes->erase(end, indizes->end());
+    }
+    return count;
+  }
+
   RenderList &sort()
   {
     std::sort(_opaque.begin(), _opaque.end(), [this](size_t a, size_t b) {return painterSortStable(a, b);});
@@ -178,12 +196,24 @@ public:
 
 class RenderLists
 {
-  std::unordered_map<uint32_t, RenderList> _lists;
+  using Key = std::pair<uint64_t, uint64_t>;
+
+  struct KeyHash
+  {
+    size_t operator()(const Key &key) const
+    {
+      size_t hash = std::hash<uint64_t>()(key.first);
+      hash_combine(hash, key.second);
+      return hash;
+    }
+  };
+
+  std::unordered_map<Key, RenderList, KeyHash> _lists;
 
 public:
   RenderList *get(Scene::Ptr scene, Camera::Ptr camera)
   {
-    uint32_t key = (uint32_t)scene->id() << 16 | camera->id();
+    Key key(scene->id(), camera->id());
 
     if(_lists.count(key) == 0) {
       _lists.emplace(key, RenderList());
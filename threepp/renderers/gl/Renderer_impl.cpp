@@ -7,6 +7,7 @@
 #include <threepp/objects/Line.h>
 #include <threepp/objects/Points.h>
 #include <threepp/objects/ImmediateRenderObject.h>
+#include <threepp/objects/LOD.h>
 #include <threepp/material/MeshStandardMaterial.h>
 #include <threepp/material/MeshPhongMaterial.h>
 #include <threepp/material/MeshNormalMaterial.h>
@@ -75,16 +76,16 @@ Renderer_impl::Renderer_impl(size_t width, size_t height, float pixelRatio, bool
    : _state(this),
      _width(width),
      _height(height),
-     _attributes(this),
+     _attributes(this, _residency),
      _objects(_geometries, _infoRender),
-     _geometries(_attributes),
+     _geometries(_attributes, _infoMemory, _capabilities),
      _capabilities(this, _extensions, _parameters ),
-     _morphTargets(this),
+     _morphTargets(this, _capabilities),
      _shadowMap(*this, _objects, _capabilities),
      _programs(Programs::make(_extensions, _capabilities)),
      _premultipliedAlpha(premultipliedAlpha),
      _background(*this, _state, _geometries, premultipliedAlpha),
-     _textures(this, _extensions, _state, _properties, _capabilities, _infoMemory),
+     _textures(this, _extensions, _state, _properties, _capabilities, _infoMemory, _residency),
      _bufferRenderer(this, this, _extensions, _infoRender),
      _indexedBufferRenderer(this, this, _extensions, _infoRender),
      _spriteRenderer(*this, _state, _textures, _capabilities),
@@ -101,6 +102,7 @@ Renderer_impl::~Renderer_impl()
 
 void Renderer_impl::contextAboutToBeDestroyed()
 {
+  _pickingPass.dispose();
   _properties.clear();
   _programs->clear();
 }
@@ -190,9 +192,12 @@ void Renderer_impl::doRender(const Scene::Ptr &scene, const Camera::Ptr &camera,
 
   // reset caching for this frame
   _currentGeometryProgram = no_program;
-  _currentMaterialId = -1;
+  _currentMaterialId = 0;
   _currentCamera = nullptr;
 
+  // resources used from here on are protected from eviction
+  _residency.beginFrame();
+
   // update scene graph
   if (scene->autoUpdate()) scene->updateMatrixWorld(false);
 
@@ -208,6 +213,9 @@ void Renderer_impl::doRender(const Scene::Ptr &scene, const Camera::Ptr &camera,
   _spritesArray.clear();
   _flaresArray.clear();
 
+  _skeletons.clear();
+  _cpuSkinned.clear();
+
   _clippingEnabled = _clipping.init(_clippingPlanes, _localClippingEnabled, camera);
 
   _currentRenderList = _renderLists.get(scene, camera);
@@ -218,6 +226,10 @@ void Renderer_impl::doRender(const Scene::Ptr &scene, const Camera::Ptr &camera,
 
   projectObject(scene, camera, _sortObjects);
 
+  updateSkinning();
+
+  if (occlusionCulling) cullOccluded(camera);
+
   if (_sortObjects) {
     _currentRenderList->sort();
   }
@@ -256,9 +268,16 @@ void Renderer_impl::doRender(const Scene::Ptr &scene, const Camera::Ptr &camera,
   _spriteRenderer.render(_spritesArray, scene, camera);
   _flareRenderer.render(_flaresArray, scene, camera, _currentViewport);
 
+  // serve pending pick requests. Render-to-texture passes don't show the view the request refers to
+  if (!target || dynamic_pointer_cast<RenderTargetExternal>(renderTarget))
+    _pickingPass.render(*_currentRenderList, scene, camera, _currentViewport);
+
   // Generate mipmap if we're using any kind of mipmap filtering
   if (target)  _textures.updateRenderTargetMipmap(target);
 
+  // release least recently used resources if over budget
+  _residency.trim();
+
   // Ensure depth buffer writing is enabled so it can be cleared on next render
   _state.depthBuffer.setTest(true);
   _state.depthBuffer.setMask(true);
@@ -443,10 +462,39 @@ void Renderer_impl::prepareLights(Object3D::Ptr object, Camera::Ptr camera)
   }
 }
 
+void Renderer_impl::updateSkinning()
+{
+  if(_skeletons.empty()) return;
+
+  // skeletons may be shared between meshes
+  sort(_skeletons.begin(), _skeletons.end());
+  _skeletons.erase(unique(_skeletons.begin(), _skeletons.end()), _skeletons.end());
+
+  Skeleton::update(_skeletons);
+
+  for(SkinnedMesh *mesh : _cpuSkinned) {
+
+    mesh->applySkinning();
+
+    // geometry was already uploaded during projection
+    BufferGeometry::Ptr geometry = mesh->skinnedGeometry();
+    if(geometry) {
+      if(geometry->position()) _attributes.update(*geometry->position(), BufferType::Array);
+      if(geometry->normal()) _attributes.update(*geometry->normal(), BufferType::Array);
+    }
+  }
+}
+
 void Renderer_impl::projectObject(Object3D::Ptr object, Camera::Ptr camera, bool sortObjects )
 {
   if (!object->visible()) return;
 
+  // choose the level of detail before its children are visited. Shadows are rendered later
+  // and see the same level
+  if(LOD *lod = object->typer) {
+    if(lod->autoUpdate) lod->update(*camera);
+  }
+
   if (object->layers().test(camera->layers())) {
 
     if(Sprite *sprite = object->typer) {
@@ -470,7 +518,21 @@ void Renderer_impl::projectObject(Object3D::Ptr object, Camera::Ptr camera, bool
     else if(object->is<Mesh>() || object->is<Line>() || object->is<Points>()) {
 
       if(SkinnedMesh *skmesh = object->typer) {
-        skmesh->skeleton()->update();
+        // without bones there is nothing to skin
+        if(skmesh->skeleton() && !skmesh->skeleton()->bones().empty()) {
+          _skeletons.push_back(skmesh->skeleton().get());
+
+          // fall back to CPU skinning while the skeleton doesn't fit into the uniform bone palette.
+          // Decided every frame, so the mesh returns to the GPU once it fits
+          bool fallback = !skmesh->cpuSkinning && !_programs->fitsBonePalette(skmesh);
+          if(fallback != skmesh->cpuFallback()) {
+            skmesh->setCpuFallback(fallback);
+            for(size_t i = 0; i < skmesh->materialCount(); i++) skmesh->material(i)->needsUpdate = true;
+          }
+
+          if(skmesh->skinsOnCPU()) _cpuSkinned.push_back(skmesh);
+          else skmesh->releaseSkinnedGeometry();
+        }
       }
       if ( ! object->frustumCulled || _frustum.intersectsObject( *object ) ) {
 
@@ -508,6 +570,36 @@ void Renderer_impl::projectObject(Object3D::Ptr object, Camera::Ptr camera, bool
   }
 }
 
+void Renderer_impl::cullOccluded(const Camera::Ptr &camera)
+{
+  //keep the buffer's aspect close to the viewport's
+  unsigned width = _occlusion.width();
+  unsigned height = _width > 0 ? std::max((unsigned)(width * _height / _width), 16u) : width;
+  if(height != _occlusion.height()) _occlusion.setResolution(width, height);
+
+  _occlusion.begin(_projScreenMatrix, camera->matrixWorld().getPosition());
+
+  // occluders are taken from the opaque meshes which are drawn as a whole
+  for(auto it = _currentRenderList->opaque(); it; it++) {
+    const RenderItem &item = *it;
+
+    Mesh *mesh = item.object->typer;
+    if(!mesh || mesh->drawMode() != DrawMode::Triangles || item.object->skinned() || item.group) continue;
+
+    const Material::Ptr &material = item.material;
+    if(material->wireframe || !material->depthWrite || !material->colorWrite) continue;
+    if(material->morphTargets && item.geometry->useMorphing()) continue;
+
+    _occlusion.addOccluder(*item.object, *item.geometry, material->side);
+  }
+
+  _occlusion.rasterize();
+
+  _infoRender.occluded = _currentRenderList->cull([this](const RenderItem &item) {
+    return item.geometry && item.object->frustumCulled && _occlusion.occluded(*item.object, *item.geometry);
+  });
+}
+
 void Renderer_impl::renderObjectImmediate(ImmediateRenderObject &object, Program::Ptr program, Material::Ptr material)
 {
   renderBufferImmediate(object, program, material );
@@ -628,8 +720,9 @@ void Renderer_impl::renderBufferDirect(Camera::Ptr camera,
     updateBuffers = true;
   }
 
+  // the morph texture path only changes uniforms, leaving the attribute bindings intact
   Mesh *mesh = object->typer;
-  if ( mesh && !mesh->morphTargetInfluences().empty() ) {
+  if ( mesh && !mesh->morphTargetInfluences().empty() && !*program->parameters->morphTexture ) {
 
     _morphTargets.update( mesh, geometry, material, program );
 
@@ -637,12 +730,12 @@ void Renderer_impl::renderBufferDirect(Camera::Ptr camera,
   }
 
   BufferAttributeT<uint32_t>::Ptr index;
-  unsigned rangeFactor = 1;
+  EdgeIndex::Ptr wireframe;
   BufferRenderer *renderer;
 
   if ( material->wireframe ) {
-    index = _geometries.getWireframeAttribute( geometry );
-    rangeFactor = 2;
+    wireframe = _geometries.getWireframe( geometry );
+    index = wireframe->edges();
   }
   else {
     index = geometry->index();
@@ -666,29 +759,32 @@ void Renderer_impl::renderBufferDirect(Camera::Ptr camera,
   }
 
   //
+  //ranges refer to the triangles, wireframe ranges are mapped to the edges below
   size_t dataCount = 0;
 
-  if (index) {
+  if (geometry->index()) {
 
-    dataCount = index->size();
+    dataCount = geometry->index()->size();
   }
   else if (geometry->position()) {
 
     dataCount = geometry->position()->itemCount();
   }
 
-  size_t rangeStart = geometry->drawRange().start * rangeFactor;
+  size_t rangeStart = geometry->drawRange().start;
   size_t rangeCount = geometry->drawRange().count > 0 ?
-                      geometry->drawRange().count * rangeFactor : std::numeric_limits<size_t>::max();
+                      geometry->drawRange().count : std::numeric_limits<size_t>::max();
 
-  size_t groupStart = group ? group->start * rangeFactor : 0;
-  size_t groupCount = group ? group->count * rangeFactor : numeric_limits<size_t>::max();
+  size_t groupStart = group ? group->start : 0;
+  size_t groupCount = group ? group->count : numeric_limits<size_t>::max();
 
   size_t drawStart = std::max( rangeStart, groupStart );
   size_t drawEnd = std::min( dataCount, std::min(rangeStart + rangeCount, groupStart + groupCount)) - 1;
 
   size_t drawCount = std::max( (size_t)0, drawEnd - drawStart + 1 );
 
+  if ( wireframe ) wireframe->range( drawStart, drawCount, drawStart, drawCount );
+
   if ( drawCount == 0 ) return;
 
   if(mesh) {
@@ -762,6 +858,9 @@ void Renderer_impl::setupVertexAttributes(Material::Ptr material,
 
   auto &programAttributes = program->getAttributes();
 
+  //interleaved attributes share a buffer, which only needs to be bound once
+  GLuint boundBuffer = 0;
+
   for (const auto &att : programAttributes) {
 
     AttributeName name = att.first;
@@ -788,7 +887,7 @@ void Renderer_impl::setupVertexAttributes(Material::Ptr material,
 
         if(CAST(geometryAttribute, iba, InterleavedBufferAttribute)) {
 
-          auto &data = iba->buffer();
+          auto &data = *iba->buffer();
           GLsizei stride = (GLsizei) data.stride();
           GLsizei offset = (GLsizei) iba->offset();
 
@@ -808,7 +907,10 @@ void Renderer_impl::setupVertexAttributes(Material::Ptr material,
 
           //}
 
-          glBindBuffer(GL_ARRAY_BUFFER, buffer);
+          if(buffer != boundBuffer) {
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            boundBuffer = buffer;
+          }
           glVertexAttribPointer(programAttribute, size, type, normalized, stride * bytesPerElement,
                                 (void *) ((startIndex * stride + offset) * bytesPerElement));
           check_glerror(this);
@@ -831,6 +933,7 @@ void Renderer_impl::setupVertexAttributes(Material::Ptr material,
           //}
 
           glBindBuffer(GL_ARRAY_BUFFER, buffer);
+          boundBuffer = buffer;
           glVertexAttribPointer(programAttribute, size, type, normalized, 0, (void *) (startIndex * size * bytesPerElement));
           check_glerror(this);
         }
@@ -864,13 +967,23 @@ void Renderer_impl::setupVertexAttributes(Material::Ptr material,
 
 void Renderer_impl::releaseMaterialProgramReference(Material &material)
 {
-  auto programInfo = _properties.get( material ).program;
+  const Program::Ptr &programInfo = _properties.get( material ).program;
 
   if (programInfo) {
     _programs->releaseProgram( programInfo );
   }
 }
 
+void Renderer_impl::releaseFormatPrograms(MaterialProperties &materialProperties)
+{
+  for(Program::Ptr &program : materialProperties.formatPrograms) {
+    if(program) {
+      _programs->releaseProgram( program );
+      program.reset();
+    }
+  }
+}
+
 void Renderer_impl::initMaterial(Material::Ptr material, Fog::Ptr fog, Object3D::Ptr object)
 {
   MaterialProperties &materialProperties = _properties.get( *material );
@@ -884,6 +997,7 @@ void Renderer_impl::initMaterial(Material::Ptr material, Fog::Ptr fog, Object3D:
   if (!program) {
     // new material
     material->onDispose.connect([this](Material *material) {
+      releaseFormatPrograms(_properties.get( *material ));
       releaseMaterialProgramReference(*material);
       _properties.remove(*material);
     });
@@ -925,7 +1039,12 @@ void Renderer_impl::initMaterial(Material::Ptr material, Fog::Ptr fog, Object3D:
 
   const auto &programAttributes = program->getIndexedAttributes();
 
-  if ( material->morphTargets ) {
+  if ( material->morphTargets && *parameters->morphTexture ) {
+
+    // any number of targets, limited number of simultaneous influences
+    material->numSupportedMorphTargets = MorphTargets::maxInfluences;
+  }
+  else if ( material->morphTargets ) {
 
     material->numSupportedMorphTargets = 0;
 
@@ -962,6 +1081,10 @@ void Renderer_impl::initMaterial(Material::Ptr material, Fog::Ptr fog, Object3D:
 
   materialProperties.fog = fog;
 
+  const PackedAttributes *packed = packedAttributes(*object);
+  materialProperties.quantizedPosition = packed && packed->position;
+  materialProperties.octNormal = packed && packed->normal;
+
   // store the light setup it was created for
 
   materialProperties.lightsHash = _lights.state.hash;
@@ -1057,6 +1180,11 @@ Program::Ptr Renderer_impl::setProgram(Camera::Ptr camera, Fog::Ptr fog, Materia
     }
   }
 
+  const PackedAttributes *packed = packedAttributes(*object);
+  bool quantizedPosition = packed && packed->position;
+  bool octNormal = packed && packed->normal;
+  bool formatChange = false;
+
   if (!material->needsUpdate) {
 
     if (!materialProperties.program) {
@@ -1076,9 +1204,42 @@ Program::Ptr Renderer_impl::setProgram(Camera::Ptr camera, Fog::Ptr fog, Materia
           materialProperties.numIntersection != _clipping.numIntersection() ) ) {
 
       material->needsUpdate = true;
+
+    } else if ( materialProperties.quantizedPosition != quantizedPosition || materialProperties.octNormal != octNormal ) {
+
+      // the program decodes the vertex attribute formats of the geometry it was created for
+      formatChange = true;
     }
   }
 
+  if ( formatChange ) {
+
+    // materials shared by packed and unpacked geometries keep a program for each format, like the
+    // variants of the shadow and picking passes, so alternating geometries don't rebuild the program
+    unsigned current = MaterialProperties::formatIndex( materialProperties.quantizedPosition, materialProperties.octNormal );
+    unsigned wanted = MaterialProperties::formatIndex( quantizedPosition, octNormal );
+
+    materialProperties.formatPrograms[current] = materialProperties.program;
+    Program::Ptr variant = move( materialProperties.formatPrograms[wanted] );
+
+    if ( variant ) {
+
+      materialProperties.program = variant;
+      materialProperties.quantizedPosition = quantizedPosition;
+      materialProperties.octNormal = octNormal;
+      materialProperties.uniformsList = variant->getUniforms()->sequenceUniforms( materialProperties.shader.uniforms() );
+    }
+    else {
+
+      material->needsUpdate = true;
+    }
+  }
+  else if ( material->needsUpdate ) {
+
+    // the programs of the other formats were built for the previous state
+    releaseFormatPrograms( materialProperties );
+  }
+
   if ( material->needsUpdate ) {
 
     initMaterial( material, fog, object );
@@ -1165,47 +1326,35 @@ Program::Ptr Renderer_impl::setProgram(Camera::Ptr camera, Fog::Ptr fog, Materia
       prg_uniforms->set(UniformName::bindMatrix, skinned->bindMatrix());
       prg_uniforms->set(UniformName::bindMatrixInverse, skinned->bindMatrixInverse());
 
-      if (skinned->skeleton()) {
-
-        if (_capabilities.floatVertexTextures ) {
-
-          if (skinned->skeleton()->boneTexture()) {
-
-            // layout (1 matrix = 4 pixels)
-            //      RGBA RGBA RGBA RGBA (=> column1, column2, column3, column4)
-            //  with  8x8  pixel texture max   16 bones * 4 pixels =  (8 * 8)
-            //       16x16 pixel texture max   64 bones * 4 pixels = (16 * 16)
-            //       32x32 pixel texture max  256 bones * 4 pixels = (32 * 32)
-            //       64x64 pixel texture max 1024 bones * 4 pixels = (64 * 64)
-
+      if (skinned->skeleton() && !skinned->skinsOnCPU()) {
 
-            auto &bones = skinned->skeleton()->bones();
-            float size = sqrt( bones.size() * 4 ); // 4 pixels needed for 1 matrix
-            size = math::ceilPowerOfTwo( size );
-            size = max( size, 4.0f );
+        Skeleton &skeleton = *skinned->skeleton();
 
-            skinned->skeleton()->boneMatrices().resize(size * size * 4); // 4 floats per RGBA pixel
+        if (_capabilities.floatVertexTextures ) {
 
-            auto ops = DataTexture::options();
-            ops.format = TextureFormat::RGBA;
-            ops.type = TextureType::Float;
-            DataTexture::Ptr boneTexture = nullptr;//DataTexture::make(ops, skinned->skeleton()->boneMatrices(), size, size);
+          skeleton.createBoneTexture();
 
-            skinned->skeleton()->setBoneTexture(boneTexture);
-            skinned->skeleton()->setBoneTextureSize(size);
-          }
-
-          //TODO texture
-          //p_uniforms->get("boneTexture")->setValue(skinned->skeleton()->boneTexture() );
-          //p_uniforms->get("boneTextureSize")->setValue(skinned->skeleton()->boneTextureSize() );
+          Texture::Ptr boneTexture = skeleton.boneTexture();
+          prg_uniforms->set(UniformName::boneTexture, boneTexture);
+          prg_uniforms->set(UniformName::boneTextureSize, (GLint)skeleton.boneTextureSize());
 
         } else {
-          if(!skinned->skeleton()->boneMatrices().empty())
-            prg_uniforms->set(UniformName::boneMatrices, skinned->skeleton()->boneMatrices());
+          if(!skeleton.boneMatrices().empty())
+            prg_uniforms->set(UniformName::boneMatrices, skeleton.boneMatrices());
         }
       }
     }
   }
+
+  // likewise for the morph texture
+  if ( *program->parameters->morphTexture ) {
+
+    if(Mesh *mesh = object->typer) {
+
+      BufferGeometry::Ptr geometry = _geometries.get(object, object->geometry());
+      _morphTargets.setUniforms(mesh, *geometry, *prg_uniforms);
+    }
+  }
   if ( refreshMaterial ) {
 
     prg_uniforms->set(UniformName::toneMappingExposure, _toneMappingExposure );
@@ -1309,6 +1458,13 @@ Program::Ptr Renderer_impl::setProgram(Camera::Ptr camera, Fog::Ptr fog, Materia
   prg_uniforms->set(UniformName::modelViewMatrix, object->modelViewMatrix );
   prg_uniforms->set(UniformName::normalMatrix, object->normalMatrix );
   prg_uniforms->set(UniformName::modelMatrix, object->matrixWorld() );
+  prg_uniforms->set(UniformName::pickId, _pickId );
+
+  if ( quantizedPosition ) {
+
+    prg_uniforms->set(UniformName::positionOffset, packed->positionOffset );
+    prg_uniforms->set(UniformName::positionScale, packed->positionScale );
+  }
 
   check_glerror(this);
   return program;
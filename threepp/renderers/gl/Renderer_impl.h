@@ -28,6 +28,9 @@
 #include "MorphTargets.h"
 #include "Programs.h"
 #include "Background.h"
+#include "Residency.h"
+#include "PickingPass.h"
+#include "OcclusionCulling.h"
 
 #include <QOpenGLShaderProgram>
 
@@ -45,6 +48,7 @@ class Renderer_impl : public OpenGLRenderer, public QOpenGLExtraFunctions
   friend class Program;
   friend class RenderTargetExternal;
   friend class DeferredCalls;
+  friend class PickingPass;
 
   DeferredCalls *_deferredCalls;
 
@@ -59,6 +63,10 @@ protected:
   std::vector<Sprite::Ptr> _spritesArray;
   std::vector<LensFlare::Ptr> _flaresArray;
 
+  // skinning, collected during projection. Valid for the current render call
+  std::vector<Skeleton *> _skeletons;
+  std::vector<SkinnedMesh *> _cpuSkinned;
+
   // scene graph
   bool _sortObjects = true;
 
@@ -86,7 +94,7 @@ protected:
   // internal state cache
   Renderer::Target::Ptr _currentRenderTarget = nullptr;
   GLuint _currentFramebuffer = UINT_MAX;
-  int _currentMaterialId = -1;
+  uint64_t _currentMaterialId = 0;
 
   static const std::tuple<size_t, GLuint, bool> no_program;
   std::tuple<size_t, GLuint, bool> _currentGeometryProgram = no_program;
@@ -122,6 +130,8 @@ protected:
   MemoryInfo _infoMemory;
   RenderInfo _infoRender;
 
+  Residency _residency {_infoMemory};
+
   ShadowMap _shadowMap;
 
   Attributes _attributes;
@@ -159,6 +169,8 @@ protected:
   RenderLists _renderLists;
   RenderList *_currentRenderList = nullptr;
 
+  OcclusionCulling _occlusion;
+
   float getTargetPixelRatio()
   {
     return _currentRenderTarget ? _pixelRatio : 1;
@@ -204,6 +216,11 @@ protected:
   };
   ShadowImpl _shadow {_shadowMap};
 
+  //id written by the picking shader for the current draw
+  GLint _pickId = 0;
+
+  PickingPass _pickingPass {*this};
+
   void initContext() override;
 
   void initMaterial(Material::Ptr material, Fog::Ptr fog, Object3D::Ptr object);
@@ -212,6 +229,10 @@ protected:
 
   void projectObject(Object3D::Ptr object, Camera::Ptr camera, bool sortObjects );
 
+  void updateSkinning();
+
+  void cullOccluded(const Camera::Ptr &camera);
+
   void doRender(const Scene::Ptr &scene,
                 const Camera::Ptr &camera,
                 const Renderer::Target::Ptr &renderTarget,
@@ -229,6 +250,8 @@ protected:
 
   void releaseMaterialProgramReference(Material &material);
 
+  void releaseFormatPrograms(MaterialProperties &materialProperties);
+
   void renderObjectImmediate(ImmediateRenderObject &object, Program::Ptr program, Material::Ptr material);
 
   void renderBufferImmediate(ImmediateRenderObject &object, Program::Ptr program, Material::Ptr material);
@@ -282,6 +305,11 @@ public:
     return _shadow;
   }
 
+  Picking &picking() override
+  {
+    return _pickingPass;
+  }
+
   void setFaceCulling(CullFace cullFace ) override
   {
     _state.setCullFace(cullFace);
@@ -325,6 +353,10 @@ public:
   Renderer_impl &setViewport(size_t x, size_t y, size_t width, size_t height) override;
 
   void usePrograms(OpenGLRenderer::Ptr other) override;
+
+  const MemoryInfo &memoryInfo() const override {return _infoMemory;}
+
+  void setMemoryBudget(size_t bytes) override {_residency.setBudget(bytes);}
 };
 
 }
@@ -0,0 +1,170 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_RESIDENCY_H
+#define THREEPP_RESIDENCY_H
+
+#include <list>
+#include <functional>
+#include <unordered_map>
+#include <threepp/util/ResourceId.h>
+#include "Helpers.h"
+
+namespace three {
+namespace gl {
+
+/**
+ * keeps track of the GPU memory held by buffers and textures and enforces a memory budget. Resources
+ * are kept in least-recently-used order. If the budget is exceeded, resources which were not used during
+ * the current frame are evicted, least recently used first. Evicted resources are re-uploaded from their
+ * CPU-side data on next use.
+ */
+class Residency
+{
+public:
+  enum class Kind {Buffer, Texture};
+
+  //releases the GL resource. After the call, the owner must treat the resource as not uploaded
+  using Evictor = std::function<void()>;
+
+private:
+  struct Entry
+  {
+    ResourceKey key;
+    Kind kind;
+    size_t bytes;
+    unsigned frame;
+    Evictor evict;
+  };
+  using EntryList = std::list<Entry>;
+
+  //most recently used at the front
+  EntryList _lru;
+  std::unordered_map<ResourceKey, EntryList::iterator> _entries;
+
+  MemoryInfo &_info;
+  unsigned _frame = 0;
+
+  size_t &total(Kind kind) {
+    return kind == Kind::Buffer ? _info.bufferBytes : _info.textureBytes;
+  }
+
+  void evict(EntryList::iterator it)
+  {
+    Entry entry = std::move(*it);
+
+    total(entry.kind) -= entry.bytes;
+    _entries.erase(entry.key);
+    _lru.erase(it);
+
+    _info.evictions ++;
+    entry.evict();
+  }
+
+  //evict resources not used in this frame until the requested amount fits into the budget
+  void makeRoom(size_t bytes)
+  {
+    if(_info.budget == 0) return;
+
+    auto it = _lru.end();
+    while(it != _lru.begin() && _info.bufferBytes + _info.textureBytes + bytes > _info.budget) {
+      --it;
+      if(it->frame == _frame || !it->evict) continue;
+
+      auto victim = it++;
+      evict(victim);
+    }
+  }
+
+public:
+  Residency(MemoryInfo &info) : _info(info) {}
+
+  /**
+   * start a new frame. Resources used after this call are protected from eviction until the next frame
+   */
+  void beginFrame() {_frame ++;}
+
+  void setBudget(size_t bytes)
+  {
+    _info.budget = bytes;
+    makeRoom(0);
+  }
+
+  /**
+   * register a newly allocated resource, evicting others if required to stay within budget. Must be
+   * called before the resource is allocated
+   *
+   * @param evict releases the resource. If empty, the resource is accounted for but never evicted
+   */
+  void add(const ResourceKey &key, Kind kind, size_t bytes, const Evictor &evict)
+  {
+    remove(key);
+    makeRoom(bytes);
+
+    _lru.push_front(Entry {key, kind, bytes, _frame, evict});
+    _entries[key] = _lru.begin();
+    total(kind) += bytes;
+  }
+
+  /**
+   * mark a resource as used in the current frame
+   */
+  void touch(const ResourceKey &key)
+  {
+    auto found = _entries.find(key);
+    if(found == _entries.end()) return;
+
+    found->second->frame = _frame;
+    _lru.splice(_lru.begin(), _lru, found->second);
+  }
+
+  /**
+   * update the size of a resource after re-allocation
+   */
+  void resize(const ResourceKey &key, size_t bytes)
+  {
+    auto found = _entries.find(key);
+    if(found == _entries.end()) return;
+
+    Entry &entry = *found->second;
+    if(bytes > entry.bytes) makeRoom(bytes - entry.bytes);
+
+    total(entry.kind) += bytes;
+    total(entry.kind) -= entry.bytes;
+    entry.bytes = bytes;
+  }
+
+  /**
+   * stop tracking a resource which was released by its owner
+   */
+  void remove(const ResourceKey &key)
+  {
+    auto found = _entries.find(key);
+    if(found == _entries.end()) return;
+
+    total(found->second->kind) -= found->second->bytes;
+    _lru.erase(found->second);
+    _entries.erase(found);
+  }
+
+  /**
+   * enforce the budget. Called at the end of a frame
+   */
+  void trim() {makeRoom(0);}
+
+  /**
+   * evict everything that is evictable, regardless of budget
+   */
+  void evictAll()
+  {
+    for(auto it = _lru.begin(); it != _lru.end(); ) {
+      if(it->evict) evict(it++);
+      else ++it;
+    }
+  }
+};
+
+}
+}
+#endif //THREEPP_RESIDENCY_H
@@ -13,7 +13,8 @@ namespace gl {
 ShadowMap::ShadowMap(Renderer_impl &renderer, Objects &objects, Capabilities &capabilities)
 : _renderer(renderer), _objects(objects), _capabilities(capabilities)
 {
-  static constexpr uint16_t _NumberOfMaterialVariants = (Flag::Morphing | Flag::Skinning) + 1;
+  static constexpr uint16_t _NumberOfMaterialVariants =
+     (Flag::Morphing | Flag::Skinning | Flag::QuantizedPosition | Flag::OctNormal) + 1;
 
   for (size_t i = 0; i < _NumberOfMaterialVariants; ++ i ) {
 
@@ -217,6 +218,11 @@ Material::Ptr ShadowMap::getDepthMaterial(Object3D::Ptr object,
     if ( useMorphing ) variantIndex |= Flag::Morphing;
     if ( useSkinning ) variantIndex |= Flag::Skinning;
 
+    // one variant per vertex format, so programs are not rebuilt when formats alternate
+    const PackedAttributes *packed = packedAttributes(*object);
+    if ( packed && packed->position ) variantIndex |= Flag::QuantizedPosition;
+    if ( packed && packed->normal ) variantIndex |= Flag::OctNormal;
+
     std::vector<Material::Ptr> &materialVariants = isPointLight ? _distanceMaterials : _depthMaterials;
     result = materialVariants[ variantIndex ];
   }
@@ -231,12 +237,12 @@ Material::Ptr ShadowMap::getDepthMaterial(Object3D::Ptr object,
     // in this case we need a unique material instance reflecting the
     // appropriate state
 
-    const sole::uuid &keyA = result->uuid;
-    const sole::uuid &keyB = material->uuid;
+    const ResourceKey &keyA = result->resourceId;
+    const ResourceKey &keyB = material->resourceId;
 
     if (!_materialCache.count(keyA)) {
 
-      _materialCache.emplace(keyA, std::unordered_map<sole::uuid, Material::Ptr>());
+      _materialCache.emplace(keyA, std::unordered_map<ResourceKey, Material::Ptr>());
     }
     auto & materialsForVariant = _materialCache[ keyA ];
 
@@ -27,12 +27,12 @@ class ShadowMap
 {
   math::Frustum _frustum;
 
-  enum Flag : uint16_t {Morphing = 1, Skinning= 2};
+  enum Flag : uint16_t {Morphing = 1, Skinning= 2, QuantizedPosition = 4, OctNormal = 8};
 
   std::vector<Material::Ptr> _depthMaterials;
   std::vector<Material::Ptr> _distanceMaterials;
 
-  std::unordered_map<sole::uuid, std::unordered_map<sole::uuid, Material::Ptr>> _materialCache;
+  std::unordered_map<ResourceKey, std::unordered_map<ResourceKey, Material::Ptr>> _materialCache;
 
   math::Vector3 _cubeDirections[6] {
      math::Vector3(1, 0, 0), math::Vector3(-1, 0, 0), math::Vector3(0, 0, 1),
@@ -684,6 +684,18 @@ public:
     }
   }
 
+  /**
+   * forget the cached binding of a texture which is about to be deleted. Otherwise, a texture
+   * later created with the same (recycled) name would not be bound
+   */
+  void forgetTexture(GLuint webglTexture)
+  {
+    for(auto &bound : currentBoundTextures) {
+      //-2 never matches, forcing the next bind
+      if(bound.second.texture == (GLint)webglTexture) bound.second.texture = -2;
+    }
+  }
+
   void compressedTexImage2D(TextureTarget target, GLint level, TextureFormat internalFormat,
                             GLsizei width, GLsizei height, const std::vector<unsigned char> &data)
   {
@@ -691,6 +703,13 @@ public:
     check_glerror(_f);
   }
 
+  void compressedTexImage2D(TextureTarget target, GLint level, TextureFormat internalFormat, const Mipmap &mipmap)
+  {
+    _f->glCompressedTexImage2D((GLenum)target, level, (GLenum)internalFormat, mipmap.width, mipmap.height, 0,
+                               (GLsizei)mipmap.byteCount(), mipmap.bytes());
+    check_glerror(_f);
+  }
+
   void texImage2D(TextureTarget target,
                   GLint level,
                   TextureFormat internalFormat,
@@ -749,7 +768,21 @@ public:
                   const Mipmap &mipmap)
   {
     _f->glTexImage2D((GLenum)target, level, (GLint)internalFormat,
-                 mipmap.width, mipmap.height, 0, (GLenum)format, (GLenum)type, mipmap.data.data());
+                 mipmap.width, mipmap.height, 0, (GLenum)format, (GLenum)type, mipmap.bytes());
+    check_glerror(_f);
+  }
+
+  void texSubImage2D(TextureTarget target,
+                     GLint level,
+                     GLint xoffset,
+                     GLint yoffset,
+                     GLsizei width,
+                     GLsizei height,
+                     TextureFormat format,
+                     TextureType type,
+                     const unsigned char *pixels)
+  {
+    _f->glTexSubImage2D((GLenum)target, level, xoffset, yoffset, width, height, (GLenum)format, (GLenum)type, pixels);
     check_glerror(_f);
   }
 
@@ -16,6 +16,79 @@ bool needsGenerateMipmaps(const Texture &texture)
          && texture.minFilter != TextureFilter ::Linear;
 }
 
+size_t texelBytes(TextureFormat format, TextureType type)
+{
+  switch(type) {
+    case TextureType::UnsignedShort4444:
+    case TextureType::UnsignedShort5551:
+    case TextureType::UnsignedShort565:
+      return 2;
+    case TextureType::UnsignedInt248:
+      return 4;
+    default:
+      break;
+  }
+
+  size_t channels;
+  switch(format) {
+    case TextureFormat::Alpha:
+    case TextureFormat::Luminance:
+    case TextureFormat::Depth:
+    case TextureFormat::DepthComponent:
+    case TextureFormat::DepthComponent16:
+    case TextureFormat::DepthComponent32:
+      channels = 1;
+      break;
+#ifdef GL_LUMINANCE4_ALPHA4
+    case TextureFormat::LuminanceAlpha:
+      channels = 2;
+      break;
+#endif
+    case TextureFormat::RGB:
+#ifdef GL_BGR
+    case TextureFormat::BGR:
+#endif
+      channels = 3;
+      break;
+    default:
+      channels = 4;
+  }
+
+  switch(type) {
+    case TextureType::Byte:
+    case TextureType::UnsignedByte:
+      return channels;
+    case TextureType::Short:
+    case TextureType::UnsignedShort:
+    case TextureType::HalfFloat:
+    case TextureType::HalfFloatOES:
+      return channels * 2;
+    default:
+      return channels * 4;
+  }
+}
+
+/**
+ * estimated GPU memory for one texture image. A generated mipmap chain adds a third
+ */
+size_t imageBytes(const Texture &texture, size_t width, size_t height)
+{
+  size_t bytes = width * height * texelBytes(texture.format(), texture.type());
+  return needsGenerateMipmaps(texture) ? bytes * 4 / 3 : bytes;
+}
+
+/**
+ * GPU memory for an explicit mipmap chain
+ */
+size_t mipmapBytes(const Texture &texture, const std::vector<Mipmap> &mipmaps, bool compressed)
+{
+  size_t bytes = 0;
+  for(const Mipmap &mipmap : mipmaps) {
+    bytes += compressed ? mipmap.byteCount() : mipmap.width * mipmap.height * texelBytes(texture.format(), texture.type());
+  }
+  return bytes;
+}
+
 void Textures::onRenderTargetDispose(RenderTargetInternal &renderTarget)
 {
   deallocateRenderTarget( renderTarget );
@@ -33,30 +106,62 @@ void Textures::onRenderTargetDispose(RenderTargetCube &renderTarget)
 void Textures::onTextureDispose(Texture &texture)
 {
   deallocateTexture( texture );
+}
+
+bool Textures::releaseTexture(GlProperties &textureProperties)
+{
+  GLuint handle;
+  if(textureProperties.image_textureCube.isSet()) {
+    // cube texture
+    handle = textureProperties.image_textureCube;
+    textureProperties.image_textureCube.reset();
+  }
+  else if(textureProperties.texture.isSet()) {
+    // 2D texture
+    handle = textureProperties.texture;
+    textureProperties.texture.reset();
+  }
+  else return false;
+
+  _state.forgetTexture(handle);
+  _fn->glDeleteTextures(1, &handle);
 
   _infoMemory.textures --;
+  return true;
 }
 
 void Textures::deallocateTexture(Texture &texture)
 {
   if(_properties.has(texture)) {
 
-    auto &textureProperties = _properties.get( texture );
-    if(textureProperties.image_textureCube.isSet()) {
-      // cube texture
-      _fn->glDeleteTextures(1, &textureProperties.image_textureCube.get());
-    }
-    else if(textureProperties.webglInit) {
-      // 2D texture
-      _fn->glDeleteTextures(1, &textureProperties.texture.get());
-    }
-    else return;
+    if(!releaseTexture(_properties.get( texture ))) return;
+
+    _residency.remove(texture.resourceId);
 
     // remove all webgl properties
     _properties.remove( texture );
   }
 }
 
+void Textures::trackTexture(const Texture &texture, size_t bytes, bool evictable)
+{
+  ResourceKey key = texture.resourceId;
+  if(!evictable) {
+    _residency.add(key, Residency::Kind::Texture, bytes, Residency::Evictor());
+    return;
+  }
+
+  //the texture's CPU-side data stays available, so it can be uploaded again after eviction
+  _residency.add(key, Residency::Kind::Texture, bytes, [this, key]() {
+    GlProperties *textureProperties = _properties.findGlProperties(key);
+    if(!textureProperties) return;
+    releaseTexture(*textureProperties);
+
+    //force upload on next use
+    textureProperties->version = 0u;
+  });
+}
+
 void Textures::deallocateRenderTarget(RenderTargetInternal &renderTarget)
 {
   if (_properties.has(*renderTarget.texture())) {
@@ -67,6 +172,7 @@ void Textures::deallocateRenderTarget(RenderTargetInternal &renderTarget)
   }
 
   renderTarget.dispose();
+  _residency.remove(renderTarget.texture()->resourceId);
 
   _fn->glDeleteFramebuffers(1, &renderTarget.frameBuffer);
 
@@ -85,6 +191,7 @@ void Textures::deallocateRenderTarget(RenderTargetCube &renderTarget)
   }
 
   renderTarget.dispose();
+  _residency.remove(renderTarget.texture()->resourceId);
 
   _fn->glDeleteFramebuffers(6, renderTarget.frameBuffers.data());
 
@@ -103,6 +210,8 @@ void Textures::setTexture2D(Texture::Ptr texture, unsigned slot)
     uploadTexture( textureProperties, texture, slot );
     return;
   }
+  _residency.touch(texture->resourceId);
+
   _state.activeTexture(GL_TEXTURE0 + slot );
   _state.bindTexture(TextureTarget::twoD, textureProperties.texture);
 }
@@ -121,7 +230,10 @@ void Textures::setTextureCube(Texture::Ptr texture, unsigned slot)
       GLuint webglTextureCube;
       if (!textureProperties.image_textureCube.isSet()) {
 
-        texture.onDispose.connect(this, &Textures::onTextureDispose);
+        if(!textureProperties.webglInit) {
+          textureProperties.webglInit = true;
+          texture.onDispose.connect(this, &Textures::onTextureDispose);
+        }
 
         _fn->glGenTextures(1, &webglTextureCube);
         textureProperties.image_textureCube = webglTextureCube;
@@ -139,9 +251,11 @@ void Textures::setTextureCube(Texture::Ptr texture, unsigned slot)
     if(DataCubeTexture *dctex = texture->typer) {
       baseFunc(*dctex);
 
+      size_t bytes = 0;
       for (unsigned i = 0; i < 6; i ++) {
 
         const TextureData &data = dctex->data(i);
+        bytes += dctex->compressed() ? mipmapBytes(*dctex, data.mipmaps(), true) : imageBytes(*dctex, data.width(), data.height());
 
         if(!dctex->compressed()) {
 
@@ -157,7 +271,7 @@ void Textures::setTextureCube(Texture::Ptr texture, unsigned slot)
 
               if ( _state.hasCompressedTextureFormat(extFormat) ) {
 
-                _state.compressedTexImage2D(TextureTarget::cubeMapPositiveX + i, j, extFormat, mipmap.width, mipmap.height, mipmap.data );
+                _state.compressedTexImage2D(TextureTarget::cubeMapPositiveX + i, j, extFormat, mipmap );
               }
               else {
                 throw std::invalid_argument("setTextureCube: unsupported compressed texture format");
@@ -165,22 +279,26 @@ void Textures::setTextureCube(Texture::Ptr texture, unsigned slot)
             }
             else {
               _state.texImage2D(TextureTarget::cubeMapPositiveX + i, j, extFormat, mipmap.width, mipmap.height,
-                                extFormat, extType, mipmap.data.data() );
+                                extFormat, extType, mipmap.bytes() );
             }
 
           }
         }
       }
+      trackTexture(*dctex, bytes);
     }
     else if(ImageCubeTexture *ictex = texture->typer) {
       baseFunc(*ictex);
 
+      size_t bytes = 0;
       for (unsigned i = 0; i < CubeTexture::num_faces; i ++ ) {
         QImage cubeImage = clampToMaxSize( ictex->image(i), _capabilities.maxCubemapSize, ictex->flipY );
 
         _state.texImage2D(TextureTarget::cubeMapPositiveX+i, 0, extFormat,
                           cubeImage.width(), cubeImage.height(), extFormat, extType, cubeImage);
+        bytes += imageBytes(*ictex, cubeImage.width(), cubeImage.height());
       }
+      trackTexture(*ictex, bytes);
     }
 
     if ( needsGenerateMipmaps(*texture) ) {
@@ -193,6 +311,8 @@ void Textures::setTextureCube(Texture::Ptr texture, unsigned slot)
     texture->onUpdate.emitSignal( *texture );
 
   } else {
+    _residency.touch(texture->resourceId);
+
     _state.activeTexture(GL_TEXTURE0 + slot );
     _state.bindTexture(TextureTarget::cubeMap, textureProperties.image_textureCube);
   }
@@ -250,16 +370,20 @@ void Textures::setTextureParameters(TextureTarget textureTarget, Texture &textur
 
 void Textures::uploadTexture(GlProperties &textureProperties, Texture::Ptr texture, unsigned slot )
 {
+  //the GL texture holds a previous version of the data
+  bool resident = textureProperties.texture.isSet();
+
   if (!textureProperties.webglInit) {
 
     textureProperties.webglInit = true;
 
     texture->onDispose.connect([this](Texture &t) {
       deallocateTexture( t );
-
-      _infoMemory.textures --;
     });
+  }
+  if (!textureProperties.texture.isSet()) {
 
+    //first upload, or re-upload after eviction
     GLuint tex;
     _fn->glGenTextures(1, &tex);
     textureProperties.texture = tex;
@@ -320,6 +444,9 @@ void Textures::uploadTexture(GlProperties &textureProperties, Texture::Ptr textu
     }
 
     _state.texImage2D(TextureTarget::twoD, 0, internalFormat, dtex->width(), dtex->height(), dtex->format(), dtex->type());
+
+    //no CPU-side data to restore from
+    trackTexture(*dtex, imageBytes(*dtex, dtex->width(), dtex->height()), false);
   }
   else if(DataTexture *dtex = texture->typer) {
 
@@ -330,10 +457,10 @@ void Textures::uploadTexture(GlProperties &textureProperties, Texture::Ptr textu
 
         if ( dtex->format() != TextureFormat::RGBA && dtex->format() != TextureFormat::RGB) {
 
-          const auto &formats = _state.getCompressedTextureFormats();
-          if (std::find(formats.cbegin(), formats.cend(), (GLint)dtex->format()) != formats.cend()) {
+          TextureFormat extFormat = _extensions.extend(dtex->format());
+          if (extFormat != TextureFormat::Undefined && _state.hasCompressedTextureFormat(extFormat)) {
 
-            _state.compressedTexImage2D(TextureTarget::twoD, i, dtex->format(), mipmap.width, mipmap.height, mipmap.data);
+            _state.compressedTexImage2D(TextureTarget::twoD, i, extFormat, mipmap);
           }
           else {
             throw std::invalid_argument("uploadTexture: unsupported compressed texture format");
@@ -341,9 +468,10 @@ void Textures::uploadTexture(GlProperties &textureProperties, Texture::Ptr textu
 
         } else {
           _state.texImage2D(TextureTarget::twoD, i, dtex->format(), mipmap.width, mipmap.height, dtex->format(),
-                            dtex->type(), mipmap.data.data() );
+                            dtex->type(), mipmap.bytes() );
         }
       }
+      trackTexture(*dtex, mipmapBytes(*dtex, dtex->mipmaps(), true));
     }
     else {
       // use manually created mipmaps if available
@@ -356,16 +484,35 @@ void Textures::uploadTexture(GlProperties &textureProperties, Texture::Ptr textu
 
           const Mipmap &mipmap = dtex->mipmaps()[ i ];
           _state.texImage2D(TextureTarget::twoD, i, dtex->format(),
-                            mipmap.width, mipmap.height, dtex->format(), dtex->type(), mipmap.data.data() );
+                            mipmap.width, mipmap.height, dtex->format(), dtex->type(), mipmap.bytes() );
         }
 
         dtex->setGenerateMipmaps(false);
+        trackTexture(*dtex, mipmapBytes(*dtex, dtex->mipmaps(), false));
       }
       else {
-        _state.texImage2D(TextureTarget::twoD, 0, dtex->format(),
-                          dtex->width(), dtex->height(), dtex->format(), dtex->type(), dtex->bytes());
+        const UpdateRange &range = dtex->updateRange();
+
+        if(resident && range.count > 0 && range.count != std::numeric_limits<size_t>::max()) {
+          //only upload the modified rows
+          size_t rowBytes = dtex->width() * texelBytes(dtex->format(), dtex->type());
+
+          _state.texSubImage2D(TextureTarget::twoD, 0, 0, range.start, dtex->width(), range.count,
+                               dtex->format(), dtex->type(), dtex->bytes() + range.start * rowBytes);
+          _residency.touch(dtex->resourceId);
+        }
+        else {
+          // float data needs a sized internal format to be stored unclamped, where available
+          TextureFormat internalFormat = dtex->type() == TextureType::Float && dtex->format() == TextureFormat::RGBA
+                                         && _capabilities.floatFragmentTextures ? TextureFormat::RGBA32F : dtex->format();
+
+          _state.texImage2D(TextureTarget::twoD, 0, internalFormat,
+                            dtex->width(), dtex->height(), dtex->format(), dtex->type(), dtex->bytes());
+          trackTexture(*dtex, imageBytes(*dtex, dtex->width(), dtex->height()));
+        }
       }
     }
+    dtex->updateRange() = UpdateRange(0, 0);
   }
   else if(ImageTexture *itex = texture->typer) {
     // regular Texture (image, video, canvas)
@@ -394,9 +541,11 @@ void Textures::uploadTexture(GlProperties &textureProperties, Texture::Ptr textu
       }
 
       itex->setGenerateMipmaps(false);
+      trackTexture(*itex, mipmapBytes(*itex, itex->mipmaps(), false));
     }
     else {
       _state.texImage2D(TextureTarget::twoD, 0, itex->format(), itex->format(), itex->type(), image );
+      trackTexture(*itex, imageBytes(*itex, image.width(), image.height()));
     }
   }
 
@@ -522,6 +671,7 @@ void Textures::setupRenderTarget(RenderTargetInternal &renderTarget)
   textureProperties.texture = tex;
 
   _infoMemory.textures ++;
+  trackTexture(*renderTarget.texture(), imageBytes(*renderTarget.texture(), renderTarget.width(), renderTarget.height()), false);
 
   // Setup framebuffer
   _fn->glGenFramebuffers(1, &renderTarget.frameBuffer);
@@ -554,6 +704,8 @@ void Textures::setupRenderTarget(RenderTargetCube &renderTarget)
   textureProperties.texture = tex;
 
   _infoMemory.textures ++;
+  trackTexture(*renderTarget.texture(),
+               imageBytes(*renderTarget.texture(), renderTarget.width(), renderTarget.height()) * CubeTexture::num_faces, false);
 
   // Setup framebuffer
   renderTarget.frameBuffers.resize(6);
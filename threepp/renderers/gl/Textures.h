@@ -14,6 +14,7 @@
 #include "Properties.h"
 #include "Capabilities.h"
 #include "Helpers.h"
+#include "Residency.h"
 
 namespace three {
 namespace gl {
@@ -26,6 +27,7 @@ class Textures
   Properties &_properties;
   Capabilities &_capabilities;
   MemoryInfo &_infoMemory;
+  Residency &_residency;
 
   GLuint _defaultFBO = 0;
 
@@ -38,11 +40,14 @@ class Textures
   void setupDepthRenderbuffer(RenderTargetInternal &renderTarget);
   void setupDepthRenderbuffer(RenderTargetCube &renderTarget);
 
+  bool releaseTexture(GlProperties &textureProperties);
+  void trackTexture(const Texture &texture, size_t bytes, bool evictable=true);
+
 public:
   Textures(QOpenGLExtraFunctions * fn, Extensions &extensions, State &state, Properties &properties,
-     Capabilities &capabilities, MemoryInfo &infoMemory)
+     Capabilities &capabilities, MemoryInfo &infoMemory, Residency &residency)
   : _fn(fn), _extensions(extensions), _state(state), _properties(properties), _capabilities(capabilities),
-    _infoMemory(infoMemory)
+    _infoMemory(infoMemory), _residency(residency)
   {}
 
   QImage clampToMaxSize(const QImage &image, int maxSize, bool flipY )
@@ -80,8 +80,17 @@ UniformName get(string name, bool isIndex)
      MATCH_NAME(modelMatrix),
      MATCH_NAME(logDepthBufFC),
      MATCH_NAME(boneMatrices),
+     MATCH_NAME(boneTexture),
+     MATCH_NAME(boneTextureSize),
      MATCH_NAME(bindMatrix),
      MATCH_NAME(bindMatrixInverse),
+     MATCH_NAME(morphTargetInfluences),
+     MATCH_NAME(morphTexture),
+     MATCH_NAME(morphTextureWidth),
+     MATCH_NAME(morphTextureStride),
+     MATCH_NAME(morphVertexCount),
+     MATCH_NAME(morphInfluences),
+     MATCH_NAME(morphInfluenceCount),
      MATCH_NAME(toneMappingExposure),
      MATCH_NAME(toneMappingWhitePoint),
      MATCH_NAME(cameraPosition),
@@ -153,7 +162,10 @@ UniformName get(string name, bool isIndex)
      MATCH_NAME(halfWidth),
      MATCH_NAME(coneCos),
      MATCH_NAME(penumbraCos),
-     MATCH_NAME(decay)
+     MATCH_NAME(decay),
+     MATCH_NAME(pickId),
+     MATCH_NAME(positionOffset),
+     MATCH_NAME(positionScale)
   };
   if (isIndex) {
     unsigned index = atoi(name.c_str());
@@ -287,7 +299,26 @@ void Uniform::setValue(const std::vector<math::Matrix4> &matrices)
 
 void Uniform::setValue(const std::vector<float> &vector)
 {
-  _renderer.glUniform1fv(_addr, vector.size(), vector.data());
+  switch(_type) {
+    case UniformType::FloatMat4:
+      _renderer.glUniformMatrix4fv(_addr, vector.size() / 16, GL_FALSE, vector.data());
+      break;
+    case UniformType::FloatMat3:
+      _renderer.glUniformMatrix3fv(_addr, vector.size() / 9, GL_FALSE, vector.data());
+      break;
+    case UniformType::FloatVec4:
+      _renderer.glUniform4fv(_addr, vector.size() / 4, vector.data());
+      break;
+    case UniformType::FloatVec3:
+      _renderer.glUniform3fv(_addr, vector.size() / 3, vector.data());
+      break;
+    case UniformType::FloatVect2:
+      _renderer.glUniform2fv(_addr, vector.size() / 2, vector.data());
+      break;
+    default:
+      _renderer.glUniform1fv(_addr, vector.size(), vector.data());
+      break;
+  }
   check_glerror(&_renderer);
 }
 
@@ -76,8 +76,17 @@ enum class UniformName : unsigned
   modelMatrix,
   logDepthBufFC,
   boneMatrices,
+  boneTexture,
+  boneTextureSize,
   bindMatrix,
   bindMatrixInverse,
+  morphTargetInfluences,
+  morphTexture,
+  morphTextureWidth,
+  morphTextureStride,
+  morphVertexCount,
+  morphInfluences,
+  morphInfluenceCount,
   toneMappingExposure,
   toneMappingWhitePoint,
   cameraPosition,
@@ -149,7 +158,10 @@ enum class UniformName : unsigned
   halfWidth,
   coneCos,
   penumbraCos,
-  decay
+  decay,
+  pickId,
+  positionOffset,
+  positionScale
 };
 
 namespace uniformname {
@@ -1,8 +1,24 @@
 #ifdef USE_MORPHNORMALS
 
+	#ifdef USE_MORPHTEXTURE
+
+	if ( morphTextureStride > 1 ) {
+
+		for ( int i = 0; i < morphInfluenceCount; i ++ ) {
+
+			objectNormal += getMorph( int( morphInfluences[ i ].x ), 1 ) * morphInfluences[ i ].y;
+
+		}
+
+	}
+
+	#else
+
 	objectNormal += ( morphNormal0 - normal ) * morphTargetInfluences[ 0 ];
 	objectNormal += ( morphNormal1 - normal ) * morphTargetInfluences[ 1 ];
 	objectNormal += ( morphNormal2 - normal ) * morphTargetInfluences[ 2 ];
 	objectNormal += ( morphNormal3 - normal ) * morphTargetInfluences[ 3 ];
 
+	#endif
+
 #endif
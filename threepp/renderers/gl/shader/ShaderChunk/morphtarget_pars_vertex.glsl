@@ -1,6 +1,28 @@
 #ifdef USE_MORPHTARGETS
 
-	#ifndef USE_MORPHNORMALS
+	#ifdef USE_MORPHTEXTURE
+
+	// all targets of the geometry, stored as deltas from the base geometry. Each vertex of a target
+	// occupies morphTextureStride texels: position delta, followed by the normal delta if present
+
+	uniform sampler2D morphTexture;
+	uniform int morphTextureWidth;
+	uniform int morphTextureStride;
+	uniform int morphVertexCount;
+
+	// active influences: x = target index, y = weight
+
+	uniform int morphInfluenceCount;
+	uniform vec2 morphInfluences[ MAX_MORPH_INFLUENCES ];
+
+	vec3 getMorph( const in int target, const in int offset ) {
+
+		int texel = ( target * morphVertexCount + gl_VertexID ) * morphTextureStride + offset;
+		return texelFetch( morphTexture, ivec2( texel % morphTextureWidth, texel / morphTextureWidth ), 0 ).xyz;
+
+	}
+
+	#elif ! defined( USE_MORPHNORMALS )
 
 	uniform float morphTargetInfluences[ 8 ];
 
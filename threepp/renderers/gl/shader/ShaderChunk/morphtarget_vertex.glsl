@@ -1,5 +1,15 @@
 #ifdef USE_MORPHTARGETS
 
+	#ifdef USE_MORPHTEXTURE
+
+	for ( int i = 0; i < morphInfluenceCount; i ++ ) {
+
+		transformed += getMorph( int( morphInfluences[ i ].x ), 0 ) * morphInfluences[ i ].y;
+
+	}
+
+	#else
+
 	transformed += ( morphTarget0 - position ) * morphTargetInfluences[ 0 ];
 	transformed += ( morphTarget1 - position ) * morphTargetInfluences[ 1 ];
 	transformed += ( morphTarget2 - position ) * morphTargetInfluences[ 2 ];
@@ -14,4 +24,6 @@
 
 	#endif
 
+	#endif
+
 #endif
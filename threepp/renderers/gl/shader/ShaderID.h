@@ -26,6 +26,7 @@ enum class ShaderID : unsigned
   distanceRGBA=10,
   shadow=11,
   physical=12,
+  pick=13,
 
   undefined=999
 };
@@ -282,6 +282,12 @@ public:
            ":shader/shadow_vert.glsl",
            ":shader/shadow_frag.glsl"
         ));
+    add(ShaderID::pick,
+        LibShader(
+           {},
+           ":shader/pick_vert.glsl",
+           ":shader/pick_frag.glsl"
+        ));
   }
 
   LibShader &operator[](ShaderID id)
@@ -328,7 +334,8 @@ ShaderID toShaderID(std::string name)
      MATCH_NAME(equirect),
      MATCH_NAME(distanceRGBA),
      MATCH_NAME(shadow),
-     MATCH_NAME(physical)
+     MATCH_NAME(physical),
+     MATCH_NAME(pick)
   };
   try {
     return string_to_id.at(name);
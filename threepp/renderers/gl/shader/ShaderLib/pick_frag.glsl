@@ -0,0 +1,18 @@
+#include <common>
+#include <logdepthbuf_pars_fragment>
+
+flat in uint vPickId;
+
+out vec4 fragColor;
+
+void main() {
+
+	#include <logdepthbuf_fragment>
+
+	fragColor = vec4(
+		float( vPickId & 255u ),
+		float( ( vPickId >> 8 ) & 255u ),
+		float( ( vPickId >> 16 ) & 255u ),
+		float( ( vPickId >> 24 ) & 255u ) ) / 255.0;
+
+}
@@ -0,0 +1,21 @@
+#include <common>
+#include <morphtarget_pars_vertex>
+#include <skinning_pars_vertex>
+#include <logdepthbuf_pars_vertex>
+
+uniform int pickId;
+
+flat out uint vPickId;
+
+void main() {
+
+	#include <skinbase_vertex>
+	#include <begin_vertex>
+	#include <morphtarget_vertex>
+	#include <skinning_vertex>
+	#include <project_vertex>
+	#include <logdepthbuf_vertex>
+
+	vPickId = uint( pickId ) + uint( gl_InstanceID );
+
+}
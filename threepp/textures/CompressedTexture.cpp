@@ -0,0 +1,324 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "CompressedTexture.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QByteArray>
+#include <cstring>
+
+namespace three {
+
+using namespace std;
+
+struct MappedTextureData::Mapping
+{
+  QFile file;
+  const byte *data = nullptr;
+  size_t size = 0;
+
+  //used if the file cannot be mapped (e.g. compressed Qt resources)
+  QByteArray buffer;
+
+  //the file must stay open, closing it would unmap the data
+  Mapping(const string &path) : file(QString::fromStdString(path)) {}
+};
+
+shared_ptr<const MappedTextureData::Mapping> MappedTextureData::map(const std::string &path)
+{
+  shared_ptr<Mapping> mapping = make_shared<Mapping>(path);
+
+  if(!mapping->file.open(QIODevice::ReadOnly))
+    throw invalid_argument("unable to open texture file " + path);
+
+  mapping->size = (size_t)mapping->file.size();
+  mapping->data = mapping->file.map(0, mapping->file.size());
+
+  if(!mapping->data) {
+    mapping->buffer = mapping->file.readAll();
+    mapping->data = (const byte *)mapping->buffer.constData();
+    mapping->size = (size_t)mapping->buffer.size();
+    mapping->file.close();
+  }
+
+  return mapping;
+}
+
+void MappedTextureData::addMipmap(int width, int height, size_t offset, size_t size)
+{
+  if(offset + size > _mapping->size)
+    throw invalid_argument("texture file truncated");
+
+  _mipmaps.emplace_back(width, height, _mapping->data + offset, size);
+}
+
+namespace {
+
+inline uint32_t read32(const byte *data, size_t offset, bool swap=false)
+{
+  uint32_t value;
+  memcpy(&value, data + offset, sizeof(value));
+
+  if(swap) {
+    value = (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+  }
+  return value;
+}
+
+inline size_t align4(size_t value)
+{
+  return (value + 3) & ~(size_t)3;
+}
+
+const byte ktxIdentifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+const uint32_t ktxEndianness = 0x04030201;
+const size_t ktxHeaderSize = 64;
+
+const uint32_t ddsMagic = 0x20534444; //"DDS "
+const size_t ddsHeaderSize = 128;     //magic + DDS_HEADER
+
+const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+const uint32_t DDPF_ALPHAPIXELS = 0x1;
+const uint32_t DDPF_FOURCC = 0x4;
+const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+const uint32_t DDSCAPS2_CUBEMAP_ALLFACES = 0xFC00;
+
+inline constexpr uint32_t fourCC(const char *cc)
+{
+  return (uint32_t)cc[0] | ((uint32_t)cc[1] << 8) | ((uint32_t)cc[2] << 16) | ((uint32_t)cc[3] << 24);
+}
+
+//a mipmapped texture needs the full chain, otherwise it's incomplete and samples black
+void adjustFilters(TextureOptions &options, size_t levels)
+{
+  if(levels > 1) return;
+
+  if(options.minFilter != TextureFilter::Nearest && options.minFilter != TextureFilter::Linear)
+    options.minFilter = TextureFilter::Linear;
+}
+
+}
+
+Texture::Ptr CompressedTexture::load(const std::string &path, TextureOptions options)
+{
+  shared_ptr<const Mapping> mapping = MappedTextureData::map(path);
+
+  if(mapping->size >= ktxHeaderSize && memcmp(mapping->data, ktxIdentifier, sizeof(ktxIdentifier)) == 0)
+    return loadKTX(mapping, options);
+
+  if(mapping->size >= ddsHeaderSize && read32(mapping->data, 0) == ddsMagic)
+    return loadDDS(mapping, options);
+
+  throw invalid_argument("unknown texture container format: " + path);
+}
+
+Texture::Ptr CompressedTexture::loadKTX(const std::shared_ptr<const Mapping> &mapping, TextureOptions options)
+{
+  const byte *data = mapping->data;
+
+  uint32_t endianness = read32(data, 12);
+  if(endianness != ktxEndianness && read32(data, 12, true) != ktxEndianness)
+    throw invalid_argument("KTX: invalid endianness field");
+
+  bool swap = endianness != ktxEndianness;
+
+  uint32_t glType = read32(data, 16, swap);
+  uint32_t glInternalFormat = read32(data, 28, swap);
+  uint32_t width = read32(data, 36, swap);
+  uint32_t height = read32(data, 40, swap);
+  uint32_t depth = read32(data, 44, swap);
+  uint32_t arrayElements = read32(data, 48, swap);
+  uint32_t faces = read32(data, 52, swap);
+  uint32_t levels = max(read32(data, 56, swap), 1u);
+  uint32_t keyValueBytes = read32(data, 60, swap);
+
+  if(width == 0 || height == 0 || depth > 0 || arrayElements > 0)
+    throw invalid_argument("KTX: only 2D and cubemap textures are supported");
+  if(faces != 1 && faces != CubeTexture::num_faces)
+    throw invalid_argument("KTX: invalid number of faces");
+
+  bool compressed = glType == 0;
+  if(compressed) {
+    switch((TextureFormat)glInternalFormat) {
+      case TextureFormat::RGB_S3TC_DXT1:
+      case TextureFormat::RGBA_S3TC_DXT1:
+      case TextureFormat::RGBA_S3TC_DXT3:
+      case TextureFormat::RGBA_S3TC_DXT5:
+      case TextureFormat::RGB_ETC1:
+      case TextureFormat::RGB_ETC2:
+      case TextureFormat::RGBA_ETC2_EAC:
+        options.format = (TextureFormat)glInternalFormat;
+        break;
+      default:
+        throw invalid_argument("KTX: unsupported compressed format");
+    }
+  }
+  else {
+    if(glType != GL_UNSIGNED_BYTE)
+      throw invalid_argument("KTX: unsupported pixel type");
+
+    switch(glInternalFormat) {
+      case GL_RGB:
+      case 0x8051: //GL_RGB8
+        options.format = TextureFormat::RGB;
+        break;
+      case GL_RGBA:
+      case 0x8058: //GL_RGBA8
+        options.format = TextureFormat::RGBA;
+        break;
+      default:
+        throw invalid_argument("KTX: unsupported pixel format");
+    }
+  }
+  options.type = TextureType::UnsignedByte;
+  adjustFilters(options, levels);
+
+  array<MappedTextureData::Ptr, CubeTexture::num_faces> datas;
+  for(unsigned face = 0; face < faces; face++)
+    datas[face] = MappedTextureData::make(mapping, width, height);
+
+  size_t offset = ktxHeaderSize + keyValueBytes;
+
+  for(uint32_t level = 0; level < levels; level++) {
+
+    if(offset + 4 > mapping->size) throw invalid_argument("KTX: file truncated");
+
+    size_t imageSize = read32(data, offset, swap);
+    offset += 4;
+
+    int levelWidth = max(width >> level, 1u);
+    int levelHeight = max(height >> level, 1u);
+
+    for(unsigned face = 0; face < faces; face++) {
+      datas[face]->addMipmap(levelWidth, levelHeight, offset, imageSize);
+      offset += align4(imageSize);
+    }
+  }
+
+  if(faces == 1)
+    return DataTexture::make(options, datas[0], compressed);
+
+  array<TextureData::Ptr, CubeTexture::num_faces> faceDatas;
+  std::copy(datas.begin(), datas.end(), faceDatas.begin());
+  DataCubeTexture::Ptr cubeTexture = DataCubeTexture::make(options, faceDatas, width, height, compressed);
+  cubeTexture->needsUpdate();
+  return cubeTexture;
+}
+
+Texture::Ptr CompressedTexture::loadDDS(const std::shared_ptr<const Mapping> &mapping, TextureOptions options)
+{
+  const byte *data = mapping->data;
+
+  uint32_t flags = read32(data, 8);
+  uint32_t height = read32(data, 12);
+  uint32_t width = read32(data, 16);
+  uint32_t levels = (flags & DDSD_MIPMAPCOUNT) ? max(read32(data, 28), 1u) : 1;
+  uint32_t pfFlags = read32(data, 80);
+  uint32_t pfFourCC = read32(data, 84);
+  uint32_t caps2 = read32(data, 112);
+
+  if(width == 0 || height == 0)
+    throw invalid_argument("DDS: invalid dimensions");
+
+  if(!(pfFlags & DDPF_FOURCC))
+    throw invalid_argument("DDS: only DXT compressed textures are supported");
+
+  size_t blockBytes;
+  if(pfFourCC == fourCC("DXT1")) {
+    blockBytes = 8;
+    options.format = (pfFlags & DDPF_ALPHAPIXELS) ? TextureFormat::RGBA_S3TC_DXT1 : TextureFormat::RGB_S3TC_DXT1;
+  }
+  else if(pfFourCC == fourCC("DXT3")) {
+    blockBytes = 16;
+    options.format = TextureFormat::RGBA_S3TC_DXT3;
+  }
+  else if(pfFourCC == fourCC("DXT5")) {
+    blockBytes = 16;
+    options.format = TextureFormat::RGBA_S3TC_DXT5;
+  }
+  else
+    throw invalid_argument("DDS: unsupported fourCC format");
+
+  bool cube = (caps2 & DDSCAPS2_CUBEMAP) != 0;
+  if(cube && (caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES)
+    throw invalid_argument("DDS: incomplete cubemap");
+
+  options.type = TextureType::UnsignedByte;
+  adjustFilters(options, levels);
+
+  unsigned faces = cube ? static_cast<unsigned>(CubeTexture::num_faces) : 1;
+  array<MappedTextureData::Ptr, CubeTexture::num_faces> datas;
+
+  //DDS stores the full mip chain for each face consecutively
+  size_t offset = ddsHeaderSize;
+  for(unsigned face = 0; face < faces; face++) {
+
+    datas[face] = MappedTextureData::make(mapping, width, height);
+
+    for(uint32_t level = 0; level < levels; level++) {
+      int levelWidth = max(width >> level, 1u);
+      int levelHeight = max(height >> level, 1u);
+
+      size_t size = max((levelWidth + 3) / 4, 1) * max((levelHeight + 3) / 4, 1) * blockBytes;
+
+      datas[face]->addMipmap(levelWidth, levelHeight, offset, size);
+      offset += size;
+    }
+  }
+
+  if(!cube)
+    return DataTexture::make(options, datas[0], true);
+
+  array<TextureData::Ptr, CubeTexture::num_faces> faceDatas;
+  std::copy(datas.begin(), datas.end(), faceDatas.begin());
+  DataCubeTexture::Ptr cubeTexture = DataCubeTexture::make(options, faceDatas, width, height, true);
+  cubeTexture->needsUpdate();
+  return cubeTexture;
+}
+
+void CompressedTexture::saveKTX(const std::string &path, TextureFormat format, const std::vector<Mipmap> &mipmaps)
+{
+  if(mipmaps.empty())
+    throw invalid_argument("KTX: no image data");
+
+  uint32_t glFormat, glInternalFormat;
+  switch(format) {
+    case TextureFormat::RGB:
+      glFormat = GL_RGB;
+      glInternalFormat = 0x8051; //GL_RGB8
+      break;
+    case TextureFormat::RGBA:
+      glFormat = GL_RGBA;
+      glInternalFormat = 0x8058; //GL_RGBA8
+      break;
+    default:
+      throw invalid_argument("KTX: unsupported format for writing");
+  }
+
+  uint32_t header[13] = {
+     ktxEndianness, GL_UNSIGNED_BYTE, 1, glFormat, glInternalFormat, glFormat,
+     (uint32_t)mipmaps[0].width, (uint32_t)mipmaps[0].height, 0, 0, 1, (uint32_t)mipmaps.size(), 0
+  };
+
+  QSaveFile file(QString::fromStdString(path));
+  if(!file.open(QIODevice::WriteOnly))
+    throw invalid_argument("unable to write texture file " + path);
+
+  file.write((const char *)ktxIdentifier, sizeof(ktxIdentifier));
+  file.write((const char *)header, sizeof(header));
+
+  const char padding[4] = {0, 0, 0, 0};
+  for(const Mipmap &mipmap : mipmaps) {
+    uint32_t imageSize = (uint32_t)mipmap.byteCount();
+    file.write((const char *)&imageSize, sizeof(imageSize));
+    file.write((const char *)mipmap.bytes(), imageSize);
+    file.write(padding, align4(imageSize) - imageSize);
+  }
+
+  if(!file.commit())
+    throw invalid_argument("unable to write texture file " + path);
+}
+
+}
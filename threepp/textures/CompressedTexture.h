@@ -0,0 +1,93 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_COMPRESSEDTEXTURE_H
+#define THREEPP_COMPRESSEDTEXTURE_H
+
+#include "DataTexture.h"
+
+namespace three {
+
+/**
+ * texture data backed by a memory-mapped file. Mipmaps point directly into the mapped
+ * region, which stays valid as long as any data object created from the same file is alive
+ */
+class DLX MappedTextureData : public TextureData
+{
+  friend class CompressedTexture;
+
+public:
+  struct Mapping;
+
+private:
+  std::shared_ptr<const Mapping> _mapping;
+
+  MappedTextureData(const std::shared_ptr<const Mapping> &mapping, size_t width, size_t height)
+     : TextureData(width, height), _mapping(mapping) {}
+
+  void addMipmap(int width, int height, size_t offset, size_t size);
+
+public:
+  using Ptr = std::shared_ptr<MappedTextureData>;
+
+  /**
+   * map the given file into memory
+   *
+   * @throws std::invalid_argument if the file cannot be opened
+   */
+  static std::shared_ptr<const Mapping> map(const std::string &path);
+
+  static Ptr make(const std::shared_ptr<const Mapping> &mapping, size_t width, size_t height) {
+    return Ptr(new MappedTextureData(mapping, width, height));
+  }
+
+  const byte *bytes() const override {
+    return _mipmaps.empty() ? nullptr : _mipmaps.front().bytes();
+  }
+};
+
+/**
+ * loader for GPU-compressed texture containers (KTX 1.1 and DDS). Prebuilt mipmap chains are
+ * uploaded as stored, without decoding or copying the pixel data. Whether the format is supported
+ * by the GL implementation is checked by the renderer at upload time
+ */
+class DLX CompressedTexture
+{
+  using Mapping = MappedTextureData::Mapping;
+
+  static Texture::Ptr loadKTX(const std::shared_ptr<const Mapping> &mapping, TextureOptions options);
+  static Texture::Ptr loadDDS(const std::shared_ptr<const Mapping> &mapping, TextureOptions options);
+
+public:
+  static TextureOptions options()
+  {
+    TextureOptions options = DataTexture::options();
+    options.minFilter = TextureFilter::LinearMipMapLinear;
+    options.magFilter = TextureFilter::Linear;
+    options.flipY = false;
+    return options;
+  }
+
+  /**
+   * load a texture file. The container type is determined from the file header.
+   *
+   * @param path the file path, may be a Qt resource path
+   * @param options texture options. format and type will be set from the file contents
+   * @return a DataTexture or, for cubemap files, a DataCubeTexture
+   * @throws std::invalid_argument if the file can't be read or uses an unsupported format
+   */
+  static Texture::Ptr load(const std::string &path, TextureOptions options=CompressedTexture::options());
+
+  /**
+   * write an uncompressed 8 bit per channel mipmap chain as KTX 1.1 file. The file is written atomically
+   *
+   * @param format RGB or RGBA. Rows must be 4 byte aligned
+   * @throws std::invalid_argument if the format is not supported or the file can't be written
+   */
+  static void saveKTX(const std::string &path, TextureFormat format, const std::vector<Mipmap> &mipmaps);
+};
+
+}
+
+#endif //THREEPP_COMPRESSEDTEXTURE_H
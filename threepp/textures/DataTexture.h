@@ -22,6 +22,9 @@ protected:
   size_t const _width, _height;
   bool _compressed;
 
+  //rows to upload on the next update. count==max means the whole texture
+  UpdateRange _updateRange;
+
   DataTexture(const TextureOptions &options, const TextureData::Ptr data, size_t width, size_t height, bool compressed=false)
      : Texture(options, texture::Typer(this), false, 1), _data(data), _width(width), _height(height), _compressed(compressed)
   {
@@ -68,6 +71,17 @@ public:
     }
   }
 
+  /**
+   * create a texture from prepared data, using the data's mipmap chain as-is. Only the Mipmap
+   * entries are copied, pixel data stays with (and is kept alive by) the TextureData object
+   */
+  static Ptr make(const TextureOptions &options, const TextureData::Ptr &data, bool compressed)
+  {
+    Ptr p(new DataTexture(options, data, data->width(), data->height(), compressed));
+    p->_mipmaps = data->mipmaps();
+    return p;
+  }
+
   bool compressed() const {return _compressed;}
   size_t width() const {return _width;}
   size_t height() const {return _height;}
@@ -76,6 +90,34 @@ public:
   bool isPowerOfTwo() const override {
     return math::isPowerOfTwo(_width) && math::isPowerOfTwo(_height);
   }
+
+  /**
+   * schedule upload of the whole texture
+   */
+  void needsUpdate()
+  {
+    _updateRange = UpdateRange();
+    Texture::needsUpdate();
+  }
+
+  /**
+   * schedule upload of the rows [firstRow, firstRow + rowCount). Ranges accumulate until the next
+   * upload. If the texture is not resident on the GPU, it is uploaded as a whole
+   */
+  void needsUpdate(size_t firstRow, size_t rowCount)
+  {
+    if(_updateRange.count == 0) {
+      _updateRange = UpdateRange(firstRow, rowCount);
+    }
+    else if(_updateRange.count != std::numeric_limits<size_t>::max()) {
+      size_t end = std::max(_updateRange.start + _updateRange.count, firstRow + rowCount);
+      _updateRange.start = std::min(_updateRange.start, firstRow);
+      _updateRange.count = end - _updateRange.start;
+    }
+    Texture::needsUpdate();
+  }
+
+  UpdateRange &updateRange() {return _updateRange;}
 };
 
 /**
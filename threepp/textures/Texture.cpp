@@ -11,8 +11,7 @@ Texture::Texture(const TextureOptions &options, const texture::Typer &typer,
    : TextureOptions(options),
      typer(typer),
      _generateMipmaps(generateMipMaps),
-     _unpackAlignment(unpackAlignment),
-     uuid(sole::uuid1())
+     _unpackAlignment(unpackAlignment)
 {
 }
 
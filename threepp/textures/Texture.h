@@ -13,7 +13,7 @@
 #include <threepp/util/osdecl.h>
 #include <threepp/Constants.h>
 #include <threepp/util/simplesignal.h>
-#include <threepp/util/sole.h>
+#include <threepp/util/ResourceId.h>
 #include <threepp/util/Resolver.h>
 #include <threepp/util/Types.h>
 
@@ -89,7 +89,7 @@ public:
 
   texture::Typer typer;
 
-  const sole::uuid uuid;
+  const ResourceId resourceId;
   Signal<void(Texture &)> onDispose;
   Signal<void(Texture &)> onUpdate;
 
@@ -0,0 +1,214 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "TexturePreprocessor.h"
+#include <QFile>
+#include <QDir>
+#include <QCryptographicHash>
+#include <cstring>
+#include <threepp/math/Math.h>
+#include <threepp/util/Parallel.h>
+
+namespace three {
+
+using namespace std;
+
+namespace {
+
+/**
+ * texture data which owns a generated mipmap chain
+ */
+class MipmapChainData : public TextureData
+{
+  std::vector<std::vector<byte>> _levels;
+
+public:
+  MipmapChainData(std::vector<Mipmap> &&mipmaps)
+     : TextureData(mipmaps.front().width, mipmaps.front().height)
+  {
+    _levels.reserve(mipmaps.size());
+    for(Mipmap &mipmap : mipmaps) {
+      _levels.push_back(std::move(mipmap.data));
+      _mipmaps.emplace_back(mipmap.width, mipmap.height, _levels.back().data(), _levels.back().size());
+    }
+  }
+
+  const byte *bytes() const override {
+    return _levels.front().data();
+  }
+};
+
+//rows per work item. Levels smaller than this are processed on the calling thread
+const size_t rowGrain = 32;
+
+/**
+ * 2x2 box filter, RGBA8888. Odd source dimensions clamp to the last row/column. The inner loop
+ * works on plain byte arrays so that the compiler can vectorize it
+ */
+void downsample(const Mipmap &src, Mipmap &dst)
+{
+  const size_t srcStride = (size_t)src.width * 4;
+  const size_t dstStride = (size_t)dst.width * 4;
+  const bool singleColumn = src.width == 1;
+
+  const byte *srcData = src.data.data();
+  byte *dstData = dst.data.data();
+
+  parallel::for_each(0, (size_t)dst.height, [&](size_t begin, size_t end) {
+
+    for(size_t y = begin; y < end; y++) {
+      size_t y0 = std::min<size_t>(y * 2, src.height - 1);
+      size_t y1 = std::min<size_t>(y * 2 + 1, src.height - 1);
+
+      const byte *row0 = srcData + y0 * srcStride;
+      const byte *row1 = srcData + y1 * srcStride;
+      byte *out = dstData + y * dstStride;
+
+      if(singleColumn) {
+        for(size_t c = 0; c < 4; c++)
+          out[c] = (byte)((row0[c] + row1[c] + 1) >> 1);
+        continue;
+      }
+
+      for(size_t x = 0; x < dstStride; x += 4) {
+        size_t s0 = x * 2;
+        size_t s1 = std::min(s0 + 4, srcStride - 4);
+
+        for(size_t c = 0; c < 4; c++) {
+          out[x + c] = (byte)((row0[s0 + c] + row0[s1 + c] + row1[s0 + c] + row1[s1 + c] + 2) >> 2);
+        }
+      }
+    }
+  }, rowGrain);
+}
+
+}
+
+std::vector<Mipmap> TexturePreprocessor::generateMipmaps(const QImage &image)
+{
+  QImage rgba = image.format() == QImage::Format_RGBA8888 || image.format() == QImage::Format_RGBA8888_Premultiplied ?
+                image : image.convertToFormat(QImage::Format_RGBA8888);
+
+  if(rgba.isNull())
+    throw invalid_argument("generateMipmaps: invalid image");
+
+  std::vector<Mipmap> chain;
+
+  Mipmap level0;
+  level0.width = rgba.width();
+  level0.height = rgba.height();
+  level0.data.resize((size_t)level0.width * level0.height * 4);
+
+  for(int y = 0; y < rgba.height(); y++) {
+    memcpy(level0.data.data() + (size_t)y * level0.width * 4, rgba.constScanLine(y), (size_t)level0.width * 4);
+  }
+  chain.push_back(std::move(level0));
+
+  while(chain.back().width > 1 || chain.back().height > 1) {
+    Mipmap next;
+    next.width = std::max(chain.back().width / 2, 1);
+    next.height = std::max(chain.back().height / 2, 1);
+    next.data.resize((size_t)next.width * next.height * 4);
+
+    downsample(chain.back(), next);
+    chain.push_back(std::move(next));
+  }
+
+  return chain;
+}
+
+std::vector<Mipmap> TexturePreprocessor::prepare(QImage image) const
+{
+  if(_settings.flipY) image = image.mirrored();
+
+  image = image.convertToFormat(_settings.premultiplyAlpha ?
+                                QImage::Format_RGBA8888_Premultiplied : QImage::Format_RGBA8888);
+
+  if(_settings.maxSize > 0 && ((unsigned)image.width() > _settings.maxSize || (unsigned)image.height() > _settings.maxSize)) {
+    image = image.scaled(_settings.maxSize, _settings.maxSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+  }
+
+  if(_settings.powerOfTwo && !(math::isPowerOfTwo(image.width()) && math::isPowerOfTwo(image.height()))) {
+    image = image.scaled(math::nearestPowerOfTwo(image.width()), math::nearestPowerOfTwo(image.height()),
+                         Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+  }
+
+  return generateMipmaps(image);
+}
+
+std::string TexturePreprocessor::cacheFile(const QByteArray &source) const
+{
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(source);
+
+  char flags[] = {
+     _settings.flipY ? 'f' : '-',
+     _settings.premultiplyAlpha ? 'p' : '-',
+     _settings.powerOfTwo ? 'o' : '-'
+  };
+  hash.addData(flags, sizeof(flags));
+  hash.addData(QByteArray::number(_settings.maxSize));
+
+  QString name = QString::fromLatin1(hash.result().toHex()) + ".ktx";
+  return QDir(QString::fromStdString(_cacheDir)).filePath(name).toStdString();
+}
+
+Texture::Ptr TexturePreprocessor::load(const std::string &path, const TextureOptions &options) const
+{
+  QFile file(QString::fromStdString(path));
+  if(!file.open(QIODevice::ReadOnly))
+    throw invalid_argument("unable to open image file " + path);
+
+  QByteArray source = file.readAll();
+  file.close();
+
+  //the chain is already flipped by prepare(), cached or not
+  TextureOptions opts = options;
+  opts.format = TextureFormat::RGBA;
+  opts.type = TextureType::UnsignedByte;
+  opts.flipY = false;
+
+  std::string cached;
+  if(!_cacheDir.empty()) {
+    cached = cacheFile(source);
+    if(QFile::exists(QString::fromStdString(cached))) {
+      try {
+        return CompressedTexture::load(cached, opts);
+      }
+      catch(std::invalid_argument &) {
+        //unreadable cache entry, regenerate below
+      }
+    }
+  }
+
+  QImage image = QImage::fromData(source);
+  if(image.isNull())
+    throw invalid_argument("unable to decode image file " + path);
+
+  std::vector<Mipmap> mipmaps = prepare(image);
+
+  if(!cached.empty()) {
+    QDir().mkpath(QString::fromStdString(_cacheDir));
+    try {
+      CompressedTexture::saveKTX(cached, TextureFormat::RGBA, mipmaps);
+    }
+    catch(std::invalid_argument &) {
+      //the cache is an optimization only, use the chain in memory
+      QFile::remove(QString::fromStdString(cached));
+    }
+  }
+
+  return DataTexture::make(opts, std::make_shared<MipmapChainData>(std::move(mipmaps)), false);
+}
+
+std::future<Texture::Ptr> TexturePreprocessor::loadAsync(const std::string &path, const TextureOptions &options) const
+{
+  TexturePreprocessor preprocessor(*this);
+
+  return std::async(std::launch::async, [preprocessor, path, options]() {
+    return preprocessor.load(path, options);
+  });
+}
+
+}
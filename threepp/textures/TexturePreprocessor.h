@@ -0,0 +1,77 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_TEXTUREPREPROCESSOR_H
+#define THREEPP_TEXTUREPREPROCESSOR_H
+
+#include <future>
+#include "CompressedTexture.h"
+
+namespace three {
+
+/**
+ * prepares image textures off the render thread: converts to RGBA, applies flipping, premultiplied
+ * alpha and power-of-two scaling, and generates the full mipmap chain on the CPU using all cores.
+ * If a cache directory is set, the result is stored there as KTX file keyed by a hash of the
+ * source file contents and the processing settings. Subsequent loads memory-map the cached file
+ * and upload the chain directly.
+ */
+class DLX TexturePreprocessor
+{
+public:
+  struct Settings
+  {
+    bool flipY = true;
+    bool premultiplyAlpha = false;
+    bool powerOfTwo = true;
+
+    //if > 0, downscale images larger than this
+    unsigned maxSize = 0;
+  };
+
+private:
+  std::string _cacheDir;
+  Settings _settings;
+
+  std::string cacheFile(const QByteArray &source) const;
+
+public:
+  TexturePreprocessor(const std::string &cacheDir=std::string(), const Settings &settings=Settings())
+     : _cacheDir(cacheDir), _settings(settings) {}
+
+  static TextureOptions options()
+  {
+    TextureOptions options = CompressedTexture::options();
+    options.format = TextureFormat::RGBA;
+    return options;
+  }
+
+  /**
+   * compute the full mipmap chain for an image using a 2x2 box filter. The chain is
+   * tightly packed RGBA8888, level 0 is the (converted) image itself
+   */
+  static std::vector<Mipmap> generateMipmaps(const QImage &image);
+
+  /**
+   * apply the settings to an image and compute its mipmap chain
+   */
+  std::vector<Mipmap> prepare(QImage image) const;
+
+  /**
+   * load an image file, using or populating the cache
+   *
+   * @throws std::invalid_argument if the file can't be read
+   */
+  Texture::Ptr load(const std::string &path, const TextureOptions &options=TexturePreprocessor::options()) const;
+
+  /**
+   * load in a worker thread. The returned texture is ready for upload by the renderer
+   */
+  std::future<Texture::Ptr> loadAsync(const std::string &path,
+                                      const TextureOptions &options=TexturePreprocessor::options()) const;
+};
+
+}
+
+#endif //THREEPP_TEXTUREPREPROCESSOR_H
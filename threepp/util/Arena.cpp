@@ -0,0 +1,104 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "Arena.h"
+#include <mutex>
+
+namespace three {
+
+namespace {
+
+//classes up to and including minBlock, then four per power of two up to maxBlock
+const unsigned numClasses = 1 + 4 * 10;
+
+struct FreeBlock
+{
+  FreeBlock *next;
+};
+
+struct Pool
+{
+  std::mutex mutex;
+  FreeBlock *free[numClasses] = {};
+
+  char *chunk = nullptr;
+  size_t chunkUsed = Arena::chunkSize;
+};
+
+//never destroyed, attribute data may be released during static destruction
+Pool &pool()
+{
+  static Pool *pool = new Pool();
+  return *pool;
+}
+
+/**
+ * @return the size class index for the given size, and the class size in blockSize
+ */
+unsigned sizeClass(size_t bytes, size_t &blockSize)
+{
+  if(bytes <= Arena::minBlock) {
+    blockSize = Arena::minBlock;
+    return 0;
+  }
+
+  //2^log < bytes <= 2^(log + 1)
+  unsigned log = 6;
+  while((size_t(1) << (log + 1)) < bytes) log++;
+
+  size_t step = size_t(1) << (log - 2);
+  blockSize = (bytes + step - 1) & ~(step - 1);
+
+  return 1 + (log - 6) * 4 + (unsigned)(blockSize / step - 5);
+}
+
+}
+
+void *Arena::allocate(size_t bytes)
+{
+  if(bytes > maxBlock) return ::operator new(bytes);
+
+  size_t blockSize;
+  unsigned index = sizeClass(bytes, blockSize);
+
+  Pool &p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+
+  if(p.free[index]) {
+    FreeBlock *block = p.free[index];
+    p.free[index] = block->next;
+    return block;
+  }
+
+  if(p.chunkUsed + blockSize > chunkSize) {
+    //the remainder of the previous chunk is left unused
+    p.chunk = static_cast<char *>(::operator new(chunkSize));
+    p.chunkUsed = 0;
+  }
+  void *block = p.chunk + p.chunkUsed;
+  p.chunkUsed += blockSize;
+  return block;
+}
+
+void Arena::deallocate(void *block, size_t bytes)
+{
+  if(!block) return;
+
+  if(bytes > maxBlock) {
+    ::operator delete(block);
+    return;
+  }
+
+  size_t blockSize;
+  unsigned index = sizeClass(bytes, blockSize);
+
+  Pool &p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+
+  FreeBlock *free = static_cast<FreeBlock *>(block);
+  free->next = p.free[index];
+  p.free[index] = free;
+}
+
+}
@@ -0,0 +1,63 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_ARENA_H
+#define THREEPP_ARENA_H
+
+#include <cstddef>
+#include <new>
+#include "osdecl.h"
+
+namespace three {
+
+/**
+ * allocator for vertex attribute data. Blocks are carved from large chunks and recycled through free
+ * lists, one per size class, so creating many attributes does not mean one heap allocation each. There
+ * are four size classes per power of two, so at most a fifth of a block is unused. Requests beyond
+ * maxBlock go to the heap. Recycled memory is kept for reuse, it is not returned to the system. Thread safe
+ */
+class DLX Arena
+{
+public:
+  static const size_t minBlock = 64;
+  static const size_t maxBlock = 64 * 1024;
+  static const size_t chunkSize = 1024 * 1024;
+
+  static void *allocate(size_t bytes);
+
+  //bytes must be the size passed to allocate
+  static void deallocate(void *block, size_t bytes);
+};
+
+/**
+ * standard allocator on top of Arena
+ */
+template <typename T>
+struct ArenaAllocator
+{
+  using value_type = T;
+
+  ArenaAllocator() = default;
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(Arena::allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T *p, size_t n) {
+    Arena::deallocate(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator ==(const ArenaAllocator<U> &) const {return true;}
+
+  template <typename U>
+  bool operator !=(const ArenaAllocator<U> &) const {return false;}
+};
+
+}
+
+#endif //THREEPP_ARENA_H
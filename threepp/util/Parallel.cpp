@@ -0,0 +1,120 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "Parallel.h"
+#include <deque>
+
+namespace three {
+namespace parallel {
+
+namespace {
+
+//0 if not set
+std::atomic<unsigned> threadCount {0};
+
+class Pool
+{
+  std::mutex _mutex;
+  std::condition_variable _wake;
+
+  //a job is queued once for each worker it may use
+  std::deque<std::shared_ptr<detail::Job>> _jobs;
+
+  std::vector<std::thread> _threads;
+
+  void run()
+  {
+    for(;;) {
+      std::shared_ptr<detail::Job> job;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _wake.wait(lock, [this]() {return !_jobs.empty();});
+
+        job = _jobs.front();
+        _jobs.pop_front();
+      }
+      job->work();
+    }
+  }
+
+public:
+  Pool()
+  {
+    for(unsigned i = 1; i < hardwareConcurrency(); i++)
+      _threads.emplace_back([this]() {run();});
+  }
+
+  size_t size() const {return _threads.size();}
+
+  void schedule(const std::shared_ptr<detail::Job> &job, size_t helpers)
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      for(size_t i = 0; i < helpers; i++) _jobs.push_back(job);
+    }
+    if(helpers == 1) _wake.notify_one();
+    else _wake.notify_all();
+  }
+};
+
+//never destroyed, the workers wait for jobs until the process ends
+Pool &pool()
+{
+  static Pool *pool = new Pool();
+  return *pool;
+}
+
+}
+
+void setConcurrency(unsigned threads)
+{
+  threadCount = threads;
+}
+
+unsigned concurrency()
+{
+  unsigned n = threadCount;
+  return n > 0 ? n : hardwareConcurrency();
+}
+
+namespace detail {
+
+void Job::work()
+{
+  for(size_t chunk = _next++; chunk < _count; chunk = _next++) {
+    try {
+      _run(chunk);
+    }
+    catch(...) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(!_error) _error = std::current_exception();
+    }
+
+    if(++_finished == _count) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _done.notify_all();
+    }
+  }
+}
+
+void Job::wait()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  _done.wait(lock, [this]() {return _finished == _count;});
+
+  if(_error) std::rethrow_exception(_error);
+}
+
+void schedule(const std::shared_ptr<Job> &job, size_t helpers)
+{
+  Pool &workers = pool();
+
+  helpers = std::min(helpers, workers.size());
+  if(helpers > 0) workers.schedule(job, helpers);
+}
+
+}
+
+}
+}
@@ -0,0 +1,117 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_PARALLEL_H
+#define THREEPP_PARALLEL_H
+
+#include <thread>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include <exception>
+#include <algorithm>
+#include "osdecl.h"
+
+namespace three {
+namespace parallel {
+
+/**
+ * @return the number of hardware threads. At least 1
+ */
+inline unsigned hardwareConcurrency()
+{
+  unsigned n = std::thread::hardware_concurrency();
+  return n > 0 ? n : 1;
+}
+
+/**
+ * set the number of threads used by for_each, e.g. to measure scaling. More threads than the hardware
+ * has only split the work into more chunks. 0 restores hardwareConcurrency()
+ */
+DLX void setConcurrency(unsigned threads);
+
+/**
+ * @return the number of threads used by for_each, including the calling thread. At least 1
+ */
+DLX unsigned concurrency();
+
+namespace detail {
+
+/**
+ * a range of chunks, processed by the calling thread and the pool workers. Each thread takes the next
+ * unprocessed chunk until none is left, so the caller completes the job even if all workers are busy,
+ * e.g. with a for_each that is nesting this one
+ */
+class DLX Job
+{
+  const std::function<void(size_t)> _run;
+  const size_t _count;
+
+  std::atomic<size_t> _next {0};
+  std::atomic<size_t> _finished {0};
+
+  std::mutex _mutex;
+  std::condition_variable _done;
+  std::exception_ptr _error;
+
+public:
+  Job(size_t count, std::function<void(size_t)> run) : _run(run), _count(count) {}
+
+  //process chunks until none is left
+  void work();
+
+  //wait until all chunks are processed, then rethrow the first exception, if any
+  void wait();
+};
+
+/**
+ * hand a job to the worker pool. The pool is started on first use and has hardwareConcurrency() - 1 threads
+ */
+DLX void schedule(const std::shared_ptr<Job> &job, size_t helpers);
+
+}
+
+/**
+ * split the index range [begin, end) into contiguous chunks and process them concurrently on a
+ * persistent worker pool. The calling thread takes part, so for_each may be nested. Ranges smaller
+ * than 2 * grain are processed inline. The first exception thrown by any chunk is rethrown after all
+ * chunks have finished.
+ *
+ * @param func callable taking (size_t chunkBegin, size_t chunkEnd)
+ * @param grain the minimum number of indices per chunk
+ */
+template <typename Func>
+void for_each(size_t begin, size_t end, Func func, size_t grain=1)
+{
+  if(end <= begin) return;
+
+  size_t count = end - begin;
+  size_t chunks = std::min<size_t>(concurrency(), count / std::max<size_t>(grain, 1));
+
+  if(chunks < 2) {
+    func(begin, end);
+    return;
+  }
+
+  size_t chunkSize = (count + chunks - 1) / chunks;
+  chunks = (count + chunkSize - 1) / chunkSize;
+
+  auto job = std::make_shared<detail::Job>(chunks, [&func, begin, end, chunkSize](size_t chunk) {
+    size_t b = begin + chunk * chunkSize;
+    func(b, std::min(end, b + chunkSize));
+  });
+
+  detail::schedule(job, chunks - 1);
+
+  job->work();
+  job->wait();
+}
+
+}
+}
+
+#endif //THREEPP_PARALLEL_H
@@ -58,11 +58,12 @@ class SkinnedMesh;
 class Sprite;
 class ImmediateRenderObject;
 class LensFlare;
+class LOD;
 
 namespace object {
 using Typer = three::Typer<Camera, ArrayCamera, OrthographicCamera, PerspectiveCamera,
    Light, AmbientLight, DirectionalLight, HemisphereLight, PointLight, RectAreaLight, SpotLight, TargetLight,
-   Line, LineSegments, Mesh, DynamicMesh, Sprite, ImmediateRenderObject, Points, SkinnedMesh, LensFlare>;
+   Line, LineSegments, Mesh, DynamicMesh, Sprite, ImmediateRenderObject, Points, SkinnedMesh, LensFlare, LOD>;
 }
 
 class LinearGeometry;
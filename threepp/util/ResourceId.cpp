@@ -0,0 +1,59 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#include "ResourceId.h"
+#include <mutex>
+
+namespace three {
+
+namespace {
+
+struct Slots
+{
+  std::mutex mutex;
+  std::vector<uint32_t> generations;
+  std::vector<uint32_t> free;
+};
+
+//never destroyed, resources may be released during static destruction
+Slots &slots()
+{
+  static Slots *slots = new Slots();
+  return *slots;
+}
+
+}
+
+ResourceKey ResourceId::acquire()
+{
+  Slots &s = slots();
+  std::lock_guard<std::mutex> lock(s.mutex);
+
+  ResourceKey key;
+  if(s.free.empty()) {
+    key.slot = (uint32_t)s.generations.size();
+    s.generations.push_back(0);
+  }
+  else {
+    key.slot = s.free.back();
+    s.free.pop_back();
+  }
+
+  //generation 0 marks unused table entries
+  uint32_t &generation = s.generations[key.slot];
+  if(++generation == 0) ++generation;
+  key.generation = generation;
+
+  return key;
+}
+
+void ResourceId::release(const ResourceKey &key)
+{
+  Slots &s = slots();
+  std::lock_guard<std::mutex> lock(s.mutex);
+
+  s.free.push_back(key.slot);
+}
+
+}
@@ -0,0 +1,139 @@
+//
+// Created by byter on 10/18/18.
+//
+
+#ifndef THREEPP_RESOURCEID_H
+#define THREEPP_RESOURCEID_H
+
+#include <cstdint>
+#include <vector>
+#include <functional>
+#include <stdexcept>
+#include "osdecl.h"
+
+namespace three {
+
+/**
+ * value identifying a resource to renderer side tables. The slot is small and dense, the generation
+ * distinguishes the owners of a recycled slot
+ */
+struct ResourceKey
+{
+  uint32_t slot = 0;
+  uint32_t generation = 0;
+
+  bool operator ==(const ResourceKey &other) const {
+    return slot == other.slot && generation == other.generation;
+  }
+  bool operator !=(const ResourceKey &other) const {
+    return !(*this == other);
+  }
+};
+
+/**
+ * the identity of an object the renderer keeps GPU state for (attributes, textures, materials). Taking
+ * a slot is a locked free list pop, as opposed to the random draws of a uuid. A copy receives its own
+ * identity, the slot is released on destruction
+ */
+class DLX ResourceId
+{
+  ResourceKey _key;
+
+  static ResourceKey acquire();
+  static void release(const ResourceKey &key);
+
+public:
+  ResourceId() : _key(acquire()) {}
+  ResourceId(const ResourceId &) : _key(acquire()) {}
+  ResourceId &operator =(const ResourceId &) = delete;
+
+  ~ResourceId() {release(_key);}
+
+  const ResourceKey &key() const {return _key;}
+
+  operator const ResourceKey &() const {return _key;}
+};
+
+/**
+ * side table indexed by resource slot. An entry left behind by a released identity is not found by
+ * the slot's next owner
+ */
+template <typename T>
+class SlotTable
+{
+  struct Entry
+  {
+    ResourceKey key;
+    T value;
+  };
+  std::vector<Entry> _entries;
+
+public:
+  T *find(const ResourceKey &key)
+  {
+    if(key.slot >= _entries.size() || _entries[key.slot].key != key) return nullptr;
+    return &_entries[key.slot].value;
+  }
+
+  const T *find(const ResourceKey &key) const
+  {
+    return const_cast<SlotTable *>(this)->find(key);
+  }
+
+  size_t count(const ResourceKey &key) const {return find(key) ? 1 : 0;}
+
+  T &at(const ResourceKey &key)
+  {
+    T *value = find(key);
+    if(!value) throw std::out_of_range("no such resource");
+    return *value;
+  }
+
+  const T &at(const ResourceKey &key) const
+  {
+    return const_cast<SlotTable *>(this)->at(key);
+  }
+
+  /**
+   * @return the entry for key, created if required. A stale entry of a previous owner of the slot is
+   * passed to release before it is replaced
+   */
+  T &insert(const ResourceKey &key, const std::function<void(const ResourceKey &, T &)> &release)
+  {
+    if(key.slot >= _entries.size()) _entries.resize(key.slot + 1);
+
+    Entry &entry = _entries[key.slot];
+    if(entry.key != key) {
+      if(entry.key.generation != 0 && release) release(entry.key, entry.value);
+      entry.key = key;
+      entry.value = T();
+    }
+    return entry.value;
+  }
+
+  T &operator[](const ResourceKey &key)
+  {
+    return insert(key, nullptr);
+  }
+
+  void erase(const ResourceKey &key)
+  {
+    if(find(key)) _entries[key.slot] = Entry();
+  }
+
+  void clear() {_entries.clear();}
+};
+
+}
+
+namespace std {
+template<> struct hash<three::ResourceKey>
+{
+  size_t operator()(const three::ResourceKey &key) const noexcept
+  {
+    return std::hash<uint64_t>()((uint64_t)key.generation << 32 | key.slot);
+  }
+};
+}
+
+#endif //THREEPP_RESOURCEID_H
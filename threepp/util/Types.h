@@ -11,6 +11,7 @@
 #include <memory>
 #include <unordered_map>
 #include <type_traits>
+#include <limits>
 #include <threepp/math/Vector2.h>
 #include <threepp/math/Vector3.h>
 
@@ -45,11 +46,26 @@ public:
   }
 
   bool isSet() {return _isSet;}
+
+  void reset() {_isSet = false;}
 };
 
 struct Mipmap {
   std::vector<unsigned char> data;
   int width, height;
+
+  //externally owned pixel data (e.g. a memory-mapped file). If set, used instead of data
+  const unsigned char *external = nullptr;
+  size_t externalSize = 0;
+
+  Mipmap() : width(0), height(0) {}
+
+  Mipmap(int width, int height, const unsigned char *external, size_t externalSize)
+     : width(width), height(height), external(external), externalSize(externalSize) {}
+
+  const unsigned char *bytes() const {return external ? external : data.data();}
+
+  size_t byteCount() const {return external ? externalSize : data.size();}
 };
 
 class TextureData